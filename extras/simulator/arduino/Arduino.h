@@ -0,0 +1,109 @@
+/*
+ * Host (Linux) replacement of the Arduino core used to build the SI4735 library with the SI47XX simulator.
+ *
+ * Only the functions used by the library are available. The time is virtual (see sim_arduino.h):
+ * delay, delayMicroseconds and the I2C transactions advance the clock, so every run is deterministic.
+ */
+#ifndef SIM_ARDUINO_H_INCLUDED
+#define SIM_ARDUINO_H_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+
+#define B00000101 5
+#define B00001011 11
+#define B10000000 128
+
+#define PROGMEM
+#define F(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+#define memcpy_P memcpy
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis();
+unsigned long micros();
+
+inline int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(int interrupt, void (*isr)(void), int mode);
+void detachInterrupt(int interrupt);
+inline void interrupts() {}
+inline void noInterrupts() {}
+
+/**
+ * @brief Minimal Print class (stdout).
+ */
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c)
+    {
+        putchar(c);
+        return 1;
+    }
+    size_t print(const char *s)
+    {
+        size_t n = 0;
+        while (*s)
+            n += write(*s++);
+        return n;
+    }
+    size_t print(char c) { return write(c); }
+    size_t print(unsigned long value, int base = DEC)
+    {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), (base == HEX) ? "%lX" : "%lu", value);
+        return print(buffer);
+    }
+    size_t print(long value, int base = DEC)
+    {
+        if (base == DEC && value < 0)
+            return print('-') + print((unsigned long)-value);
+        return print((unsigned long)value, base);
+    }
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t println() { return write('\n'); }
+    template <typename T>
+    size_t println(T value)
+    {
+        return print(value) + println();
+    }
+    template <typename T>
+    size_t println(T value, int base)
+    {
+        return print(value, base) + println();
+    }
+};
+
+extern Print Serial;
+
+#endif
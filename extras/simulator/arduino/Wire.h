@@ -0,0 +1,44 @@
+/*
+ * Host (Linux) replacement of the Arduino Wire library.
+ *
+ * The transactions are delivered to the simulated devices (see simAttach in sim_arduino.h) and
+ * advance the virtual clock by the time they take on the bus (see setClock).
+ */
+#ifndef SIM_WIRE_H_INCLUDED
+#define SIM_WIRE_H_INCLUDED
+
+#include <Arduino.h>
+
+#define SIM_WIRE_BUFFER_SIZE 32
+
+class TwoWire
+{
+private:
+    uint8_t address = 0;
+    uint8_t txBuffer[SIM_WIRE_BUFFER_SIZE];
+    uint8_t txSize = 0;
+    uint8_t rxBuffer[SIM_WIRE_BUFFER_SIZE];
+    uint8_t rxSize = 0;
+    uint8_t rxPos = 0;
+    uint32_t clock = 100000;
+
+public:
+    void begin() {}
+    void setClock(uint32_t frequency) { clock = frequency; }
+    uint32_t getClock() { return clock; }
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t size);
+    uint8_t endTransmission(bool sendStop = true);
+
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = 1);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    int available() { return rxSize - rxPos; }
+    int read() { return (rxPos < rxSize) ? rxBuffer[rxPos++] : -1; }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ * Host (Linux) Arduino layer: virtual clock, pins, interrupts and the Wire bus.
+ */
+#include <Arduino.h>
+#include <Wire.h>
+#include "sim_arduino.h"
+
+#define SIM_MAX_DEVICES 4
+#define SIM_MAX_PINS 64
+
+static uint64_t now = 0;       // Virtual time (us)
+static uint32_t callCost = 1;  // Time (us) spent by each call to micros or millis
+static SimBusStats busStats;
+
+static struct
+{
+    uint8_t address;
+    SimDevice *device;
+} devices[SIM_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+
+static void (*isrTable[SIM_MAX_PINS])(void);
+static uint8_t pinLevel[SIM_MAX_PINS];
+
+Print Serial;
+TwoWire Wire;
+
+/*
+ * Virtual clock
+ */
+
+uint64_t simNow() { return now; }
+
+void simSetCallCost(uint32_t us) { callCost = us; }
+
+/**
+ * Advances the virtual clock. The events of the devices (CTS, STC, RDS groups etc) happen in time order,
+ * so an interrupt is delivered at the right moment even in the middle of a long delay.
+ */
+void simAdvance(uint64_t us)
+{
+    uint64_t target = now + us;
+    uint64_t next;
+    bool pending = true;
+
+    while (pending)
+    {
+        pending = false;
+        next = SIM_NO_EVENT;
+        for (uint8_t i = 0; i < deviceCount; i++)
+        {
+            uint64_t t = devices[i].device->nextEvent();
+            if (t < next)
+                next = t;
+        }
+        if (next <= target)
+        {
+            if (next > now)
+                now = next;
+            for (uint8_t i = 0; i < deviceCount; i++)
+                devices[i].device->runEvents(now);
+            pending = true;
+        }
+    }
+    now = target;
+}
+
+void delay(unsigned long ms) { simAdvance((uint64_t)ms * 1000); }
+
+void delayMicroseconds(unsigned int us) { simAdvance(us); }
+
+unsigned long micros()
+{
+    simAdvance(callCost);
+    return (unsigned long)now;
+}
+
+unsigned long millis()
+{
+    simAdvance(callCost);
+    return (unsigned long)(now / 1000);
+}
+
+/*
+ * Pins and interrupts
+ */
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (pin < SIM_MAX_PINS)
+        pinLevel[pin] = value;
+    for (uint8_t i = 0; i < deviceCount; i++)
+        devices[i].device->pinWrite(pin, value);
+}
+
+int digitalRead(uint8_t pin) { return (pin < SIM_MAX_PINS) ? pinLevel[pin] : LOW; }
+
+void attachInterrupt(int interrupt, void (*isr)(void), int mode)
+{
+    if (interrupt >= 0 && interrupt < SIM_MAX_PINS)
+        isrTable[interrupt] = isr;
+}
+
+void detachInterrupt(int interrupt)
+{
+    if (interrupt >= 0 && interrupt < SIM_MAX_PINS)
+        isrTable[interrupt] = NULL;
+}
+
+/**
+ * Pulses a pin (falling edge). Calls the ISR attached to it, if any.
+ */
+void simInterrupt(uint8_t pin)
+{
+    if (pin < SIM_MAX_PINS && isrTable[pin] != NULL)
+        isrTable[pin]();
+}
+
+/*
+ * I2C bus
+ */
+
+void simAttach(uint8_t address, SimDevice *device)
+{
+    if (deviceCount < SIM_MAX_DEVICES)
+    {
+        devices[deviceCount].address = address;
+        devices[deviceCount].device = device;
+        deviceCount++;
+    }
+}
+
+void simDetachAll() { deviceCount = 0; }
+
+SimBusStats simBusStats() { return busStats; }
+
+void simResetBusStats() { memset(&busStats, 0, sizeof(busStats)); }
+
+static SimDevice *findDevice(uint8_t address)
+{
+    for (uint8_t i = 0; i < deviceCount; i++)
+        if (devices[i].address == address)
+            return devices[i].device;
+    return NULL;
+}
+
+/**
+ * Time (us) of a transaction: START, address byte, data bytes (9 bits each with ACK) and STOP.
+ */
+static uint64_t busTime(uint32_t clock, uint8_t size)
+{
+    return ((uint64_t)(9 * (size + 1) + 2) * 1000000 + clock - 1) / clock;
+}
+
+static void busTransfer(uint32_t clock, uint8_t size)
+{
+    uint64_t us = busTime(clock, size);
+
+    busStats.transactions++;
+    busStats.busTime += us;
+    simAdvance(us);
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    this->address = address;
+    txSize = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    if (txSize >= SIM_WIRE_BUFFER_SIZE)
+        return 0;
+    txBuffer[txSize++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size)
+{
+    size_t n = 0;
+    while (n < size && write(data[n]))
+        n++;
+    return n;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    SimDevice *device = findDevice(address);
+
+    busTransfer(clock, txSize);
+    if (device == NULL || !device->i2cWrite(txBuffer, txSize))
+    {
+        busStats.nacks++;
+        return 2; // NACK on address
+    }
+    busStats.bytesWritten += txSize;
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+    SimDevice *device = findDevice(address);
+
+    if (quantity > SIM_WIRE_BUFFER_SIZE)
+        quantity = SIM_WIRE_BUFFER_SIZE;
+    rxPos = rxSize = 0;
+    // The device sends the first byte (status) right after the address: its state is sampled there, not at the STOP
+    uint64_t total = busTime(clock, quantity);
+    uint64_t first = busTime(clock, 0) - 1000000 / clock; // START and address byte (no STOP yet)
+    busStats.transactions++;
+    busStats.busTime += total;
+    simAdvance(first);
+    bool ack = device != NULL && device->i2cRead(rxBuffer, quantity);
+    simAdvance(total - first);
+    if (!ack)
+    {
+        busStats.nacks++;
+        return 0;
+    }
+    busStats.bytesRead += quantity;
+    rxSize = quantity;
+    return quantity;
+}
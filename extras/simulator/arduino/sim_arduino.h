@@ -0,0 +1,55 @@
+/*
+ * Simulation control for the host Arduino layer: virtual clock, I2C devices, pins and interrupts.
+ */
+#ifndef SIM_ARDUINO_CONTROL_H_INCLUDED
+#define SIM_ARDUINO_CONTROL_H_INCLUDED
+
+#include <Arduino.h>
+
+#define SIM_NO_EVENT UINT64_MAX
+
+/**
+ * @brief A device connected to the simulated I2C bus and pins.
+ */
+class SimDevice
+{
+public:
+    virtual ~SimDevice() {}
+
+    /** Receives a write transaction. Returns false to NACK it. */
+    virtual bool i2cWrite(const uint8_t *data, uint8_t size) = 0;
+    /** Answers a read transaction. Returns false to NACK it. */
+    virtual bool i2cRead(uint8_t *data, uint8_t size) = 0;
+    /** Called by digitalWrite. */
+    virtual void pinWrite(uint8_t pin, uint8_t value) {}
+    /** Time (us) of the next internal event (SIM_NO_EVENT if none). */
+    virtual uint64_t nextEvent() { return SIM_NO_EVENT; }
+    /** Processes the internal events due at the given time (us). */
+    virtual void runEvents(uint64_t now) {}
+};
+
+/**
+ * @brief I2C bus counters.
+ */
+typedef struct
+{
+    uint32_t transactions; //!< Number of transactions (write or read)
+    uint32_t bytesWritten; //!< Number of bytes written (address not included)
+    uint32_t bytesRead;    //!< Number of bytes read (address not included)
+    uint32_t nacks;        //!< Number of transactions not acknowledged
+    uint64_t busTime;      //!< Time (us) the bus was busy
+} SimBusStats;
+
+void simAttach(uint8_t address, SimDevice *device);
+void simDetachAll();
+
+uint64_t simNow();
+void simAdvance(uint64_t us);
+void simSetCallCost(uint32_t us);
+
+void simInterrupt(uint8_t pin);
+
+SimBusStats simBusStats();
+void simResetBusStats();
+
+#endif
@@ -0,0 +1,1237 @@
+/*
+ * SI4735 library benchmark and regression checks on the SI47XX simulator.
+ *
+ * Every scenario runs against the behavioral model (si47xx_model.h) on a virtual clock. The times
+ * printed are the ones the library would take on a real board with a 100 kHz I2C bus (delays,
+ * bus transfers and device busy times) and do not depend on the host speed.
+ *
+ * Usage: si47xx_bench [-s spectrum_file] [-q]
+ * The exit status is the number of failed checks.
+ */
+#include <SI4735.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "si47xx_model.h"
+
+#define RESET_PIN 12
+#define INT_PIN 2
+
+static Si47xxModel *chip;
+
+// Band plan checked at compile time (see setBandPlan)
+constexpr si47x_band bandPlan[] PROGMEM = {{"LW", SI473X_BAND_AM, 1, 153, 279, 198, 9},
+                                           {"MW", SI473X_BAND_AM, 1, 520, 1710, 810, 10},
+                                           {"40m", SI473X_BAND_LSB, 4, 7000, 7200, 7100, 1},
+                                           {"41m", SI473X_BAND_AM, 1, 7200, 7450, 7300, 5},
+                                           {"FM", SI473X_BAND_FM, 0, 8400, 10800, 10390, 10}};
+constexpr si47x_band badPlan[] PROGMEM = {{"FM", SI473X_BAND_FM, 0, 8400, 10800, 10390, 10},
+                                          {"MW", SI473X_BAND_AM, 1, 520, 1710, 810, 10}}; // FM before AM
+static_assert(SI4735::isValidBandPlan(bandPlan, sizeof(bandPlan) / sizeof(si47x_band)), "invalid band plan");
+static_assert(!SI4735::isValidBandPlan(badPlan, sizeof(badPlan) / sizeof(si47x_band)), "band order not checked");
+static SI4735 polling; // Global like in a sketch: the library expects its members to start zeroed
+static SI4735 interrupt;
+static si47x_property_cache_entry pollingCache[16], interruptCache[16];
+static si47x_snapshot_cache pollingSnapshot, interruptSnapshot;
+static si47x_property_cache_entry pollingModeState[12], interruptModeState[12];
+static si47x_property_batch_entry pollingBatch[20], interruptBatch[20];
+static si47x_error_stats pollingErrors, interruptErrors;
+static si47x_command_timing interruptTiming[SI473X_COMMAND_TIMING_SIZE];
+static int failures = 0;
+static bool quiet = false;
+
+#define CHECK(cond, ...)                        \
+    do                                          \
+    {                                           \
+        if (!(cond))                            \
+        {                                       \
+            failures++;                         \
+            printf("  FAILED %s: ", #cond);     \
+            printf(__VA_ARGS__);                \
+            printf("\n");                       \
+        }                                       \
+    } while (0)
+
+/*
+ * Measurement of a scenario
+ */
+
+typedef struct
+{
+    const char *name;
+    uint64_t start;
+    SimBusStats bus;
+    uint32_t commands;
+} Scenario;
+
+static void begin(Scenario &s, const char *name)
+{
+    s.name = name;
+    s.start = simNow();
+    s.bus = simBusStats();
+    s.commands = chip->commands;
+}
+
+static void end(Scenario &s, uint32_t repeat = 1)
+{
+    SimBusStats bus = simBusStats();
+    uint64_t elapsed = simNow() - s.start;
+
+    printf("%-34s %11.3f %9.3f %7u %7u %6u\n", s.name, elapsed / 1000.0, elapsed / 1000.0 / repeat,
+           (unsigned)(bus.transactions - s.bus.transactions),
+           (unsigned)(bus.bytesWritten + bus.bytesRead - s.bus.bytesWritten - s.bus.bytesRead),
+           (unsigned)(chip->commands - s.commands));
+}
+
+/*
+ * Expected results (from the model)
+ */
+
+static void printStations(const si47x_station *table, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+        printf("  %5u  RSSI %2u  SNR %2u  MULT %2u  PI %04X  \"%s\"\n", table[i].frequency, table[i].rssi, table[i].snr,
+               table[i].multipath, table[i].pi, table[i].ps);
+}
+
+static bool checkStations(const si47x_station *table, uint8_t count, const uint16_t *expected, uint8_t size)
+{
+    if (count != size)
+        return false;
+    for (uint8_t i = 0; i < count; i++)
+        if (table[i].frequency != expected[i])
+            return false;
+    return true;
+}
+
+static uint16_t progressCalls, progressLast;
+
+static void countProgress(uint16_t f)
+{
+    progressCalls++;
+    progressLast = f;
+}
+
+static uint16_t prioritySwitches, priorityLast;
+
+static void countPrioritySwitch(uint16_t f)
+{
+    prioritySwitches++;
+    priorityLast = f;
+}
+
+/**
+ * Runs the priority watch for a while (loop function with 100 us per iteration).
+ */
+static void runPriorityWatch(SI4735 &rx, uint32_t ms)
+{
+    unsigned long start = millis();
+    while (millis() - start < ms)
+    {
+        rx.priorityTick();
+        delayMicroseconds(100);
+    }
+}
+
+static SI4735 *scanReceiver;
+static std::vector<uint8_t> ssbPatch;
+static uint8_t scanStops[16], scanStopCount;
+static bool scanStopMuted;
+
+static void loadScanPatch() { scanReceiver->loadPatch(ssbPatch.data(), (uint16_t)ssbPatch.size(), 2); }
+
+static void countScanStop(uint8_t idx)
+{
+    if (scanStopCount < sizeof(scanStops))
+        scanStops[scanStopCount++] = idx;
+    if (chip->getProperty(RX_HARD_MUTE) != 0)
+        scanStopMuted = true;
+}
+
+/**
+ * SSB times (us) of the polling mode run: the interrupt mode run must not be slower.
+ */
+static uint64_t ssbPolling[3];
+
+/**
+ * Timeouts caused on purpose by a check (not counted as errors at the end of the run).
+ */
+static uint16_t expectedTimeouts;
+
+static uint8_t rsqLastRssi;
+static unsigned long rsqLastAt;
+
+static void countSignalChange(uint8_t rssi, uint8_t snr)
+{
+    rsqLastRssi = rssi;
+    rsqLastAt = millis();
+}
+
+/**
+ * Fading of the S-meter scenarios: -10 dB from 2 to 5 s and -4 dB from 5 to 8 s.
+ */
+static int8_t fadeAt(unsigned long ms) { return (ms < 2000) ? 0 : (ms < 5000) ? -10 : (ms < 8000) ? -4 : 0; }
+
+/**
+ * Runs the signal monitor for a while (loop function with 1 ms per iteration).
+ */
+static void runSignalMonitor(SI4735 &rx, uint32_t ms)
+{
+    unsigned long start = millis();
+    while (millis() - start < ms)
+    {
+        rx.signalMonitorTick();
+        delay(1);
+    }
+}
+
+/**
+ * Runs the memory scan for a while (loop function with 100 us per iteration).
+ */
+static void runScan(SI4735 &rx, uint32_t ms)
+{
+    unsigned long start = millis();
+    while (millis() - start < ms)
+    {
+        rx.scanTick();
+        delayMicroseconds(100);
+    }
+}
+
+static uint16_t expectedSeek(uint8_t band, uint16_t from, uint16_t bottom, uint16_t top, uint16_t spacing)
+{
+    for (uint16_t f = from + spacing; f <= top; f += spacing)
+        if (chip->isValidChannel(band, f))
+            return f;
+    for (uint16_t f = bottom; f <= from; f += spacing)
+        if (chip->isValidChannel(band, f))
+            return f;
+    return from;
+}
+
+static const Si47xxStation *findRdsStation()
+{
+    for (size_t i = 0; i < chip->getStations().size(); i++)
+        if (!chip->getStations()[i].rds.empty())
+            return &chip->getStations()[i];
+    return NULL;
+}
+
+/**
+ * Program Service name sent by a station (group 0A).
+ */
+static void expectedPs(const Si47xxStation *st, char *ps)
+{
+    memset(ps, ' ', 8);
+    ps[8] = '\0';
+    for (size_t i = 0; i < st->rds.size(); i++)
+    {
+        const Si47xxRdsGroup &g = st->rds[i];
+        if ((g.block[1] >> 12) == 0)
+        {
+            ps[(g.block[1] & 3) * 2] = g.block[3] >> 8;
+            ps[(g.block[1] & 3) * 2 + 1] = g.block[3] & 0xFF;
+        }
+    }
+}
+
+/*
+ * Scenarios
+ */
+
+static void runReceiver(SI4735 &rx, const char *mode)
+{
+    Scenario s;
+    char title[64];
+    uint16_t f;
+    bool found;
+
+    expectedTimeouts = 0;
+    printf("\n%s\n", mode);
+    printf("%-34s %11s %9s %7s %7s %6s\n", "scenario", "total(ms)", "each(ms)", "i2c", "bytes", "cmds");
+
+    begin(s, "setup (FM power up)");
+    rx.setup(RESET_PIN, 0);
+    end(s);
+    CHECK(rx.getFirmwarePN() == 35, "PN = %d", rx.getFirmwarePN());
+    // The non-blocking functions need a queue. One command: the next one waits for the device.
+    static si47x_async_command slot[1];
+    CHECK(rx.getCommandQueueSize() == 0, "queue size %u", rx.getCommandQueueSize());
+    rx.setCommandQueue(slot, 1);
+
+    begin(s, "setFM 103.9 MHz");
+    rx.setFM(8400, 10800, 10390, 10);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(f == 10390, "frequency %u", f);
+    rx.getCurrentReceivedSignalQuality();
+    CHECK(rx.getCurrentRSSI() == 48, "RSSI %u", rx.getCurrentRSSI());
+
+    // Property cache: the second write of the same value does not use the I2C bus
+    uint32_t writes;
+    rx.setVolume(40);
+    writes = chip->commandCount[0x12];
+    rx.setVolume(40);
+    CHECK(chip->commandCount[0x12] == writes, "SET_PROPERTY sent again (%u)", chip->commandCount[0x12] - writes);
+
+    // I2C tracer: one entry per command of the engine (nothing without SI473X_TRACE)
+    si47x_trace_entry trace[4];
+    rx.setTraceBuffer(trace, 4);
+    rx.setVolume(41);
+    rx.setVolume(42);
+#ifdef SI473X_TRACE
+    CHECK(rx.getTraceCount() == 2 && rx.getTraceEntry(1).cmd == 0x12 && rx.getTraceEntry(1).property == 0x4000,
+          "trace %u entries, last cmd 0x%02X", rx.getTraceCount(), rx.getTraceEntry(1).cmd);
+#else
+    CHECK(rx.getTraceCount() == 0, "trace %u entries", rx.getTraceCount());
+#endif
+    rx.setTraceBuffer(NULL, 0);
+
+    begin(s, "FM tune x100 (frequencyUp)");
+    for (int i = 0; i < 100; i++)
+        rx.frequencyUp();
+    end(s, 100);
+    f = rx.getFrequency();
+    CHECK(f == 8400 + 10 * (100 - (10800 - 10390) / 10 - 1), "frequency %u", f);
+
+    // Fast encoder: one step every 5 ms. Only the latest frequency is tuned; the time after the last step stays short.
+    uint16_t target;
+    uint64_t lastStep;
+    si47x_tune_state tuneState;
+    rx.setTuneCoalescing(&tuneState);
+    begin(s, "FM encoder x50 coalesced (5 ms/step)");
+    for (int i = 0; i < 50; i++)
+    {
+        rx.frequencyUp();
+        for (uint64_t until = simNow() + 5000; simNow() < until; delayMicroseconds(100))
+            rx.tuneTick();
+    }
+    target = rx.getCurrentFrequency();
+    lastStep = simNow();
+    rx.flushTune();
+    end(s, 50);
+    if (!quiet)
+        printf("  settled %.3f ms after the last step, %u steps skipped\n", (simNow() - lastStep) / 1000.0, rx.getCoalescedTunes());
+    CHECK(chip->getFrequency() == target, "device at %u, requested %u", chip->getFrequency(), target);
+    CHECK(simNow() - lastStep < 2 * chip->timing.fmTune, "settled in %u us", (unsigned)(simNow() - lastStep));
+    // A blocking tune right after a coalesced one waits for the STC of the tune in progress
+    uint32_t violations = chip->violations;
+    rx.requestFrequency(9470);
+    rx.setFrequency(8750);
+    CHECK(chip->violations == violations && chip->getFrequency() == 8750 && rx.getFrequency() == 8750 && !rx.tuneTick(),
+          "%u violations, device at %u, frequency %u", chip->violations - violations, chip->getFrequency(), rx.getFrequency());
+    rx.setTuneCoalescing(NULL);
+
+    begin(s, "FM seek up from 87.5 MHz");
+    rx.seekStationProgress(NULL, 1);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(f == expectedSeek(SI47XX_MODEL_FM, 8750, 8750, 10790, 10), "frequency %u", f);
+
+    // Blocking seek: it checks many channels (far more than the timeout of one timing table entry)
+    si47x_error_stats before = rx.getErrorStats();
+    rx.setFrequency(9470);
+    rx.seekNextStation();
+    f = rx.getFrequency();
+    CHECK(f == expectedSeek(SI47XX_MODEL_FM, 9470, 8750, 10790, 10) && rx.getLastError() == SI473X_OK &&
+              rx.getErrorStats().stcTimeouts == before.stcTimeouts,
+          "seekNextStation: frequency %u, error %u", f, rx.getLastError());
+
+    begin(s, "FM seek up x4");
+    for (int i = 0; i < 4; i++)
+        rx.seekStationProgress(NULL, 1);
+    end(s, 4);
+
+    // Non-blocking seek: the progress is reported while the device searches; CANCEL stops it where it is
+    rx.setFrequency(8750);
+    progressCalls = 0;
+    begin(s, "FM startSeek/seekTick");
+    static si47x_seek_state seek;
+    CHECK(rx.startSeek(&seek, 1, 1, countProgress), "startSeek failed");
+    while (rx.seekTick())
+        delayMicroseconds(500);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(f == expectedSeek(SI47XX_MODEL_FM, 8750, 8750, 10790, 10), "frequency %u", f);
+    CHECK(progressCalls > 1 && progressLast == f, "%u progress calls, last %u", progressCalls, progressLast);
+    rx.setFrequency(8750);
+    rx.startSeek(&seek, 1, 1);
+    for (uint64_t until = simNow() + 150000; simNow() < until; delayMicroseconds(500))
+        rx.seekTick();
+    rx.cancelSeek();
+    f = chip->getFrequency();
+    CHECK(!rx.isSeeking() && f > 8750 && f < expectedSeek(SI47XX_MODEL_FM, 8750, 8750, 10790, 10) && rx.getFrequency() == f,
+          "cancelled at %u", f);
+
+    // Software seek: coarse steps (200 kHz), refined near the candidates, with stricter criteria than the hardware seek
+    rx.setFrequency(8750);
+    si47x_seek_criteria strict = {35, 10, 0, 0, 500};
+    begin(s, "FM softSeek RSSI >= 35 SNR >= 10");
+    found = rx.softSeek(1, 1, NULL, &strict);
+    end(s);
+    f = rx.getFrequency();
+    printf("  %u tunes (%u channels walked)\n", rx.getSoftSeekTunes(), (f - 8750) / 10);
+    CHECK(found && f == 9470, "found %d, frequency %u", found, f);
+    CHECK(rx.getSoftSeekTunes() < (f - 8750) / 10 * 2 / 3, "%u tunes", rx.getSoftSeekTunes());
+    rx.setFrequency(8750);
+    rx.setRdsConfig(1, 3, 3, 3, 3);
+    si47x_seek_criteria rds = {20, 5, 0, 1, 300};
+    begin(s, "FM softSeek RDS station");
+    found = rx.softSeek(1, 1, NULL, &rds);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(found && f == 10390, "found %d, frequency %u", found, f);
+    si47x_seek_criteria none = {90, 10, 0, 0, 500};
+    found = rx.softSeek(1, 1, NULL, &none);
+    f = rx.getFrequency();
+    CHECK(!found && f == 10390, "found %d, frequency %u (no channel: back to the start)", found, f);
+
+    const Si47xxStation *st = findRdsStation();
+    if (st != NULL)
+    {
+        char ps[9], name[9] = "", text[65] = "";
+        char *stationName, *stationInfo, *programInfo, *utcTime;
+        uint64_t until;
+        uint32_t queries = 0;
+
+        rx.setFrequency(st->frequency);
+        rx.setRdsConfig(1, 3, 3, 3, 3);
+        rx.setFifoCount(1);
+        snprintf(title, sizeof(title), "RDS 3 s on %u (getRdsAllData)", st->frequency);
+        begin(s, title);
+        until = simNow() + 3000000;
+        while (simNow() < until)
+        {
+            if (rx.getRdsAllData(&stationName, &stationInfo, &programInfo, &utcTime))
+            {
+                if (stationName != NULL)
+                    strncpy(name, stationName, 8);
+                if (programInfo != NULL)
+                    strncpy(text, programInfo, 64);
+            }
+            queries++;
+            delay(20); // The rest of the sketch loop
+        }
+        end(s, queries);
+        expectedPs(st, ps);
+        CHECK(strcmp(name, ps) == 0, "station name \"%s\" expected \"%s\"", name, ps);
+        if (!quiet)
+            printf("  RDS: \"%s\" \"%.40s\"\n", name, text);
+    }
+
+    begin(s, "property writes x20 + x20 repeated");
+    for (int i = 0; i < 20; i++)
+        rx.setVolume(20 + i);
+    for (int i = 0; i < 20; i++)
+        rx.setVolume(39);
+    end(s, 40);
+    CHECK(chip->getProperty(RX_VOLUME) == 39, "volume %u", chip->getProperty(RX_VOLUME));
+    // Property batch: the pending properties go out before any other command
+    rx.beginProperties();
+    rx.setVolume(30);
+    rx.getStatus();
+    CHECK(chip->getProperty(RX_VOLUME) == 30 && rx.isPropertyBatchActive() && rx.getPendingProperties() == 0,
+          "batch before GET_INT_STATUS: volume %u, active %d, %u pending", chip->getProperty(RX_VOLUME),
+          rx.isPropertyBatchActive(), rx.getPendingProperties());
+    rx.setVolume(39);
+    rx.commitProperties();
+    CHECK(chip->getProperty(RX_VOLUME) == 39, "volume %u", chip->getProperty(RX_VOLUME));
+
+    // Autostore: hardware seek from the bottom of the band; the weakest station (100.3 MHz) does not fit in the table
+    static si47x_station presets[8];
+    static const uint16_t fmPresets[] = {8830, 9470, 10390, 10650};
+    begin(s, "FM autostore (4 presets, RDS)");
+    static si47x_autostore_state bandScan;
+    rx.startAutostore(&bandScan, presets, 4, 600); // The PS takes 4 groups (about 400 ms)
+    while (rx.autostoreTick(1000))
+        delayMicroseconds(500);
+    end(s);
+    printStations(presets, rx.getAutostoreCount());
+    CHECK(checkStations(presets, rx.getAutostoreCount(), fmPresets, 4), "%u stations", rx.getAutostoreCount());
+    CHECK(presets[2].pi == 0x2C1B && strcmp(presets[2].ps, "SIMRADIO") == 0, "PI %04X PS \"%s\"", presets[2].pi, presets[2].ps);
+    CHECK(rx.getFrequency() == 10390, "frequency %u", rx.getFrequency());
+
+    // Priority channel: a weak one (91.5 MHz) is checked and left 3 times; a strong one (94.7 MHz) takes the receiver
+    // and leaves it when the criteria go above its signal. Baseline: the same check with setFrequency.
+    begin(s, "priority check by hand (setFrequency)");
+    rx.setAudioMute(true);
+    rx.setFrequency(9150);
+    rx.getCurrentReceivedSignalQuality();
+    rx.setFrequency(10390);
+    rx.setAudioMute(false);
+    end(s);
+    uint64_t manualGap = simNow() - s.start;
+    prioritySwitches = 0;
+    static si47x_priority_state watch;
+    rx.setPriorityCriteria(&watch, 25, 8);
+    rx.startPriorityWatch(&watch, 9150, 2000, countPrioritySwitch);
+    begin(s, "priority watch 91.5 MHz 6.5 s");
+    runPriorityWatch(rx, 6500);
+    end(s);
+    CHECK(prioritySwitches == 0 && !rx.isOnPriority() && rx.getFrequency() == 10390 && chip->getFrequency() == 10390,
+          "%u switches, frequency %u", prioritySwitches, chip->getFrequency());
+    // In interrupt mode, setFrequency reads no status after the STC either: the watch has only to keep up with it
+    CHECK(rx.getPriorityGap() > 0 && rx.getPriorityGap() < manualGap + (rx.isInterruptMode() ? manualGap / 20 : 0),
+          "gap %.3f ms, by hand %.3f ms", rx.getPriorityGap() / 1000.0, manualGap / 1000.0);
+    if (!quiet)
+        printf("  audio gap %.3f ms (by hand %.3f ms)\n", rx.getPriorityGap() / 1000.0, manualGap / 1000.0);
+    rx.startPriorityWatch(&watch, 9470, 2000, countPrioritySwitch);
+    runPriorityWatch(rx, 2500);
+    CHECK(prioritySwitches == 1 && priorityLast == 9470 && rx.isOnPriority() && chip->getFrequency() == 9470,
+          "%u switches, frequency %u", prioritySwitches, chip->getFrequency());
+    rx.setPriorityCriteria(&watch, 45, 8);
+    runPriorityWatch(rx, 2000);
+    CHECK(prioritySwitches == 2 && priorityLast == 10390 && !rx.isOnPriority() && rx.getFrequency() == 10390 &&
+              chip->getFrequency() == 10390,
+          "%u switches, frequency %u", prioritySwitches, chip->getFrequency());
+    CHECK(chip->getProperty(RX_HARD_MUTE) == 0, "RX_HARD_MUTE %u", chip->getProperty(RX_HARD_MUTE));
+    rx.setAudioMute(true); // Muted by the user: the checks have to leave it muted
+    runPriorityWatch(rx, 2500);
+    CHECK(prioritySwitches == 2 && chip->getProperty(RX_HARD_MUTE) == 3, "%u switches, RX_HARD_MUTE %u", prioritySwitches,
+          chip->getProperty(RX_HARD_MUTE));
+    rx.setAudioMute(false);
+    rx.stopPriorityWatch();
+
+    begin(s, "band switch FM -> AM 810 kHz");
+    rx.setAM(520, 1710, 810, 10);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(f == 810, "frequency %u", f);
+
+    begin(s, "AM tune x50 (frequencyUp)");
+    for (int i = 0; i < 50; i++)
+        rx.frequencyUp();
+    end(s, 50);
+
+    rx.setFrequency(810);
+    begin(s, "AM seek up from 810 kHz");
+    rx.seekStationProgress(NULL, 1);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(f == expectedSeek(SI47XX_MODEL_AM, 810, 520, 1710, 10), "frequency %u", f);
+
+    static const uint16_t mwPresets[] = {570, 810, 1090};
+    begin(s, "MW autostore");
+    found = rx.autostore(presets, 8) == 3;
+    end(s);
+    printStations(presets, rx.getAutostoreCount());
+    CHECK(found && checkStations(presets, 3, mwPresets, 3), "%u stations", rx.getAutostoreCount());
+    CHECK(rx.getFrequency() == f, "frequency %u", rx.getFrequency());
+    // maxSeekTime shorter than the gaps between the stations: the scan goes on from where each seek stopped. The seek
+    // limits and spacing set before are restored.
+    rx.setSeekAmLimits(600, 1500);
+    rx.setSeekAmSpacing(5);
+    rx.setMaxSeekTime(500);
+    uint16_t stcTimeouts = rx.getErrorStats().stcTimeouts;
+    found = rx.autostore(presets, 8) == 3;
+    rx.setMaxSeekTime(MAX_SEEK_TIME);
+    expectedTimeouts += rx.getErrorStats().stcTimeouts - stcTimeouts;
+    CHECK(found && checkStations(presets, 3, mwPresets, 3) && rx.getErrorStats().stcTimeouts > stcTimeouts,
+          "%u stations with seek timeouts (%u)", rx.getAutostoreCount(), rx.getErrorStats().stcTimeouts - stcTimeouts);
+    CHECK(chip->getProperty(AM_SEEK_BAND_BOTTOM) == 600 && chip->getProperty(AM_SEEK_BAND_TOP) == 1500 &&
+              chip->getProperty(AM_SEEK_FREQ_SPACING) == 5,
+          "seek limits %u-%u, spacing %u", chip->getProperty(AM_SEEK_BAND_BOTTOM), chip->getProperty(AM_SEEK_BAND_TOP),
+          chip->getProperty(AM_SEEK_FREQ_SPACING));
+    rx.setSeekAmLimits(520, 1710);
+    rx.setSeekAmSpacing(10);
+
+    // Bandscope: 200 MW points (520 to 1515 kHz, 5 kHz) with a setFrequency loop and with the FAST sweep
+    static si47x_sweep_point scope[200];
+    uint16_t current = rx.getFrequency();
+    uint64_t loopTime, sweepTime;
+    begin(s, "MW scope 200 points (setFrequency)");
+    for (int i = 0; i < 200; i++)
+    {
+        rx.setFrequency(520 + i * 5);
+        rx.getCurrentReceivedSignalQuality();
+    }
+    end(s, 200);
+    loopTime = simNow() - s.start;
+    rx.setFrequency(current);
+    begin(s, "MW scope 200 points (sweep)");
+    uint16_t points = rx.sweep(520, 1515, 5, scope, 200);
+    end(s, 200);
+    sweepTime = simNow() - s.start;
+    CHECK(points == 200, "%u points", points);
+    CHECK(scope[(810 - 520) / 5].rssi == 52 && scope[(810 - 520) / 5].snr == 32, "810 kHz: RSSI %u SNR %u",
+          scope[(810 - 520) / 5].rssi, scope[(810 - 520) / 5].snr);
+    CHECK(chip->getFrequency() == current, "device at %u after the sweep, expected %u", chip->getFrequency(), current);
+    CHECK(sweepTime < loopTime + (rx.isInterruptMode() ? loopTime / 20 : 0), "sweep %.3f ms, loop %.3f ms",
+          sweepTime / 1000.0, loopTime / 1000.0); // See the priority gap check
+    // Today's examples: setFrequency with the fixed MAX_DELAY_AFTER_SET_FREQUENCY settle time per point
+    CHECK(sweepTime * 3 < 200ull * MAX_DELAY_AFTER_SET_FREQUENCY * 1000, "sweep %.3f ms", sweepTime / 1000.0);
+    // Non-blocking sweep: the loop goes on (display etc); sweepTick only spends the I2C transfers. A queue of four
+    // commands lets the RSQ_STATUS wait behind the STC acknowledge.
+    static si47x_async_command queue[4];
+    si47x_sweep_state sweepState;
+    uint64_t busy = 0;
+    rx.setCommandQueue(queue, 4);
+    rx.startSweep(&sweepState, 520, 1515, 5, scope, 200);
+    begin(s, "MW scope 200 points (sweepTick)");
+    while (rx.isSweeping())
+    {
+        uint64_t t = simNow();
+        rx.sweepTick();
+        busy += simNow() - t;
+        delayMicroseconds(100);
+    }
+    end(s, 200);
+    CHECK(rx.getSweepCount() == 200 && busy * 2 < simNow() - s.start, "%u points, sweepTick busy %.3f of %.3f ms",
+          rx.getSweepCount(), busy / 1000.0, (simNow() - s.start) / 1000.0);
+    rx.setCommandQueue(NULL, 0);
+    CHECK(!rx.startSweep(&sweepState, 520, 1515, 5, scope, 200) && rx.getLastError() == SI473X_ERROR_QUEUE_FULL,
+          "sweep started without a queue");
+    CHECK(rx.sweep(520, 530, 5, scope, 200) == 3 && rx.getCommandQueueSize() == 0, "blocking sweep without a queue");
+    rx.setCommandQueue(slot, 1);
+    if (!quiet)
+        printf("  sweep takes %.0f%% of the setFrequency loop; sweepTick busy %.0f%% of the loop time\n",
+               100.0 * sweepTime / loopTime, 100.0 * busy / (simNow() - s.start));
+
+    // Antenna capacitor: the automatic value is 200 units above the best one for this (simulated) loop antenna
+    static si47x_antcap_segment mwCaps[12];
+    uint8_t rssiAuto, rssiTable;
+    chip->antcapError = -200;
+    chip->antcapWidth = 20;
+    rx.setTuneFrequencyAntennaCapacitor(0);
+    rx.setFrequency(810);
+    rx.getCurrentReceivedSignalQuality();
+    rssiAuto = rx.getCurrentRSSI();
+    begin(s, "MW antenna capacitor table 12 segments");
+    found = rx.buildAntennaCapacitorTable(mwCaps, 12, 520, 1710) == 12;
+    end(s);
+    CHECK(rx.getFrequency() == 810, "tuned to %u kHz after building the table", rx.getFrequency());
+    uint16_t bestCap = rx.findBestAntennaCapacitor(810);
+    rx.getStatus(0, 0);
+    CHECK(rx.getAntennaTuningCapacitor() == bestCap, "capacitor %u after the search, best %u",
+          rx.getAntennaTuningCapacitor(), bestCap);
+    rx.setFrequency(810);
+    rx.getCurrentReceivedSignalQuality();
+    rssiTable = rx.getCurrentRSSI();
+    int16_t capError = (int16_t)rx.lookupAntennaCapacitor(810) - (chip->getAutoAntcap(SI47XX_MODEL_AM, 810) - 200);
+    CHECK(found && rssiTable >= 50 && rssiAuto < rssiTable, "810 kHz: RSSI %u automatic, %u with the table", rssiAuto,
+          rssiTable);
+    CHECK(capError >= -40 && capError <= 40, "810 kHz capacitor %d units from the best", capError);
+    // Out of the MW table: LW is automatic; SW does not use the capacitor
+    CHECK(rx.lookupAntennaCapacitor(198) == 0 && rx.lookupAntennaCapacitor(6000) == 1, "LW capacitor %u, SW %u",
+          rx.lookupAntennaCapacitor(198), rx.lookupAntennaCapacitor(6000));
+    if (!quiet)
+        printf("  810 kHz: RSSI %u dBuV automatic, %u dBuV with the table\n", rssiAuto, rssiTable);
+    rx.setAntennaCapacitorTable(NULL, 0);
+    chip->antcapError = 0;
+    rx.setFrequency(current);
+
+    // Encoder spin over the 49 m band (5 kHz grid): 11 detents 20 ms apart reach the top of the band,
+    // then three slow detents down use the 5 kHz step
+    uint32_t tunes = chip->commandCount[AM_TUNE_FREQ];
+    uint32_t ms = (uint32_t)(simNow() / 1000);
+    si47x_encoder_state encoderState;
+    rx.setAM(5800, 6300, 5800, 5);
+    rx.setTuneCoalescing(&tuneState);
+    rx.setEncoderAcceleration(&encoderState);
+    begin(s, "SW encoder spin 11 detents + 3 slow");
+    for (int i = 0; i < 11; i++)
+    {
+        ms += 20;
+        rx.encoderTune(1, ms);
+        for (uint64_t until = (uint64_t)ms * 1000 + 20000; simNow() < until; delayMicroseconds(100))
+            rx.tuneTick();
+    }
+    f = rx.getCurrentFrequency();
+    CHECK(f == 6300, "spin stopped at %u", f);
+    for (int i = 0; i < 3; i++)
+    {
+        ms += 300;
+        rx.encoderTune(-1, ms);
+        delay(300);
+        rx.tuneTick();
+    }
+    rx.flushTune();
+    end(s, 14);
+    rx.setTuneCoalescing(NULL);
+    if (!quiet)
+        printf("  %u tunes, last step %u kHz\n", (unsigned)(chip->commandCount[AM_TUNE_FREQ] - tunes - 1), rx.getEncoderStep());
+    CHECK(chip->getFrequency() == 6285, "device at %u", chip->getFrequency());
+    rx.setEncoderAcceleration(NULL);
+
+    // Synthetic patch: the model accepts any content made of 8 bytes lines starting with 0x15 or 0x16.
+    std::vector<uint8_t> patch;
+    for (int line = 0; line < 200; line++)
+    {
+        patch.push_back((line == 0 || line == 199) ? 0x15 : 0x16);
+        for (int i = 1; i < 8; i++)
+            patch.push_back((uint8_t)(line * 7 + i));
+    }
+    begin(s, "SSB patch download (200 lines)");
+    rx.loadPatch(patch.data(), (uint16_t)patch.size(), 2);
+    end(s);
+    CHECK(chip->patchLines == 200, "patch lines %u", chip->patchLines);
+
+    CHECK(chip->isGpo2Enabled() == rx.isInterruptMode() && chip->isCtsInterruptEnabled() == rx.isInterruptMode(),
+          "patch power up: GPO2 %d, CTS interrupt %d", chip->isGpo2Enabled(), chip->isCtsInterruptEnabled());
+
+    uint64_t ssbTimes[3];
+    begin(s, "setSSB 7100 kHz LSB");
+    rx.setSSB(7000, 7300, 7100, 1, 1);
+    end(s);
+    ssbTimes[0] = simNow() - s.start;
+    f = rx.getFrequency();
+    CHECK(chip->isPatched(), "the patch was not applied");
+    CHECK(f == 7100, "frequency %u", f);
+
+    // Hz tuning: 7100.000 to 7101.000 kHz in 10 Hz steps moves just the BFO; a 20 kHz jump tunes the carrier again
+    uint32_t tunesBefore = chip->commandCount[AM_TUNE_FREQ];
+    uint32_t propertiesBefore = chip->commandCount[SET_PROPERTY];
+    begin(s, "SSB setFrequencyHz x100 (10 Hz steps)");
+    for (int i = 1; i <= 100; i++)
+        rx.setFrequencyHz(7100000 + i * 10);
+    end(s, 100);
+    uint64_t bfoTime = simNow() - s.start;
+    CHECK(chip->commandCount[AM_TUNE_FREQ] == tunesBefore && chip->commandCount[SET_PROPERTY] - propertiesBefore == 100 &&
+              rx.getFrequencyHz() == 7101000 && (int16_t)chip->getProperty(SSB_BFO) == -1000,
+          "%u tunes, BFO %d, frequency %u Hz", chip->commandCount[AM_TUNE_FREQ] - tunesBefore,
+          (int16_t)chip->getProperty(SSB_BFO), rx.getFrequencyHz());
+    rx.setFrequencyHz(7121230);
+    CHECK(chip->getFrequency() == 7121 && (int16_t)chip->getProperty(SSB_BFO) == -230 && rx.getFrequencyHz() == 7121230,
+          "carrier %u kHz, BFO %d", chip->getFrequency(), (int16_t)chip->getProperty(SSB_BFO));
+    begin(s, "SSB setFrequency x10 (1 kHz steps)");
+    for (int i = 1; i <= 10; i++)
+        rx.setFrequency(7121 + i);
+    end(s, 10);
+    CHECK(bfoTime / 100 < (simNow() - s.start) / 10, "BFO step %.3f ms, tune step %.3f ms", bfoTime / 100000.0,
+          (simNow() - s.start) / 10000.0);
+    ssbTimes[1] = bfoTime;
+    ssbTimes[2] = simNow() - s.start;
+    // The patch power up keeps the GPO2/INT output: the CTS and STC of the SSB commands come by interrupt. A BFO step
+    // is just a SET_PROPERTY: its CTS pulse comes a little later than the first poll of the polling mode.
+    if (!rx.isInterruptMode())
+        memcpy(ssbPolling, ssbTimes, sizeof(ssbTimes));
+    else
+        CHECK(ssbTimes[0] <= ssbPolling[0] && ssbTimes[1] <= ssbPolling[1] * 11 / 10 && ssbTimes[2] <= ssbPolling[2],
+              "setSSB %.3f ms, BFO step %.3f ms, tune step %.3f ms (polling mode %.3f, %.3f and %.3f ms)",
+              ssbTimes[0] / 1000.0, ssbTimes[1] / 100000.0, ssbTimes[2] / 10000.0, ssbPolling[0] / 1000.0,
+              ssbPolling[1] / 100000.0, ssbPolling[2] / 10000.0);
+    // A BFO change drops the signal snapshot of the channel
+    rx.getSignalSnapshot();
+    uint32_t snapshotReads = rx.getSnapshotReads();
+    rx.setSSBBfo(0);
+    rx.getSignalSnapshot();
+    CHECK(rx.getSnapshotReads() == snapshotReads + 1, "BFO change: %u snapshot readings", rx.getSnapshotReads() - snapshotReads);
+    rx.setSsbAgcAttackRate(8);
+
+    // No hardware seek on SSB: software seek with 1 kHz resolution (4 kHz coarse steps)
+    rx.setFrequency(7050);
+    static si47x_soft_seek_state ssbSeek;
+    rx.setSoftSeekCriteria(&ssbSeek, 20, 6);
+    begin(s, "SSB softSeek from 7050 kHz");
+    rx.startSoftSeek(&ssbSeek, 1);
+    while (rx.softSeekTick())
+        ;
+    found = rx.getSoftSeekFound();
+    end(s);
+    f = rx.getFrequency();
+    printf("  %u tunes (%u channels walked)\n", rx.getSoftSeekTunes(), f - 7050);
+    CHECK(found && f == 7100 && chip->getFrequency() == 7100, "found %d, frequency %u", found, f);
+    CHECK(rx.getSoftSeekTunes() < f - 7050, "%u tunes", rx.getSoftSeekTunes());
+
+    begin(s, "SSB autostore (software seek)");
+    found = rx.autostore(presets, 8) == 1;
+    end(s);
+    printStations(presets, rx.getAutostoreCount());
+    CHECK(found && presets[0].frequency == 7100 && rx.getFrequency() == 7100, "%u stations", rx.getAutostoreCount());
+
+    begin(s, "band switch SSB -> FM 103.9 MHz");
+    rx.setFM(8400, 10800, 10390, 10);
+    end(s);
+    f = rx.getFrequency();
+    CHECK(f == 10390, "frequency %u", f);
+    // The properties written on SSB are restored on SSB only (0x3700 and 0x3701 exist just on the patch)
+    uint32_t errors = chip->errors;
+    rx.setAM(520, 1710, 810, 10);
+    CHECK(chip->errors == errors && rx.getModeStateCount(SSB_CURRENT_MODE) == 1, "%u errors on AM, %u SSB properties kept",
+          chip->errors - errors, rx.getModeStateCount(SSB_CURRENT_MODE));
+    rx.loadPatch(patch.data(), (uint16_t)patch.size(), 2);
+    rx.setSSB(7000, 7300, 7100, 1, 1);
+    CHECK(chip->getProperty(SSB_RF_AGC_ATTACK_RATE) == 8, "SSB_RF_AGC_ATTACK_RATE %u",
+          chip->getProperty(SSB_RF_AGC_ATTACK_RATE));
+    rx.setFM(8400, 10800, 10390, 10);
+
+    // NBFM patch (the model has no NBFM receiver): the patch power up keeps the GPO2/INT output as well
+    rx.loadPatchNBFM(patch.data(), (uint16_t)patch.size());
+    CHECK(chip->patchLines == 200 && chip->isGpo2Enabled() == rx.isInterruptMode() &&
+              chip->isCtsInterruptEnabled() == rx.isInterruptMode(),
+          "NBFM patch power up: %u lines, GPO2 %d, CTS interrupt %d", chip->patchLines, chip->isGpo2Enabled(),
+          chip->isCtsInterruptEnabled());
+    // The power down discards the pending properties
+    rx.beginProperties();
+    rx.setVolume(20);
+    uint32_t setProperties = chip->commandCount[SET_PROPERTY];
+    rx.powerDown();
+    CHECK(chip->commandCount[SET_PROPERTY] == setProperties && rx.getPendingProperties() == 0 && chip->errors == 0,
+          "power down: %u properties sent, %u pending, %u errors", (unsigned)(chip->commandCount[SET_PROPERTY] - setProperties),
+          rx.getPendingProperties(), chip->errors);
+    rx.commitProperties();
+    rx.setFM(8400, 10800, 10390, 10);
+
+    // Band plan: FM (the same band twice), then MW and 41m
+    CHECK(rx.setBandPlan(bandPlan, sizeof(bandPlan) / sizeof(si47x_band)), "band plan rejected");
+    CHECK(!rx.setBandPlan(badPlan, sizeof(badPlan) / sizeof(si47x_band)), "bad band plan accepted");
+    CHECK(rx.findBand(6000) == SI473X_BAND_NONE && rx.findBand(9390) == SI473X_BAND_NONE && rx.findBand(7200) == 3 &&
+              rx.findBand(7100) == 2 && rx.findBand(9390, true) == 4 && rx.findBand(11000, true) == SI473X_BAND_NONE,
+          "findBand");
+    uint8_t band = rx.tuneBand(10390, true);
+    CHECK(band == 4 && rx.getCurrentBand() == 4 && chip->getProperty(FM_SEEK_BAND_BOTTOM) == 8400, "band %u", band);
+    uint32_t powerUps = chip->commandCount[POWER_UP];
+    begin(s, "band plan tune 93.9 MHz (same band)");
+    band = rx.tuneBand(9390, true);
+    end(s);
+    CHECK(band == 4 && rx.getFrequency() == 9390 && chip->commandCount[POWER_UP] == powerUps, "band %u, frequency %u",
+          band, rx.getFrequency());
+    begin(s, "band plan tune 810 kHz (MW)");
+    band = rx.tuneBand(810);
+    end(s);
+    CHECK(band == 1 && rx.getCurrentBand() == 1 && rx.isCurrentTuneAM() && rx.getFrequency() == 810 &&
+              chip->getProperty(AM_SEEK_FREQ_SPACING) == 10,
+          "band %u, frequency %u", band, rx.getFrequency());
+    CHECK(rx.tuneBand(7300) == 3 && rx.getFrequency() == 7300 && chip->getProperty(AM_SEEK_FREQ_SPACING) == 5,
+          "frequency %u", rx.getFrequency());
+    CHECK(rx.tuneBand(6000) == SI473X_BAND_NONE && rx.getFrequency() == 7300, "frequency %u", rx.getFrequency());
+    rx.setAM(520, 1710, 810, 10);
+    CHECK(rx.getCurrentBand() == SI473X_BAND_NONE, "band %u after setAM", rx.getCurrentBand());
+    rx.setBandPlan(NULL, 0);
+
+    // Mode switch: band menu FM -> FM (76-90 MHz) -> MW -> FM. Baseline: like the sketches written for the previous
+    // setFM (a power cycle on every call, emulated by powerDown), the settings are set again after each band change.
+    rx.clearModeState();
+    begin(s, "band menu FM-FM-MW-FM + settings by hand");
+    for (int i = 0; i < 4; i++)
+    {
+        if (i == 2)
+        {
+            rx.setAM(520, 1710, 810, 10);
+            rx.setBandwidth(1, 1);
+            rx.setAmSoftMuteMaxAttenuation(4);
+            rx.setAutomaticGainControl(1, 20);
+            continue;
+        }
+        rx.powerDown();
+        if (i == 1)
+            rx.setFM(7600, 9000, 8000, 10);
+        else
+            rx.setFM(8400, 10800, 10390, 10);
+        rx.setFmBandwidth(2);
+        rx.setFMDeEmphasis(1);
+        rx.setFmSoftMuteMaxAttenuation(4);
+        rx.setRdsConfig(1, 3, 3, 3, 3);
+        rx.setAutomaticGainControl(1, 12);
+    }
+    end(s, 4);
+    uint64_t manualTime = simNow() - s.start;
+    begin(s, "band menu FM-FM-MW-FM (restored)");
+    rx.setFM(8400, 10800, 10390, 10);
+    rx.setFM(7600, 9000, 8000, 10);
+    rx.setAM(520, 1710, 810, 10);
+    rx.setFM(8400, 10800, 10390, 10);
+    end(s, 4);
+    uint64_t restoreTime = simNow() - s.start;
+    rx.getAutomaticGainControl();
+    CHECK(chip->getProperty(FM_CHANNEL_FILTER) == 2 && chip->getProperty(FM_DEEMPHASIS) == 1 &&
+              chip->getProperty(FM_SOFT_MUTE_MAX_ATTENUATION) == 4 && chip->getProperty(FM_RDS_CONFIG) == 0xFF01 &&
+              !rx.isAgcEnabled() && rx.getAgcGainIndex() == 12,
+          "FM settings lost (%u FM properties kept)", rx.getModeStateCount(FM_CURRENT_MODE));
+    rx.setAM(520, 1710, 810, 10);
+    rx.getAutomaticGainControl();
+    CHECK((chip->getProperty(AM_CHANNEL_FILTER) & 0xF) == 1 && chip->getProperty(AM_SOFT_MUTE_MAX_ATTENUATION) == 4 &&
+              !rx.isAgcEnabled() && rx.getAgcGainIndex() == 20,
+          "AM settings lost (%u AM properties kept)", rx.getModeStateCount(AM_CURRENT_MODE));
+    CHECK(restoreTime < manualTime, "restored %.3f ms, by hand %.3f ms", restoreTime / 1000.0, manualTime / 1000.0);
+    powerUps = chip->commandCount[POWER_UP];
+    rx.setAM(520, 1710, 1000, 10);
+    CHECK(chip->commandCount[POWER_UP] == powerUps && rx.getFrequency() == 1000, "setAM on AM powered up the device");
+    rx.setFM(8400, 10800, 10390, 10);
+    powerUps = chip->commandCount[POWER_UP];
+    rx.setFM(8400, 10800, 10570, 10);
+    CHECK(chip->commandCount[POWER_UP] == powerUps && rx.getModeSwitchTime() < 1000, "setFM on FM: %u us",
+          rx.getModeSwitchTime());
+    if (!quiet)
+        printf("  band menu %.0f%% of the one with the settings by hand; setFM on FM %u us\n",
+               100.0 * restoreTime / manualTime, rx.getModeSwitchTime());
+    rx.setAutomaticGainControl(0, 0);
+    rx.clearModeState();
+    rx.setAM(520, 1710, 810, 10);
+
+    // Memory scan: mixed FM/AM/SSB list. Baseline: the channels in the list order, a mode switch for each change.
+    static const si47x_memory_channel memories[] = {
+        {10390, SI473X_BAND_FM}, {810, SI473X_BAND_AM}, {9470, SI473X_BAND_FM}, {7100, SI473X_BAND_LSB},
+        {1090, SI473X_BAND_AM},  {9990, SI473X_BAND_FM}, {570, SI473X_BAND_AM}, {8830, SI473X_BAND_FM},
+        {1470, SI473X_BAND_AM},  {7150, SI473X_BAND_USB}};
+    const uint8_t memoryCount = sizeof(memories) / sizeof(si47x_memory_channel);
+    ssbPatch = patch;
+    scanReceiver = &rx;
+    powerUps = chip->commandCount[POWER_UP];
+    uint8_t active = 0;
+    begin(s, "memory scan by hand (10 channels)");
+    for (uint8_t i = 0; i < memoryCount; i++)
+    {
+        const si47x_memory_channel &m = memories[i];
+        if (m.mode == SI473X_BAND_FM)
+            rx.setFM(8400, 10800, m.frequency, 10);
+        else if (m.mode == SI473X_BAND_AM)
+            rx.setAM(520, 1710, m.frequency, 10);
+        else
+        {
+            loadScanPatch();
+            rx.setSSB(7000, 7300, m.frequency, 1, m.mode - 1);
+        }
+        rx.getCurrentReceivedSignalQuality(0);
+        if (rx.getCurrentRSSI() >= 25 && rx.getCurrentSNR() >= 8)
+            active++;
+    }
+    end(s, memoryCount);
+    uint64_t manualScan = simNow() - s.start;
+    uint32_t manualPowerUps = chip->commandCount[POWER_UP] - powerUps;
+    CHECK(active == 7, "%u active channels by hand", active);
+
+    rx.setAM(520, 1710, 810, 10);
+    static si47x_scan_state scan;
+    rx.setScanCriteria(&scan, 25, 8);
+    rx.setScanTimes(&scan, 300, 0);
+    rx.setScanSsbLoader(loadScanPatch);
+    scanStopCount = 0;
+    scanStopMuted = false;
+    powerUps = chip->commandCount[POWER_UP];
+    CHECK(!rx.startScan(&scan, memories, 0) && rx.getLastError() == SI473X_ERROR_INVALID_ARG, "empty list accepted");
+    CHECK(rx.startScan(&scan, memories, memoryCount, countScanStop), "list rejected");
+    rx.clearScanLockout();
+    rx.setScanLockout(4, true); // 1090 kHz
+    begin(s, "memory scan one pass (grouped)");
+    while (rx.getScanCount() < memoryCount - 1) // 88.3 MHz (active) is the last channel of the pass
+    {
+        rx.scanTick();
+        delayMicroseconds(100);
+    }
+    end(s);
+    static const uint8_t expectedStops[] = {1, 6, 3, 0, 2, 7}; // AM, SSB and FM groups; 1090 kHz locked out
+    CHECK(scanStopCount == 6 && memcmp(scanStops, expectedStops, 6) == 0 && !scanStopMuted, "%u stops (first %u)%s",
+          scanStopCount, scanStops[0], scanStopMuted ? ", audio muted on a stop" : "");
+    // AM -> SSB: library ID query, patch power up and setSSB; SSB -> FM: setFM
+    CHECK(rx.getScanSwitches() == 2 && chip->commandCount[POWER_UP] - powerUps == 4,
+          "%u mode switches, %u power ups", rx.getScanSwitches(), chip->commandCount[POWER_UP] - powerUps);
+    uint16_t manualRate = (uint16_t)((uint64_t)memoryCount * 1000000 / manualScan);
+    CHECK(rx.getScanRate() > manualRate, "%u channels/s, by hand %u", rx.getScanRate(), manualRate);
+    if (!quiet)
+        printf("  %u channels/s (%u power ups), by hand %u channels/s (%u power ups)\n", rx.getScanRate(),
+               chip->commandCount[POWER_UP] - powerUps, manualRate, manualPowerUps);
+
+    // Hang: with no dwell limit, the scan stays on 88.3 MHz until the signal is gone for 500 ms
+    rx.setScanTimes(&scan, 0, 500);
+    runScan(rx, 2000);
+    CHECK(rx.isScanStopped() && rx.getScanChannel() == 7 && chip->getFrequency() == 8830, "channel %u, frequency %u",
+          rx.getScanChannel(), chip->getFrequency());
+    chip->antcapError = 400; // About 50 dB lost
+    unsigned long lostAt = millis();
+    while (rx.isScanStopped() && millis() - lostAt < 2000)
+    {
+        rx.scanTick();
+        delayMicroseconds(100);
+    }
+    unsigned long hangTime = millis() - lostAt;
+    chip->antcapError = 0;
+    CHECK(hangTime >= 500 && hangTime <= 500 + SI473X_SCAN_POLL + 10, "left after %lu ms", hangTime);
+    while (!rx.isScanStopped())
+    {
+        rx.scanTick();
+        delayMicroseconds(100);
+    }
+    CHECK(rx.getScanChannel() == 1 && chip->getFrequency() == 810, "channel %u, frequency %u", rx.getScanChannel(),
+          chip->getFrequency());
+    rx.resumeScan();
+    runScan(rx, 20);
+    rx.stopScan();
+    CHECK(!rx.isScanning() && chip->getProperty(RX_HARD_MUTE) == 0, "audio muted after stopScan");
+    rx.setAudioMute(true); // Muted by the user: stays muted across the mode switches and after stopScan
+    rx.setScanTimes(&scan, 300, 0);
+    rx.startScan(&scan, memories, memoryCount);
+    runScan(rx, 3000);
+    rx.stopScan();
+    CHECK(rx.getScanSwitches() > 0 && chip->getProperty(RX_HARD_MUTE) == 3, "%u mode switches, RX_HARD_MUTE %u",
+          rx.getScanSwitches(), chip->getProperty(RX_HARD_MUTE));
+    rx.setAudioMute(false);
+    rx.setAM(520, 1710, 810, 10);
+    rx.startScan(&scan, &memories[7], 1); // 88.3 MHz from the MW band: the limits and step have to be the FM ones
+    runScan(rx, 500);
+    rx.stopScan();
+    rx.frequencyUp();
+    CHECK(chip->getFrequency() == 8840, "frequencyUp after the scan: %u", chip->getFrequency());
+    rx.setAM(520, 1710, 810, 10);
+
+    // Signal snapshot: display loop (20 ms) with five widgets. Baseline: each widget reads its own status.
+    rx.setFM(8400, 10800, 10390, 10);
+    SimBusStats bus = simBusStats();
+    begin(s, "display loop x100 by hand");
+    for (int i = 0; i < 100; i++)
+    {
+        rx.getFrequency();                     // Frequency
+        rx.getCurrentReceivedSignalQuality(0); // S-meter
+        rx.getCurrentReceivedSignalQuality(0); // SNR
+        rx.getCurrentReceivedSignalQuality(0); // Stereo indicator
+        rx.getAutomaticGainControl();          // AGC
+        delay(20);
+    }
+    end(s, 100);
+    uint32_t manualTransactions = simBusStats().transactions - bus.transactions;
+    bus = simBusStats();
+    uint32_t reads = rx.getSnapshotReads();
+    si47x_signal_snapshot snapshot;
+    begin(s, "display loop x100 (snapshot)");
+    for (int i = 0; i < 100; i++)
+    {
+        for (int w = 0; w < 5; w++)
+            snapshot = rx.getSignalSnapshot();
+        delay(20);
+    }
+    end(s, 100);
+    uint32_t snapshotTransactions = simBusStats().transactions - bus.transactions;
+    CHECK(snapshotTransactions * 2 < manualTransactions, "%u transactions, by hand %u", snapshotTransactions,
+          manualTransactions);
+    CHECK(snapshot.frequency == 10390 && snapshot.rssi == 48 && snapshot.snr == 30 && snapshot.fm &&
+              millis() - snapshot.timestamp <= SI473X_SNAPSHOT_TTL + 20,
+          "frequency %u, RSSI %u, SNR %u", snapshot.frequency, snapshot.rssi, snapshot.snr);
+    if (!quiet)
+        printf("  %u transactions (%u readings, %u from the cache), by hand %u\n", snapshotTransactions,
+               rx.getSnapshotReads() - reads, rx.getSnapshotHits(), manualTransactions);
+    rx.setFrequency(9470);
+    snapshot = rx.getSignalSnapshot();
+    CHECK(snapshot.frequency == 9470 && snapshot.rssi == 41 && rx.getCurrentRSSI() == 41, "frequency %u, RSSI %u",
+          snapshot.frequency, snapshot.rssi);
+    reads = rx.getSnapshotReads();
+    rx.setFrequency(9470); // Tuned again on the same frequency
+    snapshot = rx.getSignalSnapshot();
+    CHECK(rx.getSnapshotReads() == reads + 1, "same frequency tune: %u snapshot readings", rx.getSnapshotReads() - reads);
+    rx.setAM(520, 1710, 810, 10);
+    snapshot = rx.getSignalSnapshot();
+    CHECK(!snapshot.fm && snapshot.rssi == 52 && snapshot.multipath == 0, "AM snapshot: RSSI %u", snapshot.rssi);
+
+    // Signal monitor: S-meter for 10 s with fading. Baseline: RSQ_STATUS every 100 ms.
+    rx.setFM(8400, 10800, 10390, 10);
+    uint32_t rsqBefore = chip->commandCount[FM_RSQ_STATUS];
+    uint8_t changes = 0, lastRssi = 48;
+    bus = simBusStats();
+    begin(s, "S-meter 10 s, RSQ every 100 ms");
+    unsigned long start = millis();
+    while (millis() - start < 10000)
+    {
+        chip->fade = fadeAt(millis() - start);
+        rx.getCurrentReceivedSignalQuality(0);
+        if (rx.getCurrentRSSI() != lastRssi)
+            changes++;
+        lastRssi = rx.getCurrentRSSI();
+        delay(100);
+    }
+    end(s);
+    uint64_t manualBusTime = simBusStats().busTime - bus.busTime;
+    uint32_t manualRsq = chip->commandCount[FM_RSQ_STATUS] - rsqBefore;
+    chip->fade = 0;
+    rsqBefore = chip->commandCount[FM_RSQ_STATUS];
+    rsqLastAt = 0;
+    static si47x_signal_monitor_state monitor;
+    rx.startSignalMonitor(&monitor, 3, 3, countSignalChange);
+    bus = simBusStats();
+    begin(s, "S-meter 10 s, signal monitor");
+    start = millis();
+    unsigned long latency = 0;
+    while (millis() - start < 10000)
+    {
+        chip->fade = fadeAt(millis() - start);
+        rx.signalMonitorTick();
+        if (rx.getSignalMonitorEvents() == 1 && latency == 0)
+            latency = rsqLastAt - start - 2000;
+        delay(1);
+    }
+    end(s);
+    uint64_t monitorBusTime = simBusStats().busTime - bus.busTime;
+    uint32_t monitorRsq = chip->commandCount[FM_RSQ_STATUS] - rsqBefore;
+    CHECK(changes == 3 && rx.getSignalMonitorEvents() == 3 && rsqLastRssi == 48, "%u events (%u by hand), RSSI %u",
+          rx.getSignalMonitorEvents(), changes, rsqLastRssi);
+    // Polling mode: a GET_INT_STATUS every 100 ms instead of the RSQ_STATUS; interrupt mode: no polling at all
+    // One RSQ_STATUS to arm plus, at most, one per event and one per interrupt latched before the windows moved
+    CHECK(monitorRsq <= 1u + 2 * rx.getSignalMonitorEvents() && monitorBusTime * (rx.isInterruptMode() ? 4 : 1) < manualBusTime &&
+              latency <= SI473X_RSQ_MONITOR_POLL + 10,
+          "%u RSQ reads, bus %.3f ms (by hand %.3f ms), latency %lu ms", monitorRsq, monitorBusTime / 1000.0,
+          manualBusTime / 1000.0, latency);
+    if (!quiet)
+        printf("  %u RSQ reads, bus %.3f ms, latency %lu ms; by hand %u RSQ reads, bus %.3f ms\n", monitorRsq,
+               monitorBusTime / 1000.0, latency, manualRsq, manualBusTime / 1000.0);
+    rx.setFrequency(9470);
+    runSignalMonitor(rx, 200);
+    CHECK(rsqLastRssi == 41, "RSSI %u after the tune", rsqLastRssi);
+    rx.setAM(520, 1710, 810, 10);
+    runSignalMonitor(rx, 50);
+    uint16_t events = rx.getSignalMonitorEvents();
+    chip->fade = -10;
+    runSignalMonitor(rx, 200);
+    chip->fade = 0;
+    CHECK(rx.getSignalMonitorEvents() == events + 1 && rsqLastRssi == 42, "AM: %u events, RSSI %u",
+          rx.getSignalMonitorEvents() - events, rsqLastRssi);
+    // SSB: the patch power up keeps the GPO2/INT output in interrupt mode
+    rx.loadPatch(ssbPatch.data(), (uint16_t)ssbPatch.size(), 2);
+    rx.setSSB(7000, 7300, 7100, 1, 1);
+    runSignalMonitor(rx, 50);
+    events = rx.getSignalMonitorEvents();
+    chip->fade = -10;
+    runSignalMonitor(rx, 200);
+    chip->fade = 0;
+    CHECK(rx.getSignalMonitorEvents() == events + 1 && rsqLastRssi == 25, "SSB: %u events, RSSI %u",
+          rx.getSignalMonitorEvents() - events, rsqLastRssi);
+    // A power cycle in the same mode clears the thresholds too
+    rx.powerDown();
+    rx.setAM(520, 1710, 810, 10);
+    runSignalMonitor(rx, 50);
+    events = rx.getSignalMonitorEvents();
+    chip->fade = -10;
+    runSignalMonitor(rx, 200);
+    chip->fade = 0;
+    CHECK(rx.getSignalMonitorEvents() == events + 1 && rsqLastRssi == 42, "AM after a power cycle: %u events, RSSI %u",
+          rx.getSignalMonitorEvents() - events, rsqLastRssi);
+    rx.stopSignalMonitor();
+    CHECK(chip->getProperty(AM_RSQ_INTERRUPTS) == 0 && (chip->getProperty(GPO_IEN) & 0x0008) == 0,
+          "RSQ interrupts left on");
+    rx.getCurrentReceivedSignalQuality(1);
+
+    // S-meter: samples every 100 ms for 10 s with fading, checked against a floating point reference
+    rx.setFM(8400, 10800, 10390, 10);
+    static si47x_meter_state meter;
+    CHECK(!rx.meterTick() && rx.getMeterRssi() == 0, "meter without a state");
+    rx.startMeter(&meter);
+    uint16_t samples = 0;
+    double reference = 48;
+    double worst = 0;
+    si47x_signal_stats windows[8] = {};
+    uint8_t closed = 0;
+    rx.setMeterTimes(SI473X_METER_PERIOD, 1500); // Windows not aligned with the fading steps
+    begin(s, "S-meter 10 s, meter statistics");
+    start = millis();
+    while (millis() - start < 10000)
+    {
+        chip->fade = fadeAt(millis() - start);
+        if (rx.meterTick())
+        {
+            uint8_t sample = rx.getCurrentRSSI();
+            reference += (sample - reference) / (1 << SI473X_METER_SMOOTHING);
+            if (samples > 0 && fabs(rx.getMeterRssi() - reference) > worst)
+                worst = fabs(rx.getMeterRssi() - reference);
+            samples++;
+            si47x_signal_stats stats = rx.getSignalStats();
+            if (stats.samples != 0 && closed < 8 && (closed == 0 || stats.timestamp != windows[closed - 1].timestamp))
+                windows[closed++] = stats;
+        }
+        delay(1);
+    }
+    end(s);
+    chip->fade = 0;
+    rx.setMeterTimes(SI473X_METER_PERIOD, SI473X_METER_WINDOW);
+    si47x_signal_stats last = rx.getSignalStats();
+    CHECK(samples == 100 && worst <= 0.6, "%u samples, %.2f dB from the reference", samples, worst);
+    // Windows of 1.5 s: the second one has the start of the fading (-10 dB at 2 s); the third one is all faded
+    CHECK(closed >= 6 && windows[1].rssiMin == 38 && windows[1].rssiMax == 48 && windows[1].rssiMean > 38 &&
+              windows[1].rssiMean < 44,
+          "window 2: %u samples, RSSI %u/%u/%u", windows[1].samples, windows[1].rssiMin, windows[1].rssiMax,
+          windows[1].rssiMean);
+    CHECK(windows[2].samples == 15 && windows[2].rssiMin == 38 &&
+              windows[2].rssiMax == 38 && windows[2].rssiMean == 38 && windows[2].snrMean == 20,
+          "window 3: %u samples, RSSI %u/%u/%u, SNR %u", windows[2].samples, windows[2].rssiMin, windows[2].rssiMax,
+          windows[2].rssiMean, windows[2].snrMean);
+    CHECK(last.rssiMax == 48 && rx.getMeterRssi() == 48 && rx.getMeterSnr() == 30, "last window RSSI %u, meter %u/%u",
+          last.rssiMax, rx.getMeterRssi(), rx.getMeterSnr());
+    uint8_t over;
+    CHECK(rx.getMeterDbm() == -59 && rx.getSMeter(&over) == 9 && over == 34, "FM: %d dBm, S%u+%u",
+          rx.getMeterDbm(), rx.getSMeter(), over);
+    if (!quiet)
+        printf("  %u samples, %.2f dB from the floating point reference, last window RSSI %u/%u/%u\n", samples, worst,
+               last.rssiMin, last.rssiMax, last.rssiMean);
+    // Peak: held 1 s, then 20 dB/s
+    rx.resetMeter();
+    rx.meterSample(48, 30);
+    delay(900);
+    rx.meterSample(38, 20);
+    uint8_t held = rx.getMeterPeak();
+    delay(350);
+    uint8_t decaying = rx.getMeterPeak();
+    delay(500);
+    rx.meterSample(38, 20);
+    CHECK(held == 48 && decaying == 43 && rx.getMeterPeak() == 38, "peak %u, %u, %u", held, decaying,
+          rx.getMeterPeak());
+    // Mode change: the meter starts again with the calibration of the new mode
+    rx.setAM(520, 1710, 1470, 10);
+    rx.meterTick();
+    CHECK(rx.getMeterRssi() == 22 && rx.getMeterDbm() == -85 && rx.getSMeter(&over) == 7 && over == 0,
+          "AM: RSSI %u, %d dBm, S%u", rx.getMeterRssi(), rx.getMeterDbm(), rx.getSMeter());
+    rx.setMeterCalibration(AM_CURRENT_MODE, 12);
+    CHECK(rx.getSMeter(&over) == 9 && over == 0 && rx.dbmToSUnit(-80) == 7 && rx.dbmToSUnit(-130) == 0,
+          "calibrated AM: S%u+%u", rx.getSMeter(), over);
+    rx.setMeterCalibration(AM_CURRENT_MODE, 0);
+    rx.setMeterCalibration(4, 1);
+    CHECK(rx.getLastError() == SI473X_ERROR_INVALID_ARG, "invalid mode accepted");
+    rx.setAM(520, 1710, 810, 10);
+
+    si47x_error_stats stats = rx.getErrorStats();
+    CHECK(stats.timeouts == expectedTimeouts, "%u timeouts (%u STC, %u expected)", stats.timeouts, stats.stcTimeouts,
+          expectedTimeouts);
+    CHECK(stats.busErrors == 0, "%u bus errors", stats.busErrors);
+}
+
+int main(int argc, char **argv)
+{
+    const char *spectrum = "data/spectrum.txt";
+
+    setvbuf(stdout, NULL, _IOLBF, 0); // Shows the progress of each scenario even through a pipe
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            spectrum = argv[++i];
+        else if (strcmp(argv[i], "-q") == 0)
+            quiet = true;
+        else
+        {
+            printf("usage: %s [-s spectrum_file] [-q]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    chip = new Si47xxModel(RESET_PIN, INT_PIN);
+    if (!chip->loadSpectrum(spectrum))
+    {
+        printf("cannot read %s\n", spectrum);
+        return 1;
+    }
+    simAttach(SI473X_ADDR_SEN_LOW, chip);
+
+    polling.setPropertyCache(pollingCache, 16);
+    polling.setSnapshotCache(&pollingSnapshot);
+    polling.setModeState(pollingModeState, 12);
+    polling.setPropertyBatch(pollingBatch, 20);
+    CHECK(polling.getErrorStats().commands == 0, "statistics without a struct");
+    polling.setErrorStats(&pollingErrors);
+    runReceiver(polling, "Polling mode (CTS and STC by I2C)");
+
+    interrupt.setPropertyCache(interruptCache, 16);
+    interrupt.setSnapshotCache(&interruptSnapshot);
+    interrupt.setModeState(interruptModeState, 12);
+    interrupt.setPropertyBatch(interruptBatch, 20);
+    interrupt.setErrorStats(&interruptErrors);
+    interrupt.setCommandTimingTable(interruptTiming); // Own timing: the changes below do not touch the polling receiver
+    interrupt.setCommandTiming(SET_PROPERTY, 120, 80, 100);
+    CHECK(interrupt.getCommandTiming(SET_PROPERTY).expected == 120 && polling.getCommandTiming(SET_PROPERTY).expected != 120,
+          "SET_PROPERTY timing %u / %u", interrupt.getCommandTiming(SET_PROPERTY).expected,
+          polling.getCommandTiming(SET_PROPERTY).expected);
+    interrupt.setInterruptPin(INT_PIN, 1, 0, 0, 1);
+    runReceiver(interrupt, "Interrupt mode (GPO2/INT: STC and CTS)");
+
+    CHECK(chip->violations == 0, "%u protocol violations; last: %s", chip->violations, chip->lastViolation);
+    printf("\ncommands %u, device errors %u, protocol violations %u, I2C time %.3f ms\n", chip->commands, chip->errors,
+           chip->violations, simBusStats().busTime / 1000.0);
+    printf("%s (%d failed checks)\n", (failures == 0) ? "PASSED" : "FAILED", failures);
+
+    return failures;
+}
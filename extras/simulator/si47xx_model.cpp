@@ -0,0 +1,773 @@
+/*
+ * Behavioral model of the SI47XX. See si47xx_model.h.
+ */
+#include "si47xx_model.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define STATUS_STCINT 0x01
+#define STATUS_RDSINT 0x04
+#define STATUS_RSQINT 0x08
+#define STATUS_ERR 0x40
+#define STATUS_CTS 0x80
+
+#define GPO_IEN_STCIEN 0x01
+#define GPO_IEN_RDSIEN 0x04
+#define GPO_IEN_RSQIEN 0x08
+#define GPO_IEN_CTSIEN 0x80
+
+Si47xxModel::Si47xxModel(uint8_t resetPin, uint8_t interruptPin)
+{
+    this->resetPin = resetPin;
+    this->interruptPin = interruptPin;
+
+    timing.command = 250;
+    timing.property = 200;
+    timing.powerUp = 110000;
+    timing.powerDown = 1500;
+    timing.tuneCts = 250;
+    timing.fmTune = 60000;
+    timing.amTune = 80000;
+    timing.fastTune = 5000;
+    timing.fmSeekStep = 60000;
+    timing.amSeekStep = 80000;
+    timing.patchLine = 150;
+    timing.rdsSync = 40000;
+    timing.rdsGroup = 87600;
+    timing.rsqMeasure = 8000;
+
+    memset(commandCount, 0, sizeof(commandCount));
+    lastViolation[0] = '\0';
+    setDefaultProperties();
+}
+
+/*
+ * Spectrum
+ */
+
+void Si47xxModel::addStation(const Si47xxStation &station)
+{
+    stations.push_back(station);
+}
+
+/**
+ * Loads RDS groups: one group per line with the blocks A, B, C and D in hex. Lines starting with # are ignored.
+ */
+bool Si47xxModel::loadRdsGroups(const char *fileName, std::vector<Si47xxRdsGroup> &groups)
+{
+    FILE *f = fopen(fileName, "r");
+    char line[256];
+    unsigned a, b, c, d;
+
+    if (f == NULL)
+        return false;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%x %x %x %x", &a, &b, &c, &d) == 4)
+        {
+            Si47xxRdsGroup g = {{(uint16_t)a, (uint16_t)b, (uint16_t)c, (uint16_t)d}};
+            groups.push_back(g);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * Loads a spectrum file. One station per line: band (FM or AM), frequency, RSSI, SNR and, optionally,
+ * an RDS group file (relative to the spectrum file). Lines starting with # are ignored.
+ */
+bool Si47xxModel::loadSpectrum(const char *fileName)
+{
+    FILE *f = fopen(fileName, "r");
+    std::string dir(fileName);
+    char line[256], band[8], rdsFile[128];
+    unsigned freq, rssi, snr;
+    int n;
+
+    if (f == NULL)
+        return false;
+    dir = (dir.find('/') != std::string::npos) ? dir.substr(0, dir.rfind('/') + 1) : "";
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (line[0] == '#')
+            continue;
+        n = sscanf(line, "%7s %u %u %u %127s", band, &freq, &rssi, &snr, rdsFile);
+        if (n < 4)
+            continue;
+
+        Si47xxStation st;
+        st.band = (strcmp(band, "FM") == 0) ? SI47XX_MODEL_FM : SI47XX_MODEL_AM;
+        st.frequency = (uint16_t)freq;
+        st.rssi = (uint8_t)rssi;
+        st.snr = (uint8_t)snr;
+        if (n == 5 && !loadRdsGroups((dir + rdsFile).c_str(), st.rds))
+        {
+            fprintf(stderr, "si47xx_model: cannot read %s%s\n", dir.c_str(), rdsFile);
+            fclose(f);
+            return false;
+        }
+        addStation(st);
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * Signal at a given frequency: full level on the station channel, weaker (and noisy) on the adjacent channels.
+ */
+void Si47xxModel::getSignal(uint8_t band, uint16_t freq, uint8_t *rssi, uint8_t *snr, const Si47xxStation **station)
+{
+    uint8_t bestRssi = (band == SI47XX_MODEL_FM) ? 4 : 10; // Noise floor
+    uint8_t bestSnr = 0;
+    const Si47xxStation *best = NULL;
+
+    for (size_t i = 0; i < stations.size(); i++)
+    {
+        const Si47xxStation &st = stations[i];
+        int d = abs((int)freq - (int)st.frequency);
+        int r = -1, s = 0;
+
+        if (st.band != band)
+            continue;
+        if (d == 0)
+        {
+            r = st.rssi;
+            s = st.snr;
+        }
+        else if (band == SI47XX_MODEL_FM && d <= 10)
+            r = st.rssi - 20;
+        else if (band == SI47XX_MODEL_AM && d <= 2)
+        {
+            r = st.rssi - 6;
+            s = st.snr - 6;
+        }
+        else if (band == SI47XX_MODEL_AM && d <= 5)
+            r = st.rssi - 20;
+
+        if (r > bestRssi)
+        {
+            bestRssi = (uint8_t)r;
+            bestSnr = (uint8_t)((s > 0) ? s : 0);
+            best = (d == 0) ? &st : NULL;
+        }
+    }
+
+    // Loss of a tuning capacitor away from the best one for the antenna (the seek and a zero ANTCAP use the automatic value).
+    // Off unless an antenna error is set.
+    if (antcapError != 0 && (band == SI47XX_MODEL_FM || freq <= 1800))
+    {
+        uint16_t automatic = getAutoAntcap(band, freq);
+        int cap = (antcap != 0) ? antcap : automatic;
+        int loss = abs(cap - ((int)automatic + antcapError)) / (antcapWidth ? antcapWidth : 1);
+        uint8_t floor = (band == SI47XX_MODEL_FM) ? 4 : 10;
+        if (loss > 30)
+            loss = 30;
+        floor += 12 - ((loss < 12) ? loss : 12); // Band noise picked up by the antenna (highest at the resonance)
+        bestRssi = (bestRssi > floor + loss) ? bestRssi - loss : floor;
+        bestSnr = (bestSnr > loss) ? bestSnr - loss : 0;
+    }
+
+    if (fade != 0)
+    {
+        int r = bestRssi + fade, s = bestSnr + fade;
+        bestRssi = (uint8_t)((r < 0) ? 0 : (r > 127) ? 127 : r);
+        bestSnr = (uint8_t)((s < 0) ? 0 : (s > 127) ? 127 : s);
+    }
+
+    *rssi = bestRssi;
+    *snr = bestSnr;
+    if (station != NULL)
+        *station = best;
+}
+
+/**
+ * Tuning capacitor selected automatically: FM varactor (0 to 191) and the resonance of a 300 uH antenna on LW/MW
+ * (95 fF x ANTCAP + 7 pF). Not used on SW.
+ */
+uint16_t Si47xxModel::getAutoAntcap(uint8_t band, uint16_t freq)
+{
+    double pF, cap;
+
+    if (band == SI47XX_MODEL_FM)
+        return (uint16_t)((10800 - ((freq < 10800) ? freq : 10800)) * 191 / 4400);
+    if (freq > 1800)
+        return 1;
+    pF = 1e12 / (4 * M_PI * M_PI * (freq * 1e3) * (freq * 1e3) * 300e-6);
+    cap = (pF - 7) / 0.095;
+    return (uint16_t)((cap < 1) ? 1 : (cap > 6143) ? 6143 : cap);
+}
+
+/**
+ * A channel is valid if RSSI and SNR reach the seek/tune thresholds (properties).
+ */
+bool Si47xxModel::isValidChannel(uint8_t band, uint16_t freq)
+{
+    uint8_t r, s;
+
+    getSignal(band, freq, &r, &s, NULL);
+    if (band == SI47XX_MODEL_FM)
+        return r >= getProperty(0x1404) && s >= getProperty(0x1403);
+    return r >= getProperty(0x3404) && s >= getProperty(0x3403);
+}
+
+/*
+ * Device state
+ */
+
+void Si47xxModel::setDefaultProperties()
+{
+    properties.clear();
+    properties[0x0001] = 0x0000; // GPO_IEN
+    properties[0x1200] = 0x0000; // FM_RSQ_INT_SOURCE
+    properties[0x1201] = 127;    // FM_RSQ_SNR_HI_THRESHOLD
+    properties[0x1202] = 0;      // FM_RSQ_SNR_LO_THRESHOLD
+    properties[0x1203] = 127;    // FM_RSQ_RSSI_HI_THRESHOLD
+    properties[0x1204] = 0;      // FM_RSQ_RSSI_LO_THRESHOLD
+    properties[0x1400] = 8750;   // FM_SEEK_BAND_BOTTOM
+    properties[0x1401] = 10790;  // FM_SEEK_BAND_TOP
+    properties[0x1402] = 10;     // FM_SEEK_FREQ_SPACING
+    properties[0x1403] = 3;      // FM_SEEK_TUNE_SNR_THRESHOLD
+    properties[0x1404] = 20;     // FM_SEEK_TUNE_RSSI_THRESHOLD
+    properties[0x1500] = 0x0000; // FM_RDS_INT_SOURCE
+    properties[0x1501] = 0x0000; // FM_RDS_INT_FIFO_COUNT
+    properties[0x1502] = 0x0000; // FM_RDS_CONFIG
+    properties[0x3200] = 0x0000; // AM_RSQ_INTERRUPTS
+    properties[0x3201] = 127;    // AM_RSQ_SNR_HIGH_THRESHOLD
+    properties[0x3202] = 0;      // AM_RSQ_SNR_LOW_THRESHOLD
+    properties[0x3203] = 127;    // AM_RSQ_RSSI_HIGH_THRESHOLD
+    properties[0x3204] = 0;      // AM_RSQ_RSSI_LOW_THRESHOLD
+    properties[0x3400] = 520;    // AM_SEEK_BAND_BOTTOM
+    properties[0x3401] = 1710;   // AM_SEEK_BAND_TOP
+    properties[0x3402] = 10;     // AM_SEEK_FREQ_SPACING
+    properties[0x3403] = 5;      // AM_SEEK_SNR_THRESHOLD
+    properties[0x3404] = 25;     // AM_SEEK_RSSI_THRESHOLD
+    properties[0x4000] = 63;     // RX_VOLUME
+    properties[0x4001] = 0;      // RX_HARD_MUTE
+}
+
+uint16_t Si47xxModel::getProperty(uint16_t property)
+{
+    std::map<uint16_t, uint16_t>::iterator it = properties.find(property);
+    return (it != properties.end()) ? it->second : 0;
+}
+
+void Si47xxModel::powerDown()
+{
+    powered = patchMode = patched = false;
+    seeking = false;
+    stcAt = SIM_NO_EVENT;
+    status &= ~(STATUS_STCINT | STATUS_RDSINT | STATUS_RSQINT);
+    rsqAt = SIM_NO_EVENT;
+    rsqFlags = 0;
+    rdsStation = NULL;
+    rdsNextAt = SIM_NO_EVENT;
+    rdsSync = rdsSyncFound = rdsGroupLost = false;
+    rdsFifo.clear();
+    agcDisabled = agcIndex = 0; // The AGC override is lost too
+    setDefaultProperties();
+}
+
+void Si47xxModel::reset()
+{
+    powerDown();
+    status = 0;
+    busyUntil = 0;
+    ctsPending = false;
+}
+
+void Si47xxModel::violation(const char *message, uint8_t cmd)
+{
+    violations++;
+    snprintf(lastViolation, sizeof(lastViolation), "%s (command 0x%02X at %llu us)", message, cmd, (unsigned long long)simNow());
+}
+
+void Si47xxModel::pulse()
+{
+    if (gpo2Enabled)
+        simInterrupt(interruptPin);
+}
+
+/**
+ * Starts the periodic RSQ measurement (if it is not running).
+ */
+void Si47xxModel::armRsq()
+{
+    if (rsqAt == SIM_NO_EVENT)
+        rsqAt = simNow() + timing.rsqMeasure;
+}
+
+/**
+ * RSQ measurement: latches the RSQ interrupt bits of the enabled sources whose threshold is crossed
+ * (RSSI or SNR below the low or above the high threshold). Stops when no source is enabled.
+ */
+void Si47xxModel::measureRsq()
+{
+    uint16_t base = (func == SI47XX_MODEL_FM) ? 0x1200 : 0x3200;
+    uint16_t sources = getProperty(base);
+    uint8_t r, s, flags = 0;
+
+    if (!powered || (sources & 0x000F) == 0)
+    {
+        rsqAt = SIM_NO_EVENT;
+        return;
+    }
+    if (seeking || stcAt != SIM_NO_EVENT || frequency == 0)
+        return; // No measurement while tuning
+    getSignal(func, frequency, &r, &s, NULL);
+    if ((sources & 0x01) && r < getProperty(base + 4))
+        flags |= 0x01; // RSSILINT
+    if ((sources & 0x02) && r > getProperty(base + 3))
+        flags |= 0x02; // RSSIHINT
+    if ((sources & 0x04) && s < getProperty(base + 2))
+        flags |= 0x04; // SNRLINT
+    if ((sources & 0x08) && s > getProperty(base + 1))
+        flags |= 0x08; // SNRHINT
+    rsqFlags |= flags;
+    if (flags != 0 && !(status & STATUS_RSQINT))
+    {
+        status |= STATUS_RSQINT;
+        if (interruptEnable() & GPO_IEN_RSQIEN)
+            pulse();
+    }
+}
+
+/*
+ * Tune and seek
+ */
+
+bool Si47xxModel::tune(uint8_t band, uint16_t freq, bool fast)
+{
+    frequency = freq;
+    seeking = false;
+    bandLimit = valid = false;
+    status &= ~STATUS_STCINT;
+    if (fast)
+        stcAt = simNow() + timing.tuneCts + timing.fastTune;
+    else
+        stcAt = simNow() + timing.tuneCts + ((band == SI47XX_MODEL_FM) ? timing.fmTune : timing.amTune);
+    rdsStation = NULL;
+    rdsNextAt = SIM_NO_EVENT;
+    rdsSync = false;
+    rdsFifo.clear();
+    return true;
+}
+
+void Si47xxModel::seek(uint8_t band, bool up, bool wrap)
+{
+    tune(band, frequency);
+    antcap = 0; // The seek selects the capacitor automatically
+    seeking = true;
+    seekUp = up;
+    seekWrap = wrap;
+    seekOrigin = frequency;
+    stcAt = simNow() + timing.tuneCts + ((band == SI47XX_MODEL_FM) ? timing.fmSeekStep : timing.amSeekStep);
+}
+
+/**
+ * Next channel of the seek (one event per channel, so TUNE_STATUS reports the progress).
+ */
+void Si47xxModel::seekStep()
+{
+    uint8_t band = func;
+    uint16_t bottom = getProperty((band == SI47XX_MODEL_FM) ? 0x1400 : 0x3400);
+    uint16_t top = getProperty((band == SI47XX_MODEL_FM) ? 0x1401 : 0x3401);
+    uint16_t spacing = getProperty((band == SI47XX_MODEL_FM) ? 0x1402 : 0x3402);
+    int f = (int)frequency + ((seekUp) ? spacing : -(int)spacing);
+
+    if (f > top || f < bottom)
+    {
+        if (!seekWrap)
+        {
+            frequency = (f > top) ? top : bottom;
+            bandLimit = true;
+            finishTune();
+            return;
+        }
+        f = (f > top) ? bottom : top;
+    }
+    frequency = (uint16_t)f;
+    if (isValidChannel(band, frequency))
+    {
+        finishTune();
+        return;
+    }
+    if (frequency == seekOrigin)
+    {
+        bandLimit = true; // Wrapped around without finding a station
+        finishTune();
+        return;
+    }
+    stcAt += (band == SI47XX_MODEL_FM) ? timing.fmSeekStep : timing.amSeekStep;
+}
+
+void Si47xxModel::finishTune()
+{
+    const Si47xxStation *st;
+
+    seeking = false;
+    stcAt = SIM_NO_EVENT;
+    getSignal(func, frequency, &rssi, &snr, &st);
+    valid = isValidChannel(func, frequency);
+    status |= STATUS_STCINT;
+    if (interruptEnable() & GPO_IEN_STCIEN)
+        pulse();
+
+    if (func == SI47XX_MODEL_FM && st != NULL && valid && !st->rds.empty())
+    {
+        rdsStation = st;
+        rdsIndex = 0;
+        rdsNextAt = simNow() + timing.rdsSync;
+    }
+}
+
+/*
+ * Events (CTS, STC, seek steps and RDS groups)
+ */
+
+uint64_t Si47xxModel::nextEvent()
+{
+    uint64_t next = SIM_NO_EVENT;
+
+    if (ctsPending)
+        next = busyUntil;
+    if (stcAt < next)
+        next = stcAt;
+    if (rdsNextAt < next)
+        next = rdsNextAt;
+    if (rsqAt < next)
+        next = rsqAt;
+    return next;
+}
+
+void Si47xxModel::runEvents(uint64_t now)
+{
+    if (ctsPending && now >= busyUntil)
+    {
+        ctsPending = false;
+        if (ctsInterrupt || (interruptEnable() & GPO_IEN_CTSIEN))
+            pulse();
+    }
+
+    while (stcAt <= now)
+    {
+        if (seeking)
+            seekStep();
+        else
+            finishTune();
+    }
+
+    while (rsqAt <= now)
+    {
+        rsqAt += timing.rsqMeasure;
+        measureRsq();
+    }
+
+    while (rdsNextAt <= now)
+    {
+        rdsNextAt += timing.rdsGroup;
+        if (rdsStation == NULL || !(getProperty(0x1502) & 0x0001)) // RDSEN
+            continue;
+        if (!rdsSync)
+            rdsSync = rdsSyncFound = true;
+        if (rdsFifo.size() < SI47XX_MODEL_RDS_FIFO_SIZE)
+            rdsFifo.push_back(rdsStation->rds[rdsIndex % rdsStation->rds.size()]);
+        else
+        {
+            rdsGroupLost = true;
+            rdsGroupsLost++;
+        }
+        rdsIndex++;
+        if ((getProperty(0x1500) & 0x0001) && rdsFifo.size() >= (size_t)(getProperty(0x1501) ? getProperty(0x1501) : 1))
+        {
+            status |= STATUS_RDSINT;
+            if (interruptEnable() & GPO_IEN_RDSIEN)
+                pulse();
+        }
+    }
+}
+
+/*
+ * I2C and pins
+ */
+
+void Si47xxModel::pinWrite(uint8_t pin, uint8_t value)
+{
+    if (pin != resetPin)
+        return;
+    if (value == LOW)
+    {
+        inReset = true;
+        reset();
+    }
+    else
+        inReset = false;
+}
+
+bool Si47xxModel::i2cWrite(const uint8_t *data, uint8_t size)
+{
+    if (inReset)
+        return false;
+    if (size == 0) // Address probe (see getDeviceI2CAddress)
+        return true;
+    if (simNow() < busyUntil)
+    {
+        violation("command sent while the device is busy", data[0]);
+        return true;
+    }
+    execute(data, size);
+    return true;
+}
+
+bool Si47xxModel::i2cRead(uint8_t *data, uint8_t size)
+{
+    bool cts = simNow() >= busyUntil;
+
+    if (inReset)
+        return false;
+    for (uint8_t i = 0; i < size; i++)
+        data[i] = (cts && i < sizeof(response)) ? response[i] : 0;
+    data[0] = status | ((cts) ? STATUS_CTS : 0);
+    return true;
+}
+
+/*
+ * Commands
+ */
+
+void Si47xxModel::execute(const uint8_t *cmd, uint8_t size)
+{
+    uint32_t busy = timing.command;
+    bool error = false;
+    uint16_t property, freq, cap;
+
+    commands++;
+    commandCount[cmd[0]]++;
+    memset(response, 0, sizeof(response));
+    status &= ~STATUS_ERR;
+
+    if (patchMode)
+    {
+        if (cmd[0] == 0x15 || cmd[0] == 0x16)
+        {
+            if (size != 8)
+                violation("patch line must have 8 bytes", cmd[0]);
+            patchLines++;
+            busyUntil = simNow() + timing.patchLine;
+            ctsPending = true;
+            return;
+        }
+        patchMode = false; // The first regular command ends the patch download
+        patched = patchLines > 0;
+    }
+
+    if (!powered && cmd[0] != 0x01)
+        error = true; // After POWER_DOWN, only POWER_UP is accepted
+    else
+    {
+        switch (cmd[0])
+        {
+        case 0x01: // POWER_UP
+            if (size < 3)
+                error = true;
+            else if ((cmd[1] & 0x0F) == 15) // Query library ID. The device goes back to the power down mode.
+            {
+                response[1] = 35;  // PN
+                response[2] = '6'; // FWMAJOR
+                response[3] = '0'; // FWMINOR
+                response[6] = 'D'; // CHIPREV
+                response[7] = 0x24; // LIBRARYID
+            }
+            else if (!powered)
+            {
+                if ((cmd[1] & 0x0F) > 1)
+                {
+                    error = true;
+                    break;
+                }
+                powered = true;
+                func = ((cmd[1] & 0x0F) == 0) ? SI47XX_MODEL_FM : SI47XX_MODEL_AM;
+                ctsInterrupt = (cmd[1] & 0x80) != 0;
+                gpo2Enabled = (cmd[1] & 0x40) != 0;
+                patchMode = (cmd[1] & 0x20) != 0;
+                if (patchMode)
+                    patchLines = 0;
+                frequency = 0;
+                busy = timing.powerUp;
+            }
+            // POWER_UP while powered up is ignored (the library uses it to change the SSB mode after a patch)
+            break;
+        case 0x10: // GET_REV
+            response[1] = 35;
+            response[2] = '6';
+            response[3] = '0';
+            response[4] = (patched) ? 0xD2 : 0;
+            response[5] = (patched) ? 0xE0 : 0;
+            response[6] = '6';
+            response[7] = '0';
+            response[8] = 'D';
+            break;
+        case 0x11: // POWER_DOWN
+            powerDown();
+            busy = timing.powerDown;
+            break;
+        case 0x12: // SET_PROPERTY
+            property = ((uint16_t)cmd[2] << 8) | cmd[3];
+            // SSB_BFO, SSB_MODE, SSB_RF_AGC_ATTACK_RATE and SSB_RF_AGC_RELEASE_RATE exist just on the SSB patch
+            if (size < 6 || ((property == 0x0100 || property == 0x0101 || property == 0x3700 || property == 0x3701) && !patched))
+                error = true;
+            else
+                properties[property] = ((uint16_t)cmd[4] << 8) | cmd[5];
+            if (!error && (property == 0x1200 || property == 0x3200)) // FM_RSQ_INT_SOURCE and AM_RSQ_INTERRUPTS
+                armRsq();
+            busy = timing.property;
+            break;
+        case 0x13: // GET_PROPERTY
+            if (size < 4)
+                error = true;
+            else
+            {
+                property = getProperty(((uint16_t)cmd[2] << 8) | cmd[3]);
+                response[2] = property >> 8;
+                response[3] = property & 0xFF;
+            }
+            busy = timing.property;
+            break;
+        case 0x14: // GET_INT_STATUS
+            break;
+        case 0x20: // FM_TUNE_FREQ
+        case 0x40: // AM_TUNE_FREQ (AM and SSB)
+            if (stcAt != SIM_NO_EVENT)
+                violation("tune sent before the STC of the previous tune or seek", cmd[0]);
+            freq = ((uint16_t)cmd[2] << 8) | cmd[3];
+            if (cmd[0] == 0x20)
+                error = func != SI47XX_MODEL_FM || size < 4 || freq < 6400 || freq > 10800;
+            else
+                error = func != SI47XX_MODEL_AM || size < 5 || freq < 149 || freq > 30000 || ((cmd[1] & 0xC0) != 0 && !patched);
+            if (!error)
+            {
+                antcap = (cmd[0] == 0x20) ? cmd[4] : (((uint16_t)cmd[4] << 8) | cmd[5]);
+                tune(func, freq, (cmd[1] & 0x01) != 0); // ARG1 bit 0: FAST
+            }
+            busy = timing.tuneCts;
+            break;
+        case 0x21: // FM_SEEK_START
+        case 0x41: // AM_SEEK_START
+            if (stcAt != SIM_NO_EVENT)
+                violation("seek sent before the STC of the previous tune or seek", cmd[0]);
+            error = func != ((cmd[0] == 0x21) ? SI47XX_MODEL_FM : SI47XX_MODEL_AM) || frequency == 0;
+            if (!error)
+                seek(func, (cmd[1] & 0x08) != 0, (cmd[1] & 0x04) != 0);
+            busy = timing.tuneCts;
+            break;
+        case 0x22: // FM_TUNE_STATUS
+        case 0x42: // AM_TUNE_STATUS
+            if (func != ((cmd[0] == 0x22) ? SI47XX_MODEL_FM : SI47XX_MODEL_AM) || size < 2)
+            {
+                error = true;
+                break;
+            }
+            if ((cmd[1] & 0x02) && seeking) // CANCEL
+                finishTune();
+            if (cmd[1] & 0x01) // INTACK
+                status &= ~STATUS_STCINT;
+            response[1] = ((bandLimit) ? 0x80 : 0) | ((valid && !seeking) ? 0x01 : 0);
+            response[2] = frequency >> 8;
+            response[3] = frequency & 0xFF;
+            response[4] = (seeking) ? 0 : rssi;
+            response[5] = (seeking) ? 0 : snr;
+            cap = (antcap != 0) ? antcap : getAutoAntcap(func, frequency); // READANTCAP
+            response[6] = (func == SI47XX_MODEL_FM) ? 0 : (cap >> 8);
+            response[7] = cap & 0xFF;
+            break;
+        case 0x23: // FM_RSQ_STATUS
+        case 0x43: // AM_RSQ_STATUS
+        {
+            uint8_t r, s;
+            bool v;
+            if (func != ((cmd[0] == 0x23) ? SI47XX_MODEL_FM : SI47XX_MODEL_AM))
+            {
+                error = true;
+                break;
+            }
+            getSignal(func, frequency, &r, &s, NULL);
+            v = isValidChannel(func, frequency);
+            response[1] = rsqFlags; // RSSILINT, RSSIHINT, SNRLINT and SNRHINT
+            if (cmd[1] & 0x01)      // INTACK
+            {
+                rsqFlags = 0;
+                status &= ~STATUS_RSQINT;
+            }
+            response[2] = ((v) ? 0x01 : 0) | ((s < 8) ? 0x08 : 0); // VALID and SMUTE
+            if (func == SI47XX_MODEL_FM && v)
+                response[3] = ((s >= 20) ? 0x80 : 0) | ((s >= 30) ? 100 : s * 3); // PILOT and STBLEND
+            response[4] = r;
+            response[5] = s;
+            break;
+        }
+        case 0x24: // FM_RDS_STATUS
+        {
+            size_t used = rdsFifo.size();
+            uint16_t fifoCount = getProperty(0x1501);
+            if (func != SI47XX_MODEL_FM || size < 2)
+            {
+                error = true;
+                break;
+            }
+            response[1] = ((used > 0 && used >= (size_t)(fifoCount ? fifoCount : 1)) ? 0x01 : 0) | ((rdsSyncFound) ? 0x04 : 0) | ((used > 0) ? 0x30 : 0);
+            response[2] = ((rdsSync) ? 0x01 : 0) | ((rdsGroupLost) ? 0x04 : 0);
+            response[3] = (uint8_t)used;
+            rdsSyncFound = rdsGroupLost = false;
+            if (used > 0)
+            {
+                const Si47xxRdsGroup &g = rdsFifo.front();
+                for (int i = 0; i < 4; i++)
+                {
+                    response[4 + i * 2] = g.block[i] >> 8;
+                    response[5 + i * 2] = g.block[i] & 0xFF;
+                }
+                if (!(cmd[1] & 0x04)) // STATUSONLY = 0: removes the group from the FIFO
+                    rdsFifo.erase(rdsFifo.begin());
+            }
+            if (cmd[1] & 0x02) // MTFIFO
+                rdsFifo.clear();
+            if (cmd[1] & 0x01) // INTACK
+                status &= ~STATUS_RDSINT;
+            break;
+        }
+        case 0x27: // FM_AGC_STATUS
+        case 0x47: // AM_AGC_STATUS
+            response[1] = agcDisabled;
+            response[2] = agcIndex;
+            break;
+        case 0x28: // FM_AGC_OVERRIDE
+        case 0x48: // AM_AGC_OVERRIDE
+            if (size < 3)
+                error = true;
+            else
+            {
+                agcDisabled = cmd[1] & 0x01;
+                agcIndex = cmd[2];
+            }
+            break;
+        case 0x80: // GPIO_CTL
+        case 0x81: // GPIO_SET
+            break;
+        default:
+            error = true; // Includes the NBFM and the patch commands when the patch was not loaded
+            break;
+        }
+    }
+
+    if (error)
+    {
+        errors++;
+        status |= STATUS_ERR;
+    }
+    busyUntil = simNow() + busy;
+    ctsPending = true;
+}
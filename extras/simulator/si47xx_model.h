@@ -0,0 +1,176 @@
+/*
+ * Behavioral model of the SI47XX (SI4735-D60 / SI4732-A10) used to run the library on Linux.
+ *
+ * What is modeled:
+ * - Status byte: CTS (busy time per command), ERR (invalid command, argument or state), STCINT, RDSINT.
+ * - POWER_UP / POWER_DOWN, GET_REV, query library ID (POWER_UP FUNC = 15), SET_PROPERTY / GET_PROPERTY, GET_INT_STATUS.
+ * - FM/AM/SSB TUNE_FREQ and SEEK_START with the STC time, TUNE_STATUS and RSQ_STATUS from a synthetic spectrum.
+ * - RDS FIFO (FM_RDS_STATUS) fed from group files at the RDS group rate.
+ * - Patch download (POWER_UP with PATCH = 1 followed by 0x15/0x16 lines).
+ * - GPO2/INT pulses (CTS, STC and RDS interrupts).
+ * - READANTCAP and the loss of a tuning capacitor away from the best one for the antenna (see antcapError).
+ * - RSQ interrupts: RSSI and SNR thresholds checked by a periodic measurement; fading (see fade) changes the signal.
+ *
+ * Protocol violations (a command written while the device is busy, a patch line out of the patch mode etc)
+ * are counted (see violations) so a test can detect a library change that breaks the timing rules.
+ */
+#ifndef SI47XX_MODEL_H_INCLUDED
+#define SI47XX_MODEL_H_INCLUDED
+
+#include <vector>
+#include <map>
+#include <string>
+#include "sim_arduino.h"
+
+#define SI47XX_MODEL_FM 0
+#define SI47XX_MODEL_AM 1 // AM and SSB
+
+#define SI47XX_MODEL_RDS_FIFO_SIZE 25
+
+/**
+ * @brief RDS group (blocks A to D)
+ */
+typedef struct
+{
+    uint16_t block[4];
+} Si47xxRdsGroup;
+
+/**
+ * @brief Station of the synthetic spectrum
+ */
+typedef struct
+{
+    uint8_t band;                    //!< SI47XX_MODEL_FM or SI47XX_MODEL_AM
+    uint16_t frequency;              //!< FM: 10 kHz units; AM/SSB: kHz
+    uint8_t rssi;                    //!< dBuV
+    uint8_t snr;                     //!< dB
+    std::vector<Si47xxRdsGroup> rds; //!< RDS groups sent by the station (FM), repeated forever
+} Si47xxStation;
+
+/**
+ * @brief Timing of the device (us). Defaults are close to the SI4735-D60 datasheet.
+ */
+typedef struct
+{
+    uint32_t command;      //!< CTS time of most commands
+    uint32_t property;     //!< CTS time of SET_PROPERTY and GET_PROPERTY
+    uint32_t powerUp;      //!< CTS time of POWER_UP
+    uint32_t powerDown;    //!< CTS time of POWER_DOWN
+    uint32_t tuneCts;      //!< CTS time of TUNE_FREQ and SEEK_START
+    uint32_t fmTune;       //!< STC time of FM_TUNE_FREQ
+    uint32_t amTune;       //!< STC time of AM_TUNE_FREQ (AM and SSB)
+    uint32_t fastTune;     //!< STC time of a tune with the FAST bit set (no AFC/ANTCAP settling; signal quality less accurate)
+    uint32_t fmSeekStep;   //!< Time to check one channel during an FM seek
+    uint32_t amSeekStep;   //!< Time to check one channel during an AM seek
+    uint32_t patchLine;    //!< CTS time of each 8 bytes patch line
+    uint32_t rdsSync;      //!< Time to get RDS synchronization after the tune
+    uint32_t rdsGroup;     //!< Time between RDS groups (104 bits at 1187.5 bps)
+    uint32_t rsqMeasure;   //!< Time between the RSQ measurements checked against the RSQ interrupt thresholds
+} Si47xxTiming;
+
+class Si47xxModel : public SimDevice
+{
+public:
+    Si47xxTiming timing;
+
+    uint32_t commands = 0;      //!< Commands executed
+    uint32_t errors = 0;        //!< Commands answered with ERR
+    uint32_t violations = 0;    //!< Protocol violations (see lastViolation)
+    uint32_t patchLines = 0;    //!< Patch lines accepted by the last patch download
+    uint32_t rdsGroupsLost = 0; //!< RDS groups discarded because the FIFO was full
+    uint32_t commandCount[256]; //!< Commands executed by opcode
+    char lastViolation[96];     //!< Description of the last protocol violation
+
+    // Antenna: the tuning capacitor selected automatically may be off for the antenna in use (a loop antenna, for example).
+    // Each antcapWidth capacitor units away from the best value cost 1 dB of RSSI and SNR (FM and LW/MW only; off while
+    // antcapError is 0). The band noise picked up by the antenna also peaks at the best value (up to 12 dB).
+    int16_t antcapError = 0;  //!< Best capacitor minus the automatic one (0 = the automatic value is the best)
+    uint16_t antcapWidth = 8; //!< Capacitor units per dB of loss
+
+    int8_t fade = 0; //!< dB added to the RSSI and SNR of every channel (negative = fading)
+
+    Si47xxModel(uint8_t resetPin, uint8_t interruptPin);
+
+    bool loadSpectrum(const char *fileName);
+    bool loadRdsGroups(const char *fileName, std::vector<Si47xxRdsGroup> &groups);
+    void addStation(const Si47xxStation &station);
+    const std::vector<Si47xxStation> &getStations() { return stations; }
+
+    bool isPowered() { return powered; }
+    bool isPatched() { return patched; }
+    bool isGpo2Enabled() { return gpo2Enabled; }
+    bool isCtsInterruptEnabled() { return ctsInterrupt; }
+    uint16_t getFrequency() { return frequency; }
+    uint16_t getProperty(uint16_t property);
+    bool isValidChannel(uint8_t band, uint16_t frequency);
+    void getSignal(uint8_t band, uint16_t frequency, uint8_t *rssi, uint8_t *snr, const Si47xxStation **station);
+    uint16_t getAutoAntcap(uint8_t band, uint16_t frequency);
+
+    // SimDevice
+    bool i2cWrite(const uint8_t *data, uint8_t size);
+    bool i2cRead(uint8_t *data, uint8_t size);
+    void pinWrite(uint8_t pin, uint8_t value);
+    uint64_t nextEvent();
+    void runEvents(uint64_t now);
+
+private:
+    uint8_t resetPin;
+    uint8_t interruptPin;
+    bool inReset = false;
+
+    bool powered = false;
+    bool patchMode = false;
+    bool patched = false;
+    uint8_t func = SI47XX_MODEL_FM;
+    bool gpo2Enabled = false;
+    bool ctsInterrupt = false;
+
+    uint8_t status = 0; // STCINT, RDSINT and ERR (the CTS depends on busyUntil)
+    uint8_t response[16];
+    uint64_t busyUntil = 0;
+    bool ctsPending = false;
+
+    std::map<uint16_t, uint16_t> properties;
+
+    uint16_t frequency = 0;
+    bool bandLimit = false;
+    bool valid = false;
+    uint8_t rssi = 0;
+    uint8_t snr = 0;
+    uint16_t antcap = 0;
+    uint64_t stcAt = SIM_NO_EVENT; // End of the tune or next seek step
+    bool seeking = false;
+    bool seekUp = true;
+    bool seekWrap = true;
+    uint16_t seekOrigin = 0;
+    uint8_t agcDisabled = 0;
+    uint8_t agcIndex = 0;
+    uint64_t rsqAt = SIM_NO_EVENT; // Next RSQ measurement (while an RSQ interrupt source is enabled)
+    uint8_t rsqFlags = 0;          // RSSILINT, RSSIHINT, SNRLINT and SNRHINT latched until the RSQ_STATUS INTACK
+
+    const Si47xxStation *rdsStation = NULL;
+    uint32_t rdsIndex = 0;
+    uint64_t rdsNextAt = SIM_NO_EVENT;
+    bool rdsSync = false;
+    bool rdsSyncFound = false;
+    bool rdsGroupLost = false;
+    std::vector<Si47xxRdsGroup> rdsFifo;
+
+    std::vector<Si47xxStation> stations;
+
+    void reset();
+    void powerDown();
+    void setDefaultProperties();
+    void violation(const char *message, uint8_t cmd);
+    void execute(const uint8_t *cmd, uint8_t size);
+    bool tune(uint8_t band, uint16_t freq, bool fast = false);
+    void seek(uint8_t band, bool up, bool wrap);
+    void seekStep();
+    void finishTune();
+    void pulse();
+    void armRsq();
+    void measureRsq();
+    uint8_t interruptEnable() { return (uint8_t)getProperty(0x0001); }
+};
+
+#endif
@@ -42,6 +42,64 @@
 
 #include <SI4735.h>
 
+/*
+ * Command timing defaults (see si47x_command_timing): expected completion (us), poll interval (us) and timeout (ms).
+ * For tune and seek commands, the values refer to the Seek/Tune Complete (STC) instead of the CTS.
+ * They are library-wide build flags: only this file uses them, so define them for the whole build (compiler -D
+ * option, PlatformIO build_flags etc), not before including SI4735.h in a sketch. At runtime, call setCommandTiming
+ * and setSweepTiming.
+ */
+#ifndef SI473X_TIMING_DEFAULT
+#define SI473X_TIMING_DEFAULT 200, 100, 100
+#endif
+#ifndef SI473X_TIMING_POWER_UP
+#define SI473X_TIMING_POWER_UP 1000, 500, 1500
+#endif
+#ifndef SI473X_TIMING_POWER_DOWN
+#define SI473X_TIMING_POWER_DOWN 2500, 250, 100
+#endif
+#ifndef SI473X_TIMING_SET_PROPERTY
+#define SI473X_TIMING_SET_PROPERTY 150, 100, 100
+#endif
+#ifndef SI473X_TIMING_FM_TUNE
+#define SI473X_TIMING_FM_TUNE 15000, 2000, 250
+#endif
+#ifndef SI473X_TIMING_AM_TUNE
+#define SI473X_TIMING_AM_TUNE 20000, 2000, 250
+#endif
+#ifndef SI473X_TIMING_NBFM_TUNE
+#define SI473X_TIMING_NBFM_TUNE 20000, 5000, 300
+#endif
+#ifndef SI473X_TIMING_SEEK
+#define SI473X_TIMING_SEEK 20000, 5000, 120 // Per seek step. The blocking seek waits up to maxSeekTime (see setMaxSeekTime)
+#endif
+#ifndef SI473X_SEEK_POLL_INTERVAL
+#define SI473X_SEEK_POLL_INTERVAL 30 // In ms - Interval between progress readings of the non-blocking seek (see seekTick)
+#endif
+
+#ifndef SI473X_TIMING_SWEEP
+#define SI473X_TIMING_SWEEP 2000, 500, 60 // STC of the FAST tunes used by the bandscope sweep (see startSweep)
+#endif
+
+#ifndef SI473X_STEP_ACCELERATION
+#define SI473X_STEP_ACCELERATION {0, 1}, {10, 2}, {20, 5}, {35, 10}, {60, 25}, {100, 100} // {minimum rate in detents per second, step multiplier}
+#endif
+
+static const si47x_step_acceleration defaultStepAcceleration[SI473X_STEP_ACCELERATION_SIZE] PROGMEM = {SI473X_STEP_ACCELERATION};
+
+// Library-wide command timing table, shared by the receivers without their own table (see setCommandTimingTable)
+static si47x_command_timing sharedCommandTiming[SI473X_COMMAND_TIMING_SIZE] = {
+    {0x00, SI473X_TIMING_DEFAULT, 0},
+    {POWER_UP, SI473X_TIMING_POWER_UP, 0},
+    {POWER_DOWN, SI473X_TIMING_POWER_DOWN, 0},
+    {SET_PROPERTY, SI473X_TIMING_SET_PROPERTY, 0},
+    {FM_TUNE_FREQ, SI473X_TIMING_FM_TUNE, 0},
+    {AM_TUNE_FREQ, SI473X_TIMING_AM_TUNE, 0},
+    {NBFM_TUNE_FREQ, SI473X_TIMING_NBFM_TUNE, 0},
+    {FM_SEEK_START, SI473X_TIMING_SEEK, 0},
+    {AM_SEEK_START, SI473X_TIMING_SEEK, 0}};
+static const si47x_command_timing defaultSweepTiming PROGMEM = {0x00, SI473X_TIMING_SWEEP, 0};
+
 /**
  * @brief Construct a new SI4735::SI4735
  *
@@ -57,14 +115,27 @@
  * The first byte is a command, and the next seven bytes are arguments. Writing more than 8 bytes results
  * in unpredictable device behavior". If you extend this library, remember the 8 byte restriction.
  */
+volatile uint8_t SI4735::interruptEdges = 0;
+
 SI4735::SI4735()
 {
     // 1 = LSB and 2 = USB; 0 = AM, FM or WB
     currentSsbStatus = 0;
+    interruptFlags.raw = 0;
+    asyncLastStatus.raw = 0;
+    commandTiming = sharedCommandTiming;
+    memcpy_P(&sweepTiming, &defaultSweepTiming, sizeof(sweepTiming));
+    asyncTiming = &commandTiming[0];
+    asyncPollInterval = commandTiming[0].pollInterval;
 }
 
 /** @defgroup group05 Deal with Interrupt and I2C bus */
 
+/** @defgroup group25 I2C transport
+ * @details All I2C traffic goes through SI4735Transport (see setTransport and setI2CBus). Without SI473X_TRANSPORT
+ *          (AVR default), it goes straight to Wire.
+ */
+
 /**
  * @ingroup group05 Interrupt
  *
@@ -82,17 +153,7 @@ SI4735::SI4735()
  */
 si47x_status SI4735::getInterruptStatus()
 {
-    si47x_status status;
-
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(GET_INT_STATUS);
-    Wire.endTransmission();
-
-    Wire.requestFrom(deviceAddress, 1);
-    status.raw = Wire.read();
-
-    return status;
+    return runCommand(GET_INT_STATUS, 0, NULL);
 }
 
 /**
@@ -126,12 +187,7 @@ void SI4735::setGpioCtl(uint8_t GPO1OEN, uint8_t GPO2OEN, uint8_t GPO3OEN)
     gpio.arg.DUMMY1 = 0;
     gpio.arg.DUMMY2 = 0;
 
-    waitToSend();
-
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(GPIO_CTL);
-    Wire.write(gpio.raw);
-    Wire.endTransmission();
+    runCommand(GPIO_CTL, 1, &gpio.raw);
 }
 
 /**
@@ -165,12 +221,7 @@ void SI4735::setGpio(uint8_t GPO1LEVEL, uint8_t GPO2LEVEL, uint8_t GPO3LEVEL)
     gpio.arg.DUMMY1 = 0;
     gpio.arg.DUMMY2 = 0;
 
-    waitToSend();
-
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(GPIO_SET);
-    Wire.write(gpio.raw);
-    Wire.endTransmission();
+    runCommand(GPIO_SET, 1, &gpio.raw);
 }
 
 /**
@@ -196,7 +247,7 @@ void SI4735::setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t
 {
     si473x_gpio_ien gpio;
 
-    gpio.arg.DUMMY1 = gpio.arg.DUMMY2 = gpio.arg.DUMMY3 = gpio.arg.DUMMY4 = 0;
+    gpio.raw = 0;
     gpio.arg.STCIEN = STCIEN;
     gpio.arg.RSQIEN = RSQIEN;
     gpio.arg.ERRIEN = ERRIEN;
@@ -207,6 +258,225 @@ void SI4735::setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t
     sendProperty(GPO_IEN, gpio.raw);
 }
 
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Sets the MCU pin connected to the GPO2/INT pin of the SI47XX and enables the interrupt mode.
+ *
+ * @details In interrupt mode, an ISR (interruptHandler) counts the pulses of the GPO2/INT pin. The library waits for
+ *          these pulses instead of sleeping a fixed time. For example, setFrequency and seekStation return as soon
+ *          as the Seek/Tune Complete (STC) interrupt arrives and the asynchronous engine (commandTick) checks the CTS
+ *          bit only when the device reports it.
+ * @details Call this function before setup. The GPO2/INT output and the CTS interrupt (POWER_UP command) and the
+ *          sources of the interrupt (GPO_IEN property) are configured every time the device is powered up.
+ * @details The ISR has no argument (attachInterrupt), so the pulse counter is shared by all SI4735 objects. Use the
+ *          interrupt mode on one receiver only: with two, a pulse of one device makes the other one read its status
+ *          too (no pulse is lost, but the bus traffic grows).
+ * @details The GPO2 pin is also used to select the bus mode during the reset of some devices (SI4730/SI4735).
+ *          Check your circuit before using this resource.
+ *
+ * @see setGpioIen, checkInterrupt, waitSeekTuneComplete, setInterruptCallback
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 64, 146
+ *
+ * @param pin MCU pin connected to the GPO2/INT pin. Use -1 to go back to polling mode.
+ * @param STCIEN Seek/Tune Complete Interrupt Enable (0 or 1).
+ * @param RSQIEN RSQ Interrupt Enable (0 or 1).
+ * @param RDSIEN RDS Interrupt Enable (0 or 1). FM only.
+ * @param CTSIEN CTS Interrupt Enable (0 or 1).
+ */
+void SI4735::setInterruptPin(int8_t pin, uint8_t STCIEN, uint8_t RSQIEN, uint8_t RDSIEN, uint8_t CTSIEN)
+{
+    si473x_gpio_ien gpio;
+
+    if (interruptPin >= 0)
+        detachInterrupt(digitalPinToInterrupt(interruptPin));
+
+    interruptPin = pin;
+    interruptFlags.raw = 0;
+    if (pin < 0)
+        return;
+
+    gpio.raw = 0;
+    gpio.arg.STCIEN = STCIEN;
+    gpio.arg.RSQIEN = RSQIEN;
+    gpio.arg.RDSIEN = RDSIEN;
+    gpio.arg.CTSIEN = CTSIEN;
+    interruptSources = gpio.raw;
+
+    this->ctsIntEnable = CTSIEN;
+    this->gpo2Enable = 1;
+
+    pinMode(pin, INPUT);
+    interruptEdgesSeen = interruptEdges;
+    attachInterrupt(digitalPinToInterrupt(pin), interruptHandler, FALLING); // INT is active low
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief ISR used to count the pulses of the GPO2/INT pin.
+ *
+ * @details It just counts the pulses. The I2C bus is never used inside the ISR. The counter is shared by all SI4735
+ *          objects (see setInterruptPin).
+ * @details You can call this function from your own ISR if you need to share the interrupt.
+ */
+void SI473X_ISR_ATTR SI4735::interruptHandler()
+{
+    interruptEdges++;
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Processes the pulses counted by the ISR (non-blocking).
+ *
+ * @details If there is a new pulse of the GPO2/INT pin, reads the status byte and latches the STCINT, RDSINT, RSQINT and ERR bits.
+ * @details The latched bits can be read by getInterruptFlags. If a callback was set (setInterruptCallback), it is called.
+ *
+ * @return true if a new interrupt was processed.
+ */
+bool SI4735::checkInterrupt()
+{
+    if (interruptPin < 0 || interruptEdgesSeen == interruptEdges)
+        return false;
+
+    interruptEdgesSeen = interruptEdges;
+    latchInterrupt(readStatus());
+    return true;
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Latches the interrupt bits of a status byte read after an INT pulse and calls the interrupt callback.
+ *
+ * @param status status byte (from a status read or from the first byte of a response)
+ */
+void SI4735::latchInterrupt(si47x_status status)
+{
+    interruptStatus = status;
+    status.raw &= 0B01001101; // ERR, RSQINT, RDSINT and STCINT
+    interruptFlags.raw |= status.raw;
+
+    if (onInterrupt != NULL && status.raw != 0)
+        onInterrupt(status);
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Waits for the next pulse of the GPO2/INT pin.
+ *
+ * @details In polling mode (see setInterruptPin), just waits for the CTS.
+ * @details The wait is limited by the timeout of the default entry of the command timing table (see getLastError).
+ */
+void SI4735::waitInterrupr()
+{
+    if (interruptPin < 0)
+    {
+        waitToSend();
+        return;
+    }
+    uint32_t start = millis();
+
+    while (!checkInterrupt())
+    {
+        if ((millis() - start) > commandTiming[0].timeout)
+        {
+            setError(SI473X_ERROR_TIMEOUT, 0);
+            return;
+        }
+        commandTick();
+    }
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Waits for the Seek/Tune Complete (STC) of the last tune or seek command.
+ *
+ * @details The wait follows the command timing table entry of the tune or seek command (see si47x_command_timing).
+ *          In polling mode, the STC bit of the status byte is checked after the expected time and then at every poll interval.
+ *          In interrupt mode (see setInterruptPin), returns as soon as the STC interrupt arrives (the status byte is not polled).
+ * @details After the STC, the interrupt is acknowledged. In polling mode, the current status (frequency, etc) is updated
+ *          too (see getStatus). In interrupt mode, the STC was already read by checkInterrupt: the acknowledge is queued
+ *          without response (call getStatus or getFrequency if you need the status).
+ * @details The queued asynchronous commands are processed while waiting.
+ *
+ * @param timeout maximum time (ms) to wait. Use 0 to use the timeout of the command timing table.
+ *
+ * @return true if the STC arrived.
+ */
+bool SI4735::waitSeekTuneComplete(uint16_t timeout)
+{
+    si47x_command_timing *timing = (seekTuneTiming != NULL) ? seekTuneTiming : &commandTiming[0];
+    uint16_t poll = timing->pollInterval;
+    unsigned long start = micros();
+    unsigned long last = start - poll;
+    unsigned long now, elapsed;
+    bool stc = false;
+
+    if (timeout == 0)
+        timeout = timing->timeout;
+
+    do
+    {
+        commandTick();
+        now = micros();
+        elapsed = now - start;
+        if (useStcInterrupt())
+        {
+            checkInterrupt();
+            stc = interruptFlags.refined.STCINT;
+        }
+        else if (elapsed >= timing->expected && (now - last) >= poll)
+        {
+            last = now;
+            stc = readStatus().refined.STCINT;
+            if (!stc && poll < (timing->pollInterval << 2)) // Backoff
+                poll += poll >> 1;
+        }
+    } while (!stc && elapsed < (uint32_t)timeout * 1000);
+
+    if (!stc)
+    {
+        if (errorStats != NULL)
+            errorStats->stcTimeouts++;
+        setError(SI473X_ERROR_TIMEOUT, 0);
+        return false;
+    }
+
+    updateCommandTiming(timing, elapsed);
+    if (interruptFlags.refined.STCINT)
+        acknowledgeSeekTune(); // Latched by checkInterrupt: the status is not read again
+    else
+        getStatus(1, 0); // Acknowledges the STC interrupt
+    interruptFlags.refined.STCINT = 0;
+    return true;
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Prepares the library for a tune or seek command.
+ *
+ * @details Selects the timing of the command and acknowledges an STC of a previous command, so it is not taken as the new one.
+ *          With the STC interrupt, a previous STC has already been latched by checkInterrupt, so the status is not read.
+ *
+ * @param cmd tune or seek command number
+ */
+void SI4735::prepareSeekTune(uint8_t cmd)
+{
+    seekTuneTiming = findCommandTiming(cmd);
+
+    checkInterrupt();
+    if (interruptFlags.refined.STCINT || (!useStcInterrupt() && readStatus().refined.STCINT))
+    {
+        getStatus(1, 0);
+        interruptFlags.refined.STCINT = 0;
+    }
+}
+
 /**
  * @ingroup group05 I2C bus address
  *
@@ -230,10 +500,9 @@ int16_t SI4735::getDeviceI2CAddress(uint8_t resetPin)
 
     reset();
 
-    Wire.begin();
+    i2cBegin();
     // check 0X11 I2C address
-    Wire.beginTransmission(SI473X_ADDR_SEN_LOW);
-    error = Wire.endTransmission();
+    error = i2cWrite(SI473X_ADDR_SEN_LOW, NULL, 0);
     if (error == 0)
     {
         setDeviceI2CAddress(0);
@@ -241,8 +510,7 @@ int16_t SI4735::getDeviceI2CAddress(uint8_t resetPin)
     }
 
     // check 0X63 I2C address
-    Wire.beginTransmission(SI473X_ADDR_SEN_HIGH);
-    error = Wire.endTransmission();
+    error = i2cWrite(SI473X_ADDR_SEN_HIGH, NULL, 0);
     if (error == 0)
     {
         setDeviceI2CAddress(1);
@@ -307,6 +575,10 @@ void SI4735::reset()
     delay(10);
     digitalWrite(resetPin, HIGH);
     delay(10);
+    invalidatePropertyCache();
+    propertyBatchCount = 0; // The reset clears the properties (see beginProperties)
+    poweredUp = false;
+    deviceReady = false;
 }
 
 /**
@@ -315,16 +587,65 @@ void SI4735::reset()
  * @brief  Wait for the si473x is ready (Clear to Send (CTS) status bit have to be 1).
  *
  * @details This function should be used before sending any command to a SI47XX device.
+ * @details If there are commands in the asynchronous queue, they are processed (completed) first.
+ * @details The wait is limited by the timeout of the default entry of the command timing table (see getLastError).
  *
  * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 63, 128
+ * @see isClearToSend, flushCommands
  */
 void SI4735::waitToSend()
 {
-    do
+    uint32_t start = millis();
+
+    flushCommands();
+    while (!isClearToSend())
     {
-        delayMicroseconds(MIN_DELAY_WAIT_SEND_LOOP); // Need check the minimum value.
-        Wire.requestFrom(deviceAddress, 1);
-    } while (!(Wire.read() & 0B10000000));
+        if ((millis() - start) > commandTiming[0].timeout)
+        {
+            setError(SI473X_ERROR_TIMEOUT, 0);
+            return;
+        }
+        delayMicroseconds(commandTiming[0].pollInterval);
+    }
+}
+
+/**
+ * @ingroup group06 Wait to send command
+ *
+ * @brief Checks the Clear to Send (CTS) status bit once.
+ *
+ * @details Unlike waitToSend, this function does not block. It reads just the status byte of the device.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 63, 128
+ * @see waitToSend
+ *
+ * @return true if the device is ready to receive the next command.
+ */
+bool SI4735::isClearToSend()
+{
+    return readStatus().refined.CTS;
+}
+
+/**
+ * @ingroup group06 Wait to send command
+ *
+ * @brief Reads the status byte of the device without sending a command.
+ *
+ * @return si47x_status
+ */
+si47x_status SI4735::readStatus()
+{
+    si47x_status status;
+
+    if (i2cRead(deviceAddress, &status.raw, 1) != 1)
+    {
+        if (errorStats != NULL)
+            errorStats->busErrors++;
+        status.raw = 0; // No CTS
+    }
+    deviceReady = status.refined.CTS;
+
+    return status;
 }
 
 /** @defgroup group07 Device Setup and Start up */
@@ -408,16 +729,12 @@ void SI4735::setPowerUp(uint8_t CTSIEN, uint8_t GPO2OEN, uint8_t PATCH, uint8_t
  */
 void SI4735::radioPowerUp(void)
 {
-    // delayMicroseconds(1000);
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(POWER_UP);
-    Wire.write(powerUp.raw[0]); // Content of ARG1
-    Wire.write(powerUp.raw[1]); // COntent of ARG2
-    Wire.endTransmission();
+    // ARG1 and ARG2 are stored in powerUp.raw
+    runCommand(POWER_UP, 2, powerUp.raw);
+    poweredUp = true;
+    audioMuted = false; // RX_HARD_MUTE is 0 after the power up
     // Delay at least 500 ms between powerup command and first tune command to wait for
     // the oscillator to stabilize if XOSCEN is set and crystal is used as the RCLK.
-    waitToSend();
     delay(maxDelayAfterPouwerUp);
 
     // Turns the external mute circuit off
@@ -429,6 +746,10 @@ void SI4735::radioPowerUp(void)
         setRefClock(this->refClock);
         setRefClockPrescaler(this->refClockPrescale, this->refClockSourcePin);
     }
+
+    // The interrupt sources have to be configured after every power up (see setInterruptPin)
+    if (interruptPin >= 0)
+        sendProperty(GPO_IEN, interruptSources);
 }
 
 /**
@@ -462,11 +783,10 @@ void SI4735::powerDown(void)
     if (audioMuteMcuPin >= 0)
         setHardwareAudioMute(true);
 
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(POWER_DOWN);
-    Wire.endTransmission();
-    delayMicroseconds(2500);
+    cancelTune(); // The STC of a coalesced tune in progress is acknowledged before the power down
+
+    runCommand(POWER_DOWN, 0, NULL); // See SI473X_TIMING_POWER_DOWN
+    poweredUp = false;
 }
 
 /**
@@ -480,20 +800,13 @@ void SI4735::powerDown(void)
  */
 void SI4735::getFirmware(void)
 {
-    waitToSend();
-
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(GET_REV);
-    Wire.endTransmission();
+    // Request for 9 bytes response
+    uint8_t retry = 0;
 
     do
     {
-        waitToSend();
-        // Request for 9 bytes response
-        Wire.requestFrom(deviceAddress, 9);
-        for (int i = 0; i < 9; i++)
-            firmwareInfo.raw[i] = Wire.read();
-    } while (firmwareInfo.resp.ERR);
+        runCommand(GET_REV, 0, NULL, 9, firmwareInfo.raw);
+    } while (firmwareInfo.resp.ERR && retryCommand(retry));
 }
 
 /**
@@ -578,11 +891,14 @@ void SI4735::setRefClockPrescaler(uint16_t prescale, uint8_t rclk_sel)
  */
 void SI4735::setup(uint8_t resetPin, uint8_t ctsIntEnable, uint8_t defaultFunction, uint8_t audioMode, uint8_t clockType, uint8_t gpo2Enable)
 {
-    Wire.begin();
+    i2cBegin();
 
     this->resetPin = resetPin;
-    this->ctsIntEnable = (ctsIntEnable != 0) ? 1 : 0; // Keeps old versions of the sketches running
-    this->gpo2Enable = gpo2Enable;
+    if (interruptPin < 0) // In interrupt mode, setInterruptPin defines the CTSIEN and GPO2OEN values
+    {
+        this->ctsIntEnable = (ctsIntEnable != 0) ? 1 : 0; // Keeps old versions of the sketches running
+        this->gpo2Enable = gpo2Enable;
+    }
     this->currentAudioMode = audioMode;
 
     // Set the initial SI473X behavior
@@ -592,7 +908,7 @@ void SI4735::setup(uint8_t resetPin, uint8_t ctsIntEnable, uint8_t defaultFuncti
     // XOSCEN   clockType -> Use external crystal oscillator (XOSCEN_CRYSTAL) or reference clock (XOSCEN_RCLK);
     // FUNC     defaultFunction = 0 = FM Receive; 1 = AM (LW/MW/SW) Receiver.
     // OPMODE   SI473X_ANALOG_AUDIO or SI473X_DIGITAL_AUDIO.
-    setPowerUp(ctsIntEnable, gpo2Enable, 0, clockType, defaultFunction, audioMode);
+    setPowerUp(this->ctsIntEnable, this->gpo2Enable, 0, clockType, defaultFunction, audioMode);
 
     if (audioMuteMcuPin >= 0)
         setHardwareAudioMute(true); // If you are using external citcuit to mute the audio, it turns the audio mute
@@ -646,6 +962,20 @@ void SI4735::setup(uint8_t resetPin, uint8_t defaultFunction)
  *                  According to Silicon Labs, automatic capacitor tuning is recommended (value 0).
  */
 void SI4735::setTuneFrequencyAntennaCapacitor(uint16_t capacitor)
+{
+    setAntennaCapacitorArguments(capacitor);
+    // Tune the device again with the current frequency.
+    this->setFrequency(this->currentWorkFrequency);
+}
+
+/**
+ * @ingroup   group08 Internal Antenna Tuning capacitor
+ *
+ * @brief Sets the tuning capacitor of the next TUNE_FREQ commands (currentFrequencyParams) without tuning.
+ *
+ * @param capacitor 0 = automatic; FM 1 to 191; AM 1 to 6143 (see setTuneFrequencyAntennaCapacitor)
+ */
+void SI4735::setAntennaCapacitorArguments(uint16_t capacitor)
 {
     si47x_antenna_capacitor cap;
 
@@ -667,8 +997,6 @@ void SI4735::setTuneFrequencyAntennaCapacitor(uint16_t capacitor)
             currentFrequencyParams.arg.ANTCAPL = cap.raw.ANTCAPL;
         }
     }
-    // Tune the device again with the current frequency.
-    this->setFrequency(this->currentWorkFrequency);
 }
 
 /**
@@ -687,7 +1015,25 @@ void SI4735::setTuneFrequencyAntennaCapacitor(uint16_t capacitor)
  */
 void SI4735::setFrequency(uint16_t freq)
 {
-    waitToSend(); // Wait for the si473x is ready.
+    cancelTune(); // A blocking tune replaces the coalesced ones (see requestFrequency)
+    setTuneArguments(freq);
+    prepareSeekTune(currentTune);
+    // ARG1 (FAST and FREEZE), FREQH, FREQL and ANTCAPH. If current tune is not FM sends one more byte (ANTCAPL)
+    runCommand(currentTune, (currentTune == AM_TUNE_FREQ) ? 5 : 4, currentFrequencyParams.raw);
+    currentWorkFrequency = freq; // check it
+    if (!waitSeekTuneComplete())
+        delay(maxDelaySetFrequency); // The STC did not come in time.
+}
+
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Sets the arguments of the TUNE_FREQ command (currentFrequencyParams) for a given frequency.
+ *
+ * @param freq frequency (FM => 10 kHz units; AM and SSB => kHz)
+ */
+void SI4735::setTuneArguments(uint16_t freq)
+{
     currentFrequency.value = freq;
     currentFrequencyParams.arg.FREQH = currentFrequency.raw.FREQH;
     currentFrequencyParams.arg.FREQL = currentFrequency.raw.FREQL;
@@ -699,21 +1045,68 @@ void SI4735::setFrequency(uint16_t freq)
         currentFrequencyParams.arg.FAST = 1;                  // Used just on AM and FM
         currentFrequencyParams.arg.FREEZE = 0;                // Used just on FM
     }
+    else
+        currentFrequencyParams.arg.USBLSB = 0; // AM after SSB: the device has no patch anymore (the SSB bits are invalid)
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(currentTune);
-    Wire.write(currentFrequencyParams.raw[0]); // Send a byte with FAST and  FREEZE information; if not FM must be 0;
-    Wire.write(currentFrequencyParams.arg.FREQH);
-    Wire.write(currentFrequencyParams.arg.FREQL);
-    Wire.write(currentFrequencyParams.arg.ANTCAPH);
-    // If current tune is not FM sent one more byte
-    if (currentTune == AM_TUNE_FREQ) // if AM or SSB
-        Wire.write(currentFrequencyParams.arg.ANTCAPL);
+    if (antcapTable != NULL && currentTune == antcapTableTune)
+        setAntennaCapacitorArguments(lookupAntennaCapacitor(freq));
+}
 
-    Wire.endTransmission();
-    waitToSend();                // Wait for the si473x is ready.
-    currentWorkFrequency = freq; // check it
-    delay(maxDelaySetFrequency); // For some reason I need to delay here.
+/**
+ * @ingroup group08 Tune Frequency
+ *
+ * @brief Queues the TUNE_FREQ command of the current mode (FM, AM, SSB or NBFM) for a given frequency.
+ *
+ * @details The FAST bit is used just for this tune; the one set by the user is kept (see setTuneArguments).
+ *          Call prepareSeekTune before and check the STC with pollSeekTuneComplete.
+ *
+ * @param freq frequency (current band units)
+ * @param fast 1 = tunes with the FAST bit set (shorter STC, signal quality less accurate). Not used on NBFM.
+ *
+ * @return uint8_t handle of the command or 0 if the queue is full.
+ */
+uint8_t SI4735::sendTuneAsync(uint16_t freq, uint8_t fast)
+{
+    uint8_t handle;
+    uint8_t savedFast;
+
+    if (currentTune == NBFM_TUNE_FREQ)
+    {
+        uint8_t arg[3];
+        currentFrequency.value = freq;
+        arg[0] = 0x00; // No FAST and FREEZE on NBFM (see setFrequencyNBFM)
+        arg[1] = currentFrequency.raw.FREQH;
+        arg[2] = currentFrequency.raw.FREQL;
+        return sendCommandAsync(NBFM_TUNE_FREQ, 3, arg);
+    }
+
+    setTuneArguments(freq);
+    savedFast = currentFrequencyParams.arg.FAST;
+    currentFrequencyParams.arg.FAST = fast;
+    handle = sendCommandAsync(currentTune, (currentTune == AM_TUNE_FREQ) ? 5 : 4, currentFrequencyParams.raw);
+    currentFrequencyParams.arg.FAST = savedFast; // The arguments were copied to the queue
+    return handle;
+}
+
+/**
+ * @ingroup group08 Received Signal Quality
+ *
+ * @brief Queues the RSQ_STATUS command of the current mode (no INTACK). The response goes to currentRqsStatus.
+ *
+ * @details Used after the STC of a FAST tune: the TUNE_STATUS of such a tune has a rough RSSI and SNR, the RSQ_STATUS
+ *          has the ones measured after the tune settled.
+ *
+ * @return uint8_t handle of the command or 0 if the queue is full.
+ */
+uint8_t SI4735::sendRsqAsync()
+{
+    uint8_t arg = 0;
+
+    if (currentTune == FM_TUNE_FREQ)
+        return sendCommandAsync(FM_RSQ_STATUS, 1, &arg, 8, currentRqsStatus.raw);
+    if (currentTune == NBFM_TUNE_FREQ)
+        return sendCommandAsync(NBFM_RSQ_STATUS, 1, &arg, 8, currentRqsStatus.raw);
+    return sendCommandAsync(AM_RSQ_STATUS, 1, &arg, 6, currentRqsStatus.raw);
 }
 
 /**
@@ -730,7 +1123,10 @@ void SI4735::frequencyUp()
     else
         currentWorkFrequency += currentStep;
 
-    setFrequency(currentWorkFrequency);
+    if (tuneState != NULL)
+        requestFrequency(currentWorkFrequency);
+    else
+        setFrequency(currentWorkFrequency);
 }
 
 /**
@@ -748,69 +1144,708 @@ void SI4735::frequencyDown()
     else
         currentWorkFrequency -= currentStep;
 
-    setFrequency(currentWorkFrequency);
+    if (tuneState != NULL)
+        requestFrequency(currentWorkFrequency);
+    else
+        setFrequency(currentWorkFrequency);
 }
 
 /**
- * @ingroup group08 Set mode and Band
+ * @defgroup group28 Tune coalescing
  *
- * @todo Adjust the power up parameters
+ * @section group28 Tune coalescing
  *
- * @brief Sets the radio to AM function. It means: LW MW and SW.
+ * @brief Non-blocking tune where only the latest requested frequency matters.
+ * @details When the user turns the encoder fast, a blocking setFrequency per step makes the receiver lag behind the knob.
+ *          requestFrequency just records the new frequency (getCurrentFrequency returns it at once, so the display can
+ *          follow the knob) and tuneTick sends it when the device has finished the previous tune (STC). The steps
+ *          requested in between are skipped, so the latency does not grow with the number of steps.
+ * @details The state of the coalesced tune is kept in a si47x_tune_state declared by the sketch. With setTuneCoalescing,
+ *          frequencyUp, frequencyDown and encoderTune work this way. Without it, they use the blocking setFrequency.
+ * @code
+ *   si47x_tune_state tuneState;
  *
- * @details Define the band range you want to use for the AM mode.
+ *   void setup() {
+ *      rx.setup(RESET_PIN, FM_FUNCTION);
+ *      rx.setFM(8400, 10800, 10390, 10);
+ *      rx.setTuneCoalescing(&tuneState);
+ *   }
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 129.
+ *   void loop() {
+ *      if (encoderCount > 0) rx.frequencyUp();
+ *      else if (encoderCount < 0) rx.frequencyDown();
+ *      rx.tuneTick();
+ *      showFrequency(rx.getCurrentFrequency());
+ *   }
+ * @endcode
  */
-void SI4735::setAM()
+
+/**
+ * @ingroup group28 Tune coalescing
+ *
+ * @brief Requests a new frequency without waiting for the device.
+ *
+ * @details If the device is not tuning, the TUNE_FREQ command is queued at once. Otherwise the frequency replaces the
+ *          one waiting (if any) and is sent by tuneTick after the STC of the current tune.
+ * @details The current frequency (getCurrentFrequency) is updated immediately.
+ * @details Without setTuneCoalescing or without a command queue (setCommandQueue), the frequency is tuned by the blocking setFrequency.
+ *
+ * @see tuneTick, flushTune, setTuneCoalescing
+ *
+ * @param freq frequency (FM => 10 kHz units; AM and SSB => kHz)
+ */
+void SI4735::requestFrequency(uint16_t freq)
 {
-    // If you’re already using AM mode, it is not necessary to call powerDown and radioPowerUp.
-    // The other properties also should have the same value as the previous status.
-    if (lastMode != AM_CURRENT_MODE)
+    if (tuneState == NULL || asyncQueueSize == 0)
     {
-        powerDown();
-        setPowerUp(this->ctsIntEnable, 0, 0, this->currentClockType, AM_CURRENT_MODE, this->currentAudioMode);
-        radioPowerUp();
-        setAvcAmMaxGain(currentAvcAmMaxGain); // Set AM Automatic Volume Gain (default value is DEFAULT_CURRENT_AVC_AM_MAX_GAIN)
-        setVolume(volume);                    // Set to previus configured volume
+        setFrequency(freq);
+        return;
     }
-    currentSsbStatus = 0;
-    lastMode = AM_CURRENT_MODE;
+    if (tuneState->target != 0)
+        tuneState->coalesced++;
+    tuneState->target = freq;
+    currentWorkFrequency = freq;
+    tuneTick();
 }
 
 /**
- * @ingroup group08 Set mode and Band
+ * @ingroup group28 Tune coalescing
  *
- * @todo Adjust the power up parameters
+ * @brief Makes frequencyUp, frequencyDown and encoderTune non-blocking (see requestFrequency and tuneTick).
  *
- * @brief Sets the radio to FM function
+ * @details Call tuneTick in your loop function. The state is cleared. NULL finishes the tune in progress and goes back
+ *          to the blocking setFrequency (the default). The coalescing needs a command queue (see setCommandQueue).
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 64.
+ * @param state tune coalescing state declared by the sketch (it has to be valid while it is in use) or NULL
  */
-void SI4735::setFM()
+void SI4735::setTuneCoalescing(si47x_tune_state *state)
 {
-    powerDown();
-    setPowerUp(this->ctsIntEnable, this->gpo2Enable, 0, this->currentClockType, FM_CURRENT_MODE, this->currentAudioMode);
-    radioPowerUp();
-    setVolume(volume); // Set to previus configured volume
-    currentSsbStatus = 0;
-    disableFmDebug();
-    lastMode = FM_CURRENT_MODE;
+    cancelTune();
+    if (state != NULL)
+        memset(state, 0, sizeof(si47x_tune_state));
+    tuneState = state;
 }
 
 /**
- * @ingroup group08 Set mode and Band
+ * @ingroup group28 Tune coalescing
  *
- * @brief Sets the radio to AM (LW/MW/SW) function.
- *
- * @details The example below sets the band from 550kHz to 1750kHz on AM mode. The band will start on 810kHz and step is 10kHz.
+ * @brief Advances the coalesced tune.
  *
- * @code
- * si4735.setAM(520, 1750, 810, 10);
- * @endcode
+ * @details Call this function as often as possible (in the loop function). It never waits for the device.
+ * @details Checks the STC of the current tune (following the command timing table, or the STC interrupt in interrupt mode)
+ *          and, when the tune is done, sends the latest requested frequency. A tune without STC is given up after
+ *          the timeout of its timing table entry (see getLastError).
  *
- * @see setFM()
- * @see setSSB()
+ * @return true while there is a tune in progress or waiting.
+ */
+bool SI4735::tuneTick()
+{
+    if (tuneState == NULL)
+        return false;
+
+    if (tuneState->busy)
+    {
+        commandTick();
+        if (!isCommandDone(tuneState->handle) || !pollSeekTuneComplete(seekTuneTiming, tuneState->sentAt, tuneState->lastPoll, tuneState->pollInterval))
+            return true;
+        tuneState->busy = false;
+    }
+
+    if (tuneState->target != 0)
+        startTune();
+
+    return tuneState->busy || tuneState->target != 0;
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Checks once (non-blocking) if a tune sent by the asynchronous engine is complete (STC).
+ *
+ * @details Non-blocking version of waitSeekTuneComplete used by tuneTick and sweepTick. In polling mode, the STC bit is
+ *          checked after the expected time and then at every poll interval (with backoff). In interrupt mode, only the
+ *          STC interrupt is used. After the STC, the interrupt is acknowledged (see getStatus).
+ *
+ * @param timing timing table entry of the tune
+ * @param sentAt time (us) the tune was queued
+ * @param lastPoll last time (us) the STC was checked (updated here)
+ * @param pollInterval current interval (us) between checks (updated here)
+ * @param tuneStatus true = the STC is acknowledged by getStatus (currentStatus updated); false = by a queued
+ *                   TUNE_STATUS without response (see acknowledgeSeekTune), for callers that measure with RSQ_STATUS
+ *
+ * @return true if the tune is finished: STC (getLastError() == SI473X_OK) or timeout (SI473X_ERROR_TIMEOUT).
+ */
+bool SI4735::pollSeekTuneComplete(si47x_command_timing *timing, unsigned long sentAt, unsigned long &lastPoll, uint16_t &pollInterval, bool tuneStatus)
+{
+    unsigned long now = micros();
+    unsigned long elapsed = now - sentAt;
+    bool stc = false;
+
+    if (useStcInterrupt())
+    {
+        checkInterrupt();
+        stc = interruptFlags.refined.STCINT;
+    }
+    else if (elapsed >= timing->expected && (now - lastPoll) >= pollInterval)
+    {
+        lastPoll = now;
+        stc = readStatus().refined.STCINT;
+        if (!stc && pollInterval < (timing->pollInterval << 2)) // Backoff
+            pollInterval += pollInterval >> 1;
+    }
+
+    if (!stc)
+    {
+        if (elapsed < (uint32_t)timing->timeout * 1000)
+            return false;
+        if (errorStats != NULL)
+            errorStats->stcTimeouts++;
+        setError(SI473X_ERROR_TIMEOUT, 0);
+        return true;
+    }
+
+    updateCommandTiming(timing, elapsed);
+    interruptFlags.refined.STCINT = 0;
+    if (tuneStatus)
+        getStatus(1, 0); // Acknowledges the STC interrupt
+    else
+        acknowledgeSeekTune();
+    return true;
+}
+
+/**
+ * @ingroup group05 Interrupt
+ *
+ * @brief Acknowledges the STC interrupt with a TUNE_STATUS (INTACK) queued without response.
+ *
+ * @details The status byte is enough: the signal quality of a FAST tune is read with RSQ_STATUS after it (see sendRsqAsync).
+ *          If the asynchronous queue is full, the command is run at once.
+ */
+void SI4735::acknowledgeSeekTune()
+{
+    uint8_t intack = 1;
+    uint8_t cmd = AM_TUNE_STATUS;
+
+    if (currentTune == FM_TUNE_FREQ)
+        cmd = FM_TUNE_STATUS;
+    else if (currentTune == NBFM_TUNE_FREQ)
+        cmd = NBFM_TUNE_STATUS;
+
+    if (sendCommandAsync(cmd, 1, &intack) == 0)
+        runCommand(cmd, 1, &intack);
+}
+
+/**
+ * @ingroup group28 Tune coalescing
+ *
+ * @brief Queues the TUNE_FREQ command for the latest requested frequency.
+ *
+ * @details If the asynchronous queue is full, the frequency stays waiting for the next tuneTick.
+ */
+void SI4735::startTune()
+{
+    prepareSeekTune(currentTune);
+
+    tuneState->handle = sendTuneAsync(tuneState->target, currentFrequencyParams.arg.FAST);
+    if (tuneState->handle == 0)
+    {
+        commandTick(); // Queue full. Tries again on the next tuneTick.
+        return;
+    }
+
+    tuneState->target = 0;
+    tuneState->busy = true;
+    tuneState->sentAt = micros();
+    tuneState->pollInterval = seekTuneTiming->pollInterval;
+    tuneState->lastPoll = tuneState->sentAt - tuneState->pollInterval;
+    commandTick();
+}
+
+/**
+ * @ingroup group28 Tune coalescing
+ *
+ * @brief Waits until the latest requested frequency is tuned (or given up).
+ *
+ * @details Use it before a function that needs the final frequency (seek, RSQ status, band switch etc).
+ */
+void SI4735::flushTune()
+{
+    while (tuneTick())
+        ;
+}
+
+/**
+ * @defgroup group29 Encoder tuning
+ *
+ * @section group29 Encoder tuning
+ *
+ * @brief Tuning with step acceleration driven by the encoder speed.
+ * @details encoderTune receives the detents counted by your encoder code and the time of the reading. The faster the
+ *          encoder turns, the larger the step (see si47x_step_acceleration and SI473X_STEP_ACCELERATION). The step is
+ *          always a multiple of currentStep and the frequency lands on the grid of the step, so a fast spin crosses a
+ *          whole SW band with a few tunes. A pause longer than SI473X_ENCODER_IDLE ms or a change of direction goes
+ *          back to the normal step.
+ * @details The acceleration is kept in a si47x_encoder_state declared by the sketch (see setEncoderAcceleration).
+ *          Without it, each detent moves the frequency by currentStep.
+ * @details The new frequency is tuned like frequencyUp / frequencyDown: with setTuneCoalescing, only the latest
+ *          frequency is sent to the device (call tuneTick in your loop function).
+ * @code
+ *   volatile int encoderCount = 0; // Updated by the encoder ISR
+ *   si47x_encoder_state encoderState;
+ *   ...
+ *   rx.setEncoderAcceleration(&encoderState); // In the setup function
+ *
+ *   void loop() {
+ *      if (encoderCount != 0) {
+ *          noInterrupts();
+ *          int delta = encoderCount;
+ *          encoderCount = 0;
+ *          interrupts();
+ *          showFrequency(rx.encoderTune(delta));
+ *      }
+ *      rx.tuneTick();
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group29 Encoder tuning
+ *
+ * @brief Moves the frequency by a number of encoder detents, with a step that follows the encoder speed.
+ *
+ * @details The encoder rate (detents per second) is measured from the interval between calls and smoothed.
+ *          The step is currentStep times the multiplier of the fastest entry of the acceleration table reached by the rate.
+ * @details Going up, the frequency moves to the next multiple of the step (from currentMinimumFrequency); going down,
+ *          to the previous one. At the band limits it stops at the limit and wraps around on the next movement, like
+ *          frequencyUp and frequencyDown.
+ *
+ * @see setEncoderAcceleration, setEncoderAccelerationLevel, getEncoderRate, getEncoderStep
+ *
+ * @param delta detents moved since the last call (positive = up; negative = down)
+ * @param timestamp time of the reading in ms (example: millis())
+ *
+ * @return uint16_t the new frequency (same as getCurrentFrequency)
+ */
+uint16_t SI4735::encoderTune(int16_t delta, uint32_t timestamp)
+{
+    int8_t direction = (delta > 0) ? 1 : -1;
+    uint16_t detents = (delta > 0) ? delta : -delta;
+    uint32_t interval, rate, offset, position;
+    uint16_t step;
+    uint8_t multiplier = 1;
+    int32_t freq;
+
+    if (delta == 0)
+        return currentWorkFrequency;
+
+    if (encoderState != NULL)
+    {
+        // Velocity: detents per second, smoothed (the encoder readings are irregular)
+        interval = timestamp - encoderState->lastTime;
+        if (interval >= SI473X_ENCODER_IDLE || direction != encoderState->direction)
+            encoderState->rate = 0;
+        else
+        {
+            rate = (uint32_t)detents * 1000 / ((interval > 0) ? interval : 1);
+            if (rate > 0xFFFF)
+                rate = 0xFFFF;
+            encoderState->rate = (encoderState->rate == 0) ? rate : (uint16_t)((encoderState->rate + rate) >> 1);
+        }
+        encoderState->lastTime = timestamp;
+        encoderState->direction = direction;
+
+        for (uint8_t i = 0; i < SI473X_STEP_ACCELERATION_SIZE; i++)
+        {
+            if (encoderState->rate >= encoderState->level[i].rate && encoderState->level[i].multiplier > 0)
+                multiplier = encoderState->level[i].multiplier;
+        }
+    }
+    step = currentStep * multiplier;
+    if (step == 0 || step > (currentMaximumFrequency - currentMinimumFrequency))
+        step = (currentStep > 0) ? currentStep : 1;
+    if (encoderState != NULL)
+        encoderState->step = step;
+
+    // Quantizes to the grid of the step (from the bottom of the band)
+    offset = (currentWorkFrequency > currentMinimumFrequency) ? currentWorkFrequency - currentMinimumFrequency : 0;
+    position = offset / step;
+    if (direction > 0)
+        freq = (int32_t)currentMinimumFrequency + (int32_t)(position + detents) * step;
+    else
+    {
+        if (offset % step != 0)
+            position++; // Off the grid: the first detent goes to the grid point below
+        freq = (int32_t)currentMinimumFrequency + ((int32_t)position - detents) * step;
+    }
+
+    // Band limits: stops at the limit, then wraps around
+    if (freq > (int32_t)currentMaximumFrequency)
+        freq = (currentWorkFrequency >= currentMaximumFrequency) ? currentMinimumFrequency : currentMaximumFrequency;
+    else if (freq < (int32_t)currentMinimumFrequency)
+        freq = (currentWorkFrequency <= currentMinimumFrequency) ? currentMaximumFrequency : currentMinimumFrequency;
+
+    currentWorkFrequency = (uint16_t)freq;
+    if (tuneState != NULL)
+        requestFrequency(currentWorkFrequency);
+    else
+        setFrequency(currentWorkFrequency);
+
+    return currentWorkFrequency;
+}
+
+/**
+ * @ingroup group29 Encoder tuning
+ *
+ * @brief Changes an entry of the step acceleration table (see si47x_step_acceleration).
+ *
+ * @details The table is loaded with SI473X_STEP_ACCELERATION by setEncoderAcceleration. Keep the entries sorted by rate.
+ *          Use multiplier 0 to disable an entry. Without setEncoderAcceleration, the call is ignored.
+ *
+ * @param level entry (0 to SI473X_STEP_ACCELERATION_SIZE - 1)
+ * @param rate minimum encoder rate (detents per second)
+ * @param multiplier step multiplier (the step is currentStep * multiplier)
+ */
+void SI4735::setEncoderAccelerationLevel(uint8_t level, uint16_t rate, uint8_t multiplier)
+{
+    if (level >= SI473X_STEP_ACCELERATION_SIZE)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return;
+    }
+    if (encoderState == NULL)
+        return;
+    encoderState->level[level].rate = rate;
+    encoderState->level[level].multiplier = multiplier;
+}
+
+/**
+ * @ingroup group29 Encoder tuning
+ *
+ * @brief Enables or disables the step acceleration of encoderTune.
+ *
+ * @details The state is cleared and its table is loaded with SI473X_STEP_ACCELERATION. Without acceleration (NULL, the
+ *          default), each detent moves the frequency by currentStep.
+ *
+ * @param state encoder state declared by the sketch (it has to be valid while it is in use) or NULL
+ */
+void SI4735::setEncoderAcceleration(si47x_encoder_state *state)
+{
+    if (state != NULL)
+    {
+        memset(state, 0, sizeof(si47x_encoder_state));
+        memcpy_P(state->level, defaultStepAcceleration, sizeof(state->level));
+    }
+    encoderState = state;
+}
+
+/**
+ * @defgroup group30 Bandscope sweep
+ *
+ * @section group30 Bandscope sweep
+ *
+ * @brief Measures the RSSI and SNR over a range of frequencies (spectrum display, band activity etc).
+ * @details Each point is tuned with the FAST bit set and, after the STC, measured with RSQ_STATUS (one read per point;
+ *          the TUNE_STATUS of a FAST tune has a rough RSSI). With averaging, more RSQ readings are added every
+ *          SI473X_SWEEP_SAMPLE_INTERVAL us. The STC acknowledge and the RSQ_STATUS are queued back to back and the
+ *          device is never polled while the queue knows it is ready, so a point costs little more than its STC.
+ *          The STC wait follows its own timing entry (SI473X_TIMING_SWEEP, see setSweepTiming), much shorter than the
+ *          one of a normal tune, and there is no fixed delay.
+ * @details The sweep is non-blocking: startSweep starts it and sweepTick (call it in your loop function) advances it.
+ *          Its state is kept in a si47x_sweep_state declared by the sketch.
+ *          The points are stored in your buffer and can be drawn while the sweep goes on (see getSweepCount or the
+ *          callback). At the end (or after stopSweep) the frequency tuned before the sweep is restored.
+ *          sweep() is the blocking version.
+ * @code
+ *   si47x_sweep_point scope[120];
+ *   si47x_sweep_state scopeSweep;
+ *
+ *   void drawPoint(uint16_t index, uint16_t frequency, si47x_sweep_point point) {
+ *      display.drawLine(index, 63, index, 63 - point.rssi / 2);
+ *   }
+ *
+ *   void loop() {
+ *      if (!rx.isSweeping())
+ *          rx.startSweep(&scopeSweep, 530, 1720, 10, scope, 120, 1, drawPoint);
+ *      rx.sweepTick();
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group30 Bandscope sweep
+ *
+ * @brief Starts a bandscope sweep (non-blocking).
+ *
+ * @details Call sweepTick until it returns false. Do not tune (setFrequency, seek etc) during the sweep; call stopSweep before.
+ *
+ * @param state sweep state declared by the sketch (it has to be valid until the end of the sweep)
+ * @param from first frequency (current band units: FM => 10 kHz; AM and SSB => kHz)
+ * @param to last frequency
+ * @param step step between points
+ * @param buffer where the points will be stored
+ * @param size number of points the buffer can hold (the sweep stops when it is full)
+ * @param averaging number of RSQ readings per point (1 = one reading)
+ * @param onPoint function called after each point or NULL
+ *
+ * @return false if the arguments are invalid or there is no command queue (see getLastError).
+ */
+bool SI4735::startSweep(si47x_sweep_state *state, uint16_t from, uint16_t to, uint16_t step, si47x_sweep_point *buffer, uint16_t size, uint8_t averaging, si47x_sweep_callback onPoint)
+{
+    uint16_t restore;
+
+    if (state == NULL || buffer == NULL || size == 0 || step == 0 || to < from)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return false;
+    }
+    if (!hasCommandQueue())
+        return false;
+
+    if (isSweeping())
+    {
+        waitCommand(sweepState->handle);
+        restore = sweepState->restore; // Restarted: the frequency to be restored stays the same
+    }
+    else
+    {
+        cancelTune();
+        restore = currentWorkFrequency;
+    }
+
+    memset(state, 0, sizeof(si47x_sweep_state));
+    sweepState = state;
+    sweepState->restore = restore;
+    sweepState->buffer = buffer;
+    sweepState->size = size;
+    sweepState->frequency = from;
+    sweepState->to = to;
+    sweepState->step = step;
+    sweepState->averaging = (averaging > 0) ? averaging : 1;
+    sweepState->onPoint = onPoint;
+
+    prepareSeekTune(currentTune);
+    sweepState->state = SI473X_SWEEP_TUNE;
+    sweepTick();
+    return true;
+}
+
+/**
+ * @ingroup group30 Bandscope sweep
+ *
+ * @brief Advances the bandscope sweep.
+ *
+ * @details Call this function as often as possible (in the loop function). It never waits for the device: the tune,
+ *          the STC acknowledge and the RSQ readings go through the asynchronous queue.
+ *
+ * @return true while the sweep is in progress.
+ */
+bool SI4735::sweepTick()
+{
+    unsigned long now;
+
+    if (sweepState == NULL)
+        return false;
+
+    switch (sweepState->state)
+    {
+    case SI473X_SWEEP_TUNE:
+        sweepState->handle = sendTuneAsync(sweepState->frequency, 1);
+        if (sweepState->handle == 0)
+        {
+            commandTick(); // Queue full. Tries again on the next call.
+            break;
+        }
+        sweepState->sentAt = micros();
+        sweepState->pollInterval = sweepTiming.pollInterval;
+        sweepState->lastPoll = sweepState->sentAt - sweepState->pollInterval;
+        sweepState->state = SI473X_SWEEP_SETTLE;
+        commandTick();
+        break;
+    case SI473X_SWEEP_SETTLE:
+        commandTick();
+        if (!isCommandDone(sweepState->handle) || !pollSeekTuneComplete(&sweepTiming, sweepState->sentAt, sweepState->lastPoll, sweepState->pollInterval, false))
+            break;
+        sweepState->samples = 0;
+        sweepState->rssiSum = sweepState->snrSum = 0;
+        sweepState->handle = 0;
+        sweepState->sentAt = micros() - SI473X_SWEEP_SAMPLE_INTERVAL; // The first RSQ reading is queued at once (after the acknowledge)
+        sweepState->state = SI473X_SWEEP_MEASURE;
+        // fall through
+    case SI473X_SWEEP_MEASURE:
+        if (sweepState->handle == 0)
+        {
+            now = micros();
+            if ((now - sweepState->sentAt) < SI473X_SWEEP_SAMPLE_INTERVAL)
+                break;
+            sweepState->handle = sendRsqAsync();
+            if (sweepState->handle == 0)
+            {
+                commandTick(); // Queue full (STC acknowledge). Tries again on the next call.
+                break;
+            }
+            sweepState->sentAt = now;
+        }
+        commandTick();
+        if (!isCommandDone(sweepState->handle))
+            break;
+        sweepState->handle = 0;
+        sweepState->rssiSum += currentRqsStatus.resp.RSSI;
+        sweepState->snrSum += currentRqsStatus.resp.SNR;
+        if (++sweepState->samples >= sweepState->averaging)
+            finishSweepPoint();
+        break;
+    }
+
+    return sweepState->state != SI473X_SWEEP_IDLE;
+}
+
+/**
+ * @ingroup group30 Bandscope sweep
+ *
+ * @brief Stores the current point and moves to the next one (or ends the sweep).
+ */
+void SI4735::finishSweepPoint()
+{
+    si47x_sweep_point point;
+
+    point.rssi = sweepState->rssiSum / sweepState->averaging;
+    point.snr = sweepState->snrSum / sweepState->averaging;
+    sweepState->buffer[sweepState->count] = point;
+    if (sweepState->onPoint != NULL)
+        sweepState->onPoint(sweepState->count, sweepState->frequency, point);
+    sweepState->count++;
+
+    if (sweepState->count >= sweepState->size || (uint32_t)sweepState->frequency + sweepState->step > sweepState->to)
+        stopSweep();
+    else
+    {
+        sweepState->frequency += sweepState->step;
+        sweepState->state = SI473X_SWEEP_TUNE;
+    }
+}
+
+/**
+ * @ingroup group30 Bandscope sweep
+ *
+ * @brief Ends the sweep and tunes the frequency used before it (normal tune).
+ */
+void SI4735::stopSweep()
+{
+    if (!isSweeping())
+        return;
+    sweepState->state = SI473X_SWEEP_IDLE;
+    setFrequency(sweepState->restore);
+}
+
+/**
+ * @ingroup group30 Bandscope sweep
+ *
+ * @brief Runs a whole bandscope sweep (blocking version of startSweep / sweepTick).
+ *
+ * @see startSweep
+ *
+ * @return uint16_t number of points stored in the buffer.
+ */
+uint16_t SI4735::sweep(uint16_t from, uint16_t to, uint16_t step, si47x_sweep_point *buffer, uint16_t size, uint8_t averaging, si47x_sweep_callback onPoint)
+{
+    si47x_sweep_state state;
+    si47x_async_command slot;
+    bool lent = lendCommandSlot(&slot);
+
+    state.count = 0;
+    if (startSweep(&state, from, to, step, buffer, size, averaging, onPoint))
+    {
+        while (sweepTick())
+            ;
+        sweepState = NULL; // The state is gone
+    }
+    if (lent)
+        returnCommandSlot();
+    return state.count;
+}
+
+/**
+ * @ingroup group08 Set mode and Band
+ *
+ * @todo Adjust the power up parameters
+ *
+ * @brief Sets the radio to AM function. It means: LW MW and SW.
+ *
+ * @details Define the band range you want to use for the AM mode.
+ * @details If the device is already on AM, nothing is sent. Otherwise, the properties set the last time the device was
+ *          on AM or SSB are restored (see group36 Mode switch).
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 129.
+ */
+void SI4735::setAM()
+{
+    // If you’re already using AM mode, it is not necessary to call powerDown and radioPowerUp.
+    // The other properties also should have the same value as the previous status.
+    uint32_t start = micros();
+
+    if (lastMode != AM_CURRENT_MODE || !poweredUp)
+    {
+        if (poweredUp)
+            powerDown();
+        setPowerUp(this->ctsIntEnable, this->gpo2Enable, 0, this->currentClockType, AM_CURRENT_MODE, this->currentAudioMode);
+        radioPowerUp();
+        lastMode = AM_CURRENT_MODE;           // The restored properties are kept for AM again
+        restoreModeState(AM_CURRENT_MODE);    // Properties and AGC set the last time the device was on AM
+        setAvcAmMaxGain(currentAvcAmMaxGain); // Set AM Automatic Volume Gain (default value is DEFAULT_CURRENT_AVC_AM_MAX_GAIN)
+        setVolume(volume);                    // Set to previus configured volume
+    }
+    currentSsbStatus = 0;
+    lastMode = AM_CURRENT_MODE;
+    currentBandIdx = SI473X_BAND_NONE; // See setBand
+    modeSwitchTime = micros() - start;
+}
+
+/**
+ * @ingroup group08 Set mode and Band
+ *
+ * @todo Adjust the power up parameters
+ *
+ * @brief Sets the radio to FM function
+ *
+ * @details If the device is already on FM, nothing is sent (call powerDown before to force a new power up). Otherwise,
+ *          the properties set the last time the device was on FM are restored (see group36 Mode switch).
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 64.
+ */
+void SI4735::setFM()
+{
+    uint32_t start = micros();
+
+    if (lastMode != FM_CURRENT_MODE || !poweredUp)
+    {
+        if (poweredUp)
+            powerDown();
+        setPowerUp(this->ctsIntEnable, this->gpo2Enable, 0, this->currentClockType, FM_CURRENT_MODE, this->currentAudioMode);
+        radioPowerUp();
+        lastMode = FM_CURRENT_MODE;        // The restored properties are kept for FM again
+        restoreModeState(FM_CURRENT_MODE); // Properties and AGC set the last time the device was on FM
+        setVolume(volume);                 // Set to previus configured volume
+        disableFmDebug();
+    }
+    currentSsbStatus = 0;
+    lastMode = FM_CURRENT_MODE;
+    currentBandIdx = SI473X_BAND_NONE; // See setBand
+    modeSwitchTime = micros() - start;
+}
+
+/**
+ * @ingroup group08 Set mode and Band
+ *
+ * @brief Sets the radio to AM (LW/MW/SW) function.
+ *
+ * @details The example below sets the band from 550kHz to 1750kHz on AM mode. The band will start on 810kHz and step is 10kHz.
+ *
+ * @code
+ * si4735.setAM(520, 1750, 810, 10);
+ * @endcode
+ *
+ * @see setFM()
+ * @see setSSB()
  *
  * @param fromFreq minimum frequency for the band
  * @param toFreq maximum frequency for the band
@@ -894,7 +1929,7 @@ void SI4735::setFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, uin
 void SI4735::setBandwidth(uint8_t AMCHFLT, uint8_t AMPLFLT)
 {
     si47x_bandwidth_config filter;
-    si47x_property property;
+    si47x_property param;
 
     if (currentTune != AM_TUNE_FREQ) // Only for AM/SSB mode
         return;
@@ -904,22 +1939,12 @@ void SI4735::setBandwidth(uint8_t AMCHFLT, uint8_t AMPLFLT)
 
     filter.raw[0] = filter.raw[1] = 0;
 
-    property.value = AM_CHANNEL_FILTER;
-
     filter.param.AMCHFLT = AMCHFLT;
     filter.param.AMPLFLT = AMPLFLT;
 
-    waitToSend();
-    this->volume = volume;
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SET_PROPERTY);
-    Wire.write(0x00);                  // Always 0x00
-    Wire.write(property.raw.byteHigh); // High byte first
-    Wire.write(property.raw.byteLow);  // Low byte after
-    Wire.write(filter.raw[1]);         // Raw data for AMCHFLT and
-    Wire.write(filter.raw[0]);         // AMPLFLT
-    Wire.endTransmission();
-    waitToSend();
+    param.raw.byteHigh = filter.raw[1]; // Raw data for AMCHFLT and
+    param.raw.byteLow = filter.raw[0];  // AMPLFLT
+    sendProperty(AM_CHANNEL_FILTER, param.value);
 }
 
 /**
@@ -969,627 +1994,4570 @@ void SI4735::getStatus(uint8_t INTACK, uint8_t CANCEL)
         limitResp = 6;
     }
 
-    waitToSend();
-
     status.arg.INTACK = INTACK;
     status.arg.CANCEL = CANCEL;
     status.arg.RESERVED2 = 0;
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(cmd);
-    Wire.write(status.raw);
-    Wire.endTransmission();
+    uint8_t retry = 0;
+
     // Reads the current status (including current frequency).
     do
     {
-        waitToSend();
-        Wire.requestFrom(deviceAddress, limitResp); // Check it
-        // Gets response information
-        for (uint8_t i = 0; i < limitResp; i++)
-            currentStatus.raw[i] = Wire.read();
-    } while (currentStatus.resp.ERR); // If error, try it again
-    waitToSend();
+        runCommand(cmd, 1, &status.raw, limitResp, currentStatus.raw);
+    } while (currentStatus.resp.ERR && retryCommand(retry)); // If error, try it again
+}
+
+/**
+ * @ingroup group08 AGC
+ *
+ * @brief Queries Automatic Gain Control STATUS
+ *
+ * @details After call this method, you can call isAgcEnabled to know the AGC status and getAgcGainIndex to know the gain index value.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); For FM page 80; for AM page 142.
+ * @see AN332 REV 0.8 Universal Programming Guide Amendment for SI4735-D60 SSB and NBFM patches; page 18.
+ *
+ */
+void SI4735::getAutomaticGainControl()
+{
+    uint8_t cmd;
+
+    if (currentTune == FM_TUNE_FREQ)
+    { // FM TUNE
+        cmd = FM_AGC_STATUS;
+    }
+    else if (currentTune == NBFM_TUNE_FREQ)
+    {
+        cmd = NBFM_AGC_STATUS;
+    }
+    else
+    { // AM TUNE - SAME COMMAND used on SSB mode
+        cmd = AM_AGC_STATUS;
+    }
+
+    uint8_t retry = 0;
+
+    do
+    {
+        runCommand(cmd, 0, NULL, 3, currentAgcStatus.raw); // STATUS response, RESP 1 and RESP 2
+    } while (currentAgcStatus.refined.ERR && retryCommand(retry)); // If error, try get AGC status again.
+}
+
+/**
+ * @ingroup group08 AGC
+ *
+ * @brief Automatic Gain Control setup
+ *
+ * @details If FM, overrides AGC setting by disabling the AGC and forcing the LNA to have a certain gain that ranges between 0
+ * (minimum attenuation) and 26 (maximum attenuation).
+ * @details If AM/SSB, Overrides the AGC setting by disabling the AGC and forcing the gain index that ranges between 0
+ * (minimum attenuation) and 37+ATTN_BACKUP (maximum attenuation).
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); For FM page 81; for AM page 143
+ *
+ * @param uint8_t AGCDIS This param selects whether the AGC is enabled or disabled (0 = AGC enabled; 1 = AGC disabled);
+ * @param uint8_t AGCIDX AGC Index (0 = Minimum attenuation (max gain); 1 – 36 = Intermediate attenuation);
+ *                if >greater than 36 - Maximum attenuation (min gain) ).
+ */
+void SI4735::setAutomaticGainControl(uint8_t AGCDIS, uint8_t AGCIDX)
+{
+    si47x_agc_overrride agc;
+
+    uint8_t cmd;
+
+    // cmd = (currentTune == FM_TUNE_FREQ) ? FM_AGC_OVERRIDE : AM_AGC_OVERRIDE; // AM_AGC_OVERRIDE = SSB_AGC_OVERRIDE = 0x48
+
+    if (currentTune == FM_TUNE_FREQ)
+        cmd = FM_AGC_OVERRIDE;
+    else if (currentTune == NBFM_TUNE_FREQ)
+        cmd = NBFM_AGC_OVERRIDE;
+    else
+        cmd = AM_AGC_OVERRIDE;
+
+    agc.arg.DUMMY = 0; // ARG1: bits 7:1 Always write to 0;
+    agc.arg.AGCDIS = AGCDIS;
+    agc.arg.AGCIDX = AGCIDX;
+
+    runCommand(cmd, 2, agc.raw);
+
+    if (cmd != NBFM_AGC_OVERRIDE) // Restored after the next power up of the mode (see restoreModeState)
+        saveModeProperty(((cmd == FM_AGC_OVERRIDE) ? 0x1000 : 0x3000) | SI473X_MODE_STATE_AGC, ((uint16_t)agc.raw[0] << 8) | agc.raw[1]);
+}
+
+/**
+ * @ingroup group08 Automatic Volume Control
+ *
+ * @brief Sets the gain for automatic volume control.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 152
+ * @see setAvcAmMaxGain()
+ *
+ * @param uint8_t gain  Select a value between 12 and 90.  Defaul value 48dB.
+ */
+void SI4735::setAvcAmMaxGain(uint8_t gain)
+{
+    if (gain < 12 || gain > 90)
+        return;
+    currentAvcAmMaxGain = gain;
+    sendProperty(AM_AUTOMATIC_VOLUME_CONTROL_MAX_GAIN, gain * 340);
+}
+
+/**
+ * @ingroup group08 Received Signal Quality
+ *
+ * @brief Queries the status of the Received Signal Quality (RSQ) of the current channel.
+ *
+ * @details This method sould be called berore call getCurrentRSSI(), getCurrentSNR() etc.
+ * Command FM_RSQ_STATUS
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 75 and 141
+ *
+ * @param INTACK Interrupt Acknowledge.
+ *        0 = Interrupt status preserved;
+ *        1 = Clears RSQINT, BLENDINT, SNRHINT, SNRLINT, RSSIHINT, RSSILINT, MULTHINT, MULTLINT.
+ */
+void SI4735::getCurrentReceivedSignalQuality(uint8_t INTACK)
+{
+    uint8_t arg;
+    uint8_t cmd;
+    int sizeResponse;
+
+    if (currentTune == FM_TUNE_FREQ)
+    { // FM TUNE
+        cmd = FM_RSQ_STATUS;
+        sizeResponse = 8;
+    }
+    else if (currentTune == NBFM_TUNE_FREQ)
+    {
+        cmd = NBFM_RSQ_STATUS;
+        sizeResponse = 8; // Check it
+    }
+    else
+    { // AM TUNE
+        cmd = AM_RSQ_STATUS;
+        sizeResponse = 6; // Check it
+    }
+
+    arg = INTACK;
+    // Gets response information
+    runCommand(cmd, 1, &arg, sizeResponse, currentRqsStatus.raw);
+}
+
+/**
+ * @ingroup group08 Received Signal Quality
+ *
+ * @brief Queries the status of the Received Signal Quality (RSQ) of the current channel (FM_RSQ_STATUS)
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 75 and 141
+ *
+ * @param INTACK Interrupt Acknowledge.
+ *        0 = Interrupt status preserved;
+ *        1 = Clears RSQINT, BLENDINT, SNRHINT, SNRLINT, RSSIHINT, RSSILINT, MULTHINT, MULTLINT.
+ */
+void SI4735::getCurrentReceivedSignalQuality(void)
+{
+    getCurrentReceivedSignalQuality(0);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Look for a station (Automatic tune)
+ * @details Starts a seek process for a channel that meets the RSSI and SNR criteria for AM.
+ * @details __This function does not work on SSB mode__.
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 72, 125 and 137
+ *
+ * @param SEEKUP Seek Up/Down. Determines the direction of the search, either UP = 1, or DOWN = 0.
+ * @param Wrap/Halt. Determines whether the seek should Wrap = 1, or Halt = 0 when it hits the band limit.
+ */
+void SI4735::seekStation(uint8_t SEEKUP, uint8_t WRAP)
+{
+    uint8_t arg[5];
+    uint8_t seek_start_cmd = (currentTune == FM_TUNE_FREQ) ? FM_SEEK_START : AM_SEEK_START;
+    uint8_t size = setSeekArguments(SEEKUP, WRAP, arg);
+
+    cancelTune();
+    prepareSeekTune(seek_start_cmd);
+    runCommand(seek_start_cmd, size, arg);
+    // A seek can check the whole band: the limit is maxSeekTime, not the timeout of the timing table
+    if (!waitSeekTuneComplete((maxSeekTime < 65535) ? maxSeekTime : 65535))
+    {
+        getStatus(1, 1);                  // Stops the seek (CANCEL). The device stays on the frequency being checked.
+        lastError = SI473X_ERROR_TIMEOUT; // Already counted by waitSeekTuneComplete
+    }
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the arguments of the FM_SEEK_START or AM_SEEK_START command.
+ *
+ * @param SEEKUP Seek Up/Down. Determines the direction of the search, either UP = 1, or DOWN = 0.
+ * @param WRAP Wrap/Halt. Determines whether the seek should Wrap = 1, or Halt = 0 when it hits the band limit.
+ * @param arg where the arguments will be stored (5 bytes)
+ *
+ * @return uint8_t number of arguments (FM = 1; AM = 5)
+ */
+uint8_t SI4735::setSeekArguments(uint8_t SEEKUP, uint8_t WRAP, uint8_t *arg)
+{
+    si47x_seek seek;
+    si47x_seek_am_complement seek_am_complement;
+
+    seek.arg.SEEKUP = SEEKUP;
+    seek.arg.WRAP = WRAP;
+    seek.arg.RESERVED1 = 0;
+    seek.arg.RESERVED2 = 0;
+
+    arg[0] = seek.raw; // ARG1
+
+    if (currentTune == FM_TUNE_FREQ)
+        return 1;
+
+    // Sets additional configuration for AM mode
+    seek_am_complement.ARG2 = seek_am_complement.ARG3 = 0;
+    seek_am_complement.ANTCAPH = 0;
+    seek_am_complement.ANTCAPL = (currentWorkFrequency > 1800) ? 1 : 0; // if SW = 1
+    arg[1] = seek_am_complement.ARG2;                                   // ARG2 - Always 0
+    arg[2] = seek_am_complement.ARG3;                                   // ARG3 - Always 0
+    arg[3] = seek_am_complement.ANTCAPH;                                // ARG4 - Tuning Capacitor: The tuning capacitor value
+    arg[4] = seek_am_complement.ANTCAPL;                                // ARG5 - will be selected automatically.
+    return 5;
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Search for the next station.
+ * @details Like seekStationUp this function goes to a next station.
+ * @details The main difference is the method used to look for a station.
+ *
+ * @see seekStation, seekStationUp, seekStationDown, seekPreviousStation, seekStationProgress
+ */
+void SI4735::seekNextStation()
+{
+    seekStation(1, 1);
+    getFrequency();
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Search the previous station
+ * @details Like seekStationDown this function goes to a previous station.
+ * @details The main difference is the method used to look for a station.
+ * @see seekStation, seekStationUp, seekStationDown, seekPreviousStation, seekStationProgress
+ */
+void SI4735::seekPreviousStation()
+{
+    seekStation(0, 1);
+    getFrequency();
+}
+
+/**
+ * @ingroup group08 Seek
+ * @brief Seeks a station up or down.
+ * @details Seek up or down a station and call a function defined by the developer to show the frequency.
+ * @details The first parameter of this function is a name of your function that you have to implement to show the current frequency.
+ * @details If you do not want to show the seeking progress,  you can set NULL instead the name of the function.
+ * @details The code below shows an example using ta function the shows the current frequency on he Serial Monitor. You might want to implement a function that shows the frequency on your display device.
+ * @details Also, you have to declare the frequency parameter that will be used by the function to show the frequency value.
+ * @details __This function does not work on SSB mode__.
+ * @code
+ * void showFrequency( uint16_t freq ) {
+ *    Serial.print(freq);
+ *    Serial.println("MHz ");
+ * }
+ *
+ * void loop() {
+ *
+ *  receiver.seekStationProgress(showFrequency,1); // Seek Up
+ *  .
+ *  .
+ *  .
+ *  receiver.seekStationProgress(showFrequency,0); // Seek Down
+ *
+ * }
+ * @endcode
+ *
+ * @details It is the blocking version of startSeek / seekTick.
+ * @see seekStation, seekStationUp, seekStationDown, getStatus, setMaxSeekTime, startSeek
+ * @param showFunc  function that you have to implement to show the frequency during the seeking process. Set NULL if you do not want to show the progress.
+ * @param up_down   set up_down = 1 for seeking station up; set up_down = 0 for seeking station down
+ */
+void SI4735::seekStationProgress(void (*showFunc)(uint16_t f), uint8_t up_down)
+{
+    si47x_seek_state state;
+    si47x_async_command slot;
+    bool lent = lendCommandSlot(&slot);
+
+    // One hardware seek (halts at the band limit). The progress is shown while the device searches.
+    if (startSeek(&state, up_down, 0, showFunc))
+    {
+        while (seekTick())
+            ;
+        seekState = NULL; // The state is gone
+    }
+    if (lent)
+        returnCommandSlot();
+}
+
+/**
+ * @ingroup group08 Seek
+ * @brief Seeks a station up or down.
+ * @details Seek up or down a station and call a function defined by the developer to show the frequency and stop seeking process by the user.
+ * @details The first parameter of this function is a name of your function that you have to implement to show the current frequency.
+ * @details The second parameter is the name function that will check stop seeking action. Thus function should return true or false and should read a button, encoder or some status to make decision to stop or keep seeking.
+ * @details If you do not want to show the seeking progress,  you can set NULL instead the name of the function.
+ * @details If you do not want stop seeking checking, you can set NULL instead the name of a function.
+ * @details The code below shows an example using ta function the shows the current frequency on he Serial Monitor. You might want to implement a function that shows the frequency on your display device.
+ * @details Also, you have to declare the frequency parameter that will be used by the function to show the frequency value.
+ * @details __This function does not work on SSB mode__.
+ * @code
+ * void showFrequency( uint16_t freq ) {
+ *    Serial.print(freq);
+ *    Serial.println("MHz ");
+ * }
+ *
+ * void loop() {
+ *
+ *  receiver.seekStationProgress(showFrequency, checkStopSeeking, 1); // Seek Up
+ *  .
+ *  .
+ *  .
+ *  receiver.seekStationProgress(showFrequency, checkStopSeeking, 0); // Seek Down
+ *
+ * }
+ * @endcode
+ *
+ * @details It is the blocking version of startSeek / seekTick.
+ * @see seekStation, seekStationUp, seekStationDown, getStatus, setMaxSeekTime, startSeek
+ * @param showFunc  function that you have to implement to show the frequency during the seeking process. Set NULL if you do not want to show the progress.
+ * @param stopSeeking functionthat you have to implement if you want to control the stop seeking action. Useful if you want abort the seek process.
+ * @param up_down   set up_down = 1 for seeking station up; set up_down = 0 for seeking station down
+ */
+void SI4735::seekStationProgress(void (*showFunc)(uint16_t f), bool (*stopSeking)(), uint8_t up_down)
+{
+    si47x_seek_state state;
+    si47x_async_command slot;
+    bool lent = lendCommandSlot(&slot);
+
+    if (startSeek(&state, up_down, 0, showFunc))
+    {
+        while (seekTick())
+        {
+            if (stopSeking != NULL && stopSeking())
+                cancelSeek();
+        }
+        seekState = NULL; // The state is gone
+    }
+    if (lent)
+        returnCommandSlot();
+}
+
+/**
+ * @defgroup group31 Non-blocking seek
+ *
+ * @section group31 Non-blocking seek
+ *
+ * @brief Seek driven by the loop function, with the progress reported while the device searches.
+ * @details startSeek sends one SEEK_START command. seekTick (call it in your loop function) reads the frequency being
+ *          checked by the device every SI473X_SEEK_POLL_INTERVAL ms (TUNE_STATUS without INTACK, so the seek goes on)
+ *          and ends the seek on the STC (or on the STC interrupt in interrupt mode). cancelSeek stops it with the
+ *          CANCEL bit. The buttons and the display stay responsive during the whole seek.
+ * @details The state of the seek is kept in a si47x_seek_state declared by the sketch.
+ * @code
+ *   si47x_seek_state seek;
+ *
+ *   void showFrequency(uint16_t freq) {
+ *      display.print(freq);
+ *   }
+ *
+ *   void loop() {
+ *      if (digitalRead(SEEK_BUTTON) == LOW && !rx.isSeeking())
+ *          rx.startSeek(&seek, SEEK_UP, 1, showFrequency);
+ *      if (digitalRead(STOP_BUTTON) == LOW)
+ *          rx.cancelSeek();
+ *      rx.seekTick();
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group31 Non-blocking seek
+ *
+ * @brief Starts a seek (non-blocking).
+ *
+ * @details Call seekTick until it returns false. At the end, the frequency and the seek result are in the current
+ *          status (getCurrentFrequency, getStatusValid, getStatusBLTF etc).
+ * @details __This function does not work on SSB and NBFM modes__ (see startSoftSeek).
+ *
+ * @param state seek state declared by the sketch (it has to be valid until the end of the seek)
+ * @param up_down 1 = seek up; 0 = seek down
+ * @param wrap 1 = wraps around at the band limit; 0 = halts at the band limit
+ * @param showFunc function called with the frequency being checked (and with the final one) or NULL
+ *
+ * @return false if the seek could not be started (SSB or NBFM mode, no command queue).
+ */
+bool SI4735::startSeek(si47x_seek_state *state, uint8_t up_down, uint8_t wrap, void (*showFunc)(uint16_t f))
+{
+    uint8_t arg[5];
+    uint8_t seek_start_cmd = (currentTune == FM_TUNE_FREQ) ? FM_SEEK_START : AM_SEEK_START;
+    uint8_t size;
+
+    if (state == NULL || lastMode == SSB_CURRENT_MODE || currentTune == NBFM_TUNE_FREQ || !hasCommandQueue())
+        return false;
+    cancelSeek();
+
+    size = setSeekArguments(up_down, wrap, arg);
+    cancelTune();
+    prepareSeekTune(seek_start_cmd);
+    seekState = state;
+    while ((seekState->handle = sendCommandAsync(seek_start_cmd, size, arg)) == 0)
+        commandTick();
+
+    seekState->active = true;
+    seekState->showFunc = showFunc;
+    seekState->startedAt = seekState->lastPoll = millis();
+    commandTick();
+    return true;
+}
+
+/**
+ * @ingroup group31 Non-blocking seek
+ *
+ * @brief Advances the seek started by startSeek.
+ *
+ * @details Call this function as often as possible (in the loop function). It never waits for the device.
+ * @details A seek longer than maxSeekTime (see setMaxSeekTime) is cancelled (getLastError() == SI473X_ERROR_TIMEOUT).
+ *
+ * @return true while the seek is in progress.
+ */
+bool SI4735::seekTick()
+{
+    unsigned long now;
+    bool stc = false;
+
+    if (!isSeeking())
+        return false;
+    commandTick();
+    if (!isCommandDone(seekState->handle))
+        return true;
+
+    now = millis();
+    if (useStcInterrupt())
+    {
+        checkInterrupt();
+        stc = interruptFlags.refined.STCINT;
+    }
+    if (!stc && (now - seekState->lastPoll) >= SI473X_SEEK_POLL_INTERVAL)
+    {
+        // Progress: the frequency being checked. Without INTACK and CANCEL, the seek goes on.
+        seekState->lastPoll = now;
+        getStatus(0, 0);
+        stc = currentStatus.resp.STCINT;
+        if (!stc)
+            showSeekFrequency();
+    }
+
+    if (stc)
+        finishSeek(0);
+    else if ((now - seekState->startedAt) >= maxSeekTime)
+    {
+        finishSeek(1);
+        if (errorStats != NULL)
+            errorStats->stcTimeouts++;
+        setError(SI473X_ERROR_TIMEOUT, 0);
+    }
+
+    return seekState->active;
+}
+
+/**
+ * @ingroup group31 Non-blocking seek
+ *
+ * @brief Stops the seek in progress (CANCEL bit). The device stays on the frequency being checked.
+ */
+void SI4735::cancelSeek()
+{
+    if (!isSeeking())
+        return;
+    waitCommand(seekState->handle);
+    finishSeek(1);
+}
+
+/**
+ * @ingroup group31 Non-blocking seek
+ *
+ * @brief Ends the seek: acknowledges the STC (cancelling the seek if requested) and reports the final frequency.
+ *
+ * @param cancel 1 = cancels the seek in progress
+ */
+void SI4735::finishSeek(uint8_t cancel)
+{
+    seekState->active = false;
+    getStatus(1, cancel);
+    interruptFlags.refined.STCINT = 0;
+    showSeekFrequency();
+}
+
+/**
+ * @ingroup group31 Non-blocking seek
+ *
+ * @brief Updates the current frequency from the last TUNE_STATUS and calls the progress function (if any).
+ */
+void SI4735::showSeekFrequency()
+{
+    si47x_frequency freq;
+
+    freq.raw.FREQH = currentStatus.resp.READFREQH;
+    freq.raw.FREQL = currentStatus.resp.READFREQL;
+    currentWorkFrequency = freq.value;
+    if (seekState->showFunc != NULL)
+        seekState->showFunc(freq.value);
+}
+
+/**
+ * @defgroup group32 Software seek
+ *
+ * @section group32 Software seek
+ *
+ * @brief Seek done by the library: works on every mode (FM, AM, SSB and NBFM) with your own criteria.
+ * @details The hardware seek (FM_SEEK_START / AM_SEEK_START) is not available on SSB and NBFM, and it accepts a channel
+ *          by RSSI and SNR only. The software seek tunes the band with the FAST bit set and judges each channel by
+ *          RSSI, SNR, multipath and, optionally, the RDS sync (see setSoftSeekCriteria) plus your own function (see
+ *          setSoftSeekFilter).
+ * @details To be faster than checking every channel, it goes in coarse steps. A coarse point close to the RSSI threshold
+ *          (SI473X_SOFT_SEEK_MARGIN, the leakage of a near station) and above the noise floor (the lowest RSSI seen)
+ *          is refined with fine steps around it. The strongest point is then tuned normally and checked against all
+ *          criteria (see setSoftSeekSteps).
+ * @details startSoftSeek / softSeekTick / cancelSoftSeek work like startSeek / seekTick / cancelSeek, with the state of the
+ *          seek in a si47x_soft_seek_state declared by the sketch. softSeek is the blocking version.
+ * @code
+ *   // Finds the next FM station with RSSI >= 25 dBuV, SNR >= 10 dB, multipath <= 30 and RDS
+ *   si47x_seek_criteria rds = {25, 10, 30, 1, 500};
+ *   rx.setRdsConfig(1, 2, 2, 2, 2);
+ *   if (rx.softSeek(SEEK_UP, 1, showFrequency, &rds))
+ *      Serial.println("Found");
+ *
+ *   // SSB: 1 kHz resolution, non-blocking (the criteria, filter and steps are kept in the state)
+ *   si47x_soft_seek_state seek; // Global
+ *   ...
+ *   rx.setSSB(7000, 7300, 7050, 1, LSB);
+ *   rx.setSoftSeekCriteria(&seek, 20, 6);
+ *   rx.startSoftSeek(&seek, SEEK_UP);
+ *   ...
+ *   rx.softSeekTick(); // In the loop
+ * @endcode
+ */
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Starts a software seek (non-blocking).
+ *
+ * @details Call softSeekTick until it returns false. At the end, getSoftSeekFound tells if a channel was found.
+ *          Otherwise, the receiver goes back to the start frequency (wrap) or to the band limit (halt).
+ * @details Do not tune (setFrequency, seek etc) during the software seek; call cancelSoftSeek before.
+ *
+ * @param state software seek state declared by the sketch (it has to be valid until the end of the seek)
+ * @param up_down 1 = seek up; 0 = seek down
+ * @param wrap 1 = wraps around at the band limit; 0 = halts at the band limit
+ * @param showFunc function called with each coarse point (and with the final frequency) or NULL
+ *
+ * @return false if the band is not set or there is no command queue (see getLastError).
+ */
+bool SI4735::startSoftSeek(si47x_soft_seek_state *state, uint8_t up_down, uint8_t wrap, void (*showFunc)(uint16_t f))
+{
+    if (state == NULL || currentMaximumFrequency <= currentMinimumFrequency)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return false;
+    }
+    if (!hasCommandQueue())
+        return false;
+    if (isSoftSeeking())
+        waitCommand(softSeekState->handle); // Restarted from the frequency being checked
+
+    cancelTune();
+    // Keeps the settings (criteria, filter and steps)
+    memset(&state->state, 0, sizeof(si47x_soft_seek_state) - offsetof(si47x_soft_seek_state, state));
+    softSeekState = state;
+    if (softSeekState->criteria.rssi == 0 && softSeekState->criteria.snr == 0)
+    {
+        softSeekState->criteria.rssi = SI473X_SOFT_SEEK_RSSI;
+        softSeekState->criteria.snr = SI473X_SOFT_SEEK_SNR;
+        if (softSeekState->criteria.rdsTimeout == 0)
+            softSeekState->criteria.rdsTimeout = 500;
+    }
+    softSeekState->fine = (softSeekState->fineStep != 0) ? softSeekState->fineStep : currentStep;
+    if (softSeekState->fine == 0)
+        softSeekState->fine = 1;
+    softSeekState->coarse = softSeekState->coarseStep;
+    if (softSeekState->coarse == 0)
+        softSeekState->coarse = (currentTune == AM_TUNE_FREQ) ? SI473X_SOFT_SEEK_AM_COARSE : softSeekState->fine * 2;
+    if (softSeekState->coarse < softSeekState->fine)
+        softSeekState->coarse = softSeekState->fine;
+    softSeekState->coarse -= softSeekState->coarse % softSeekState->fine;
+
+    softSeekState->up = up_down;
+    softSeekState->wrap = wrap;
+    softSeekFound = false;
+    softSeekTunes = 0;
+    softSeekState->floor = 255;
+    softSeekState->origin = currentWorkFrequency;
+    softSeekState->showFunc = showFunc;
+
+    prepareSeekTune(currentTune);
+    nextSoftSeekPoint(softSeekState->origin);
+    softSeekTick();
+    return true;
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Advances the software seek.
+ *
+ * @details Call this function as often as possible (in the loop function). It never waits for the STC or for the RDS.
+ *
+ * @return true while the seek is in progress.
+ */
+bool SI4735::softSeekTick()
+{
+    unsigned long now;
+
+    if (softSeekState == NULL)
+        return false;
+
+    switch (softSeekState->state)
+    {
+    case SI473X_SOFT_SEEK_TUNE:
+        // The candidate is checked with a normal tune (AFC etc). The other points use the FAST bit.
+        softSeekState->handle = sendTuneAsync(softSeekState->frequency, (softSeekState->phase == SI473X_SOFT_SEEK_VERIFY) ? currentFrequencyParams.arg.FAST : 1);
+        if (softSeekState->handle == 0)
+        {
+            commandTick(); // Queue full. Tries again on the next call.
+            break;
+        }
+        softSeekTunes++;
+        softSeekState->timing = (softSeekState->phase == SI473X_SOFT_SEEK_VERIFY) ? seekTuneTiming : &sweepTiming;
+        softSeekState->sentAt = micros();
+        softSeekState->pollInterval = softSeekState->timing->pollInterval;
+        softSeekState->lastPoll = softSeekState->sentAt - softSeekState->pollInterval;
+        softSeekState->state = SI473X_SOFT_SEEK_SETTLE;
+        commandTick();
+        break;
+    case SI473X_SOFT_SEEK_SETTLE:
+        commandTick();
+        if (!isCommandDone(softSeekState->handle) || !pollSeekTuneComplete(softSeekState->timing, softSeekState->sentAt, softSeekState->lastPoll, softSeekState->pollInterval, false))
+            break;
+        // The TUNE_STATUS of a FAST tune has a rough RSSI. Every point is measured with one RSQ_STATUS.
+        softSeekState->handle = sendRsqAsync();
+        softSeekState->state = SI473X_SOFT_SEEK_MEASURE;
+        break;
+    case SI473X_SOFT_SEEK_MEASURE:
+        commandTick();
+        if (softSeekState->handle == 0)
+            softSeekState->handle = sendRsqAsync(); // Queue full after the STC. Tries again.
+        if (softSeekState->handle != 0 && isCommandDone(softSeekState->handle))
+            checkSoftSeekPoint(currentRqsStatus.resp.RSSI);
+        break;
+    case SI473X_SOFT_SEEK_RDS:
+        now = millis();
+        if ((now - softSeekState->lastPoll) < SI473X_SOFT_SEEK_RDS_POLL)
+            break;
+        softSeekState->lastPoll = now;
+        getRdsStatus(0, 0, 1); // STATUSONLY: the RDS groups stay in the FIFO
+        if (getRdsSync())
+            acceptSoftSeekCandidate(true);
+        else if ((now - softSeekState->sentAt) >= softSeekState->criteria.rdsTimeout)
+            acceptSoftSeekCandidate(false);
+        break;
+    }
+
+    return softSeekState->state != SI473X_SOFT_SEEK_IDLE;
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Judges the point just tuned and selects the next one.
+ *
+ * @param rssi RSSI of the point (dBuV)
+ */
+void SI4735::checkSoftSeekPoint(uint8_t rssi)
+{
+    uint16_t half = softSeekState->coarse - softSeekState->fine;
+    uint8_t margin = (softSeekState->coarse > softSeekState->fine) ? SI473X_SOFT_SEEK_MARGIN : 0;
+    bool accepted;
+
+    switch (softSeekState->phase)
+    {
+    case SI473X_SOFT_SEEK_COARSE:
+        if (softSeekState->showFunc != NULL)
+            softSeekState->showFunc(softSeekState->frequency);
+        softSeekState->candidate = softSeekState->best = softSeekState->frequency;
+        softSeekState->bestRssi = rssi;
+        if (rssi < softSeekState->floor)
+            softSeekState->floor = rssi;
+        // A point below the threshold is a candidate only if it stands out of the noise floor (lowest coarse RSSI)
+        if (rssi < softSeekState->criteria.rssi && ((uint16_t)rssi + margin < softSeekState->criteria.rssi || rssi <= (uint16_t)softSeekState->floor + margin / 2))
+        {
+            nextSoftSeekPoint(softSeekState->frequency);
+            return;
+        }
+        // Refine window: candidate +/- (coarse - fine), inside the band. The candidate itself is not tuned again.
+        softSeekState->refineTo = (currentMaximumFrequency - softSeekState->candidate > half) ? softSeekState->candidate + half : currentMaximumFrequency;
+        softSeekState->frequency = (softSeekState->candidate - currentMinimumFrequency > half) ? softSeekState->candidate - half : currentMinimumFrequency;
+        softSeekState->phase = SI473X_SOFT_SEEK_REFINE;
+        break;
+    case SI473X_SOFT_SEEK_REFINE:
+        if (rssi > softSeekState->bestRssi)
+        {
+            softSeekState->best = softSeekState->frequency;
+            softSeekState->bestRssi = rssi;
+        }
+        softSeekState->frequency += softSeekState->fine;
+        break;
+    case SI473X_SOFT_SEEK_VERIFY:
+        accepted = currentRqsStatus.resp.RSSI >= softSeekState->criteria.rssi && currentRqsStatus.resp.SNR >= softSeekState->criteria.snr;
+        if (currentTune == FM_TUNE_FREQ)
+        {
+            if (softSeekState->criteria.multipath != 0 && currentRqsStatus.resp.MULT > softSeekState->criteria.multipath)
+                accepted = false;
+            if (accepted && softSeekState->criteria.rdsSync)
+            {
+                softSeekState->sentAt = softSeekState->lastPoll = millis();
+                softSeekState->state = SI473X_SOFT_SEEK_RDS;
+                return;
+            }
+        }
+        acceptSoftSeekCandidate(accepted);
+        return;
+    }
+
+    // Next point of the refine window
+    if (softSeekState->frequency == softSeekState->candidate)
+        softSeekState->frequency += softSeekState->fine;
+    if (softSeekState->frequency <= softSeekState->refineTo && softSeekState->coarse > softSeekState->fine)
+    {
+        softSeekState->state = SI473X_SOFT_SEEK_TUNE;
+        return;
+    }
+    // End of the window: the strongest point is checked with a normal tune
+    if (softSeekState->bestRssi >= softSeekState->criteria.rssi)
+    {
+        softSeekState->frequency = softSeekState->best;
+        softSeekState->phase = SI473X_SOFT_SEEK_VERIFY;
+        softSeekState->state = SI473X_SOFT_SEEK_TUNE;
+    }
+    else
+        nextSoftSeekPoint(softSeekState->candidate);
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Ends the seek on the candidate or goes on after it.
+ *
+ * @param accepted true if the candidate meets the criteria (the filter function is called here)
+ */
+void SI4735::acceptSoftSeekCandidate(bool accepted)
+{
+    if (accepted && softSeekState->filter != NULL)
+        accepted = softSeekState->filter(softSeekState->frequency, &currentRqsStatus);
+    if (accepted)
+    {
+        softSeekFound = true;
+        finishSoftSeek(softSeekState->frequency);
+    }
+    else if (softSeekState->up) // Goes on after the rejected channel
+        nextSoftSeekPoint((softSeekState->best > softSeekState->candidate) ? softSeekState->best : softSeekState->candidate);
+    else
+        nextSoftSeekPoint((softSeekState->best < softSeekState->candidate) ? softSeekState->best : softSeekState->candidate);
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Moves to the next coarse point (wrapping around or halting at the band limit) or ends the seek.
+ *
+ * @param from last coarse point (or the start frequency)
+ */
+void SI4735::nextSoftSeekPoint(uint16_t from)
+{
+    int32_t f = (int32_t)from + ((softSeekState->up) ? softSeekState->coarse : -(int32_t)softSeekState->coarse);
+
+    if (f > currentMaximumFrequency || f < currentMinimumFrequency)
+    {
+        if (!softSeekState->wrap)
+        {
+            finishSoftSeek((softSeekState->up) ? currentMaximumFrequency : currentMinimumFrequency);
+            return;
+        }
+        if (softSeekState->wrapped)
+        {
+            finishSoftSeek(softSeekState->origin);
+            return;
+        }
+        softSeekState->wrapped = true;
+        f = (softSeekState->up) ? currentMinimumFrequency : currentMaximumFrequency;
+    }
+    if (softSeekState->wrapped && ((softSeekState->up) ? f >= softSeekState->origin : f <= softSeekState->origin))
+    {
+        finishSoftSeek(softSeekState->origin); // The whole band was checked
+        return;
+    }
+
+    softSeekState->frequency = (uint16_t)f;
+    softSeekState->phase = SI473X_SOFT_SEEK_COARSE;
+    softSeekState->state = SI473X_SOFT_SEEK_TUNE;
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Ends the software seek on a frequency.
+ *
+ * @param freq the channel found (already tuned) or the frequency to be tuned
+ */
+void SI4735::finishSoftSeek(uint16_t freq)
+{
+    softSeekState->state = SI473X_SOFT_SEEK_IDLE;
+    if (softSeekFound)
+        currentWorkFrequency = freq; // Tuned by the check of the candidate
+    else if (currentTune == NBFM_TUNE_FREQ)
+        setFrequencyNBFM(freq);
+    else
+        setFrequency(freq);
+    if (softSeekState->showFunc != NULL)
+        softSeekState->showFunc(freq);
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Stops the software seek. The receiver stays on the frequency being checked (normal tune).
+ */
+void SI4735::cancelSoftSeek()
+{
+    if (!isSoftSeeking())
+        return;
+    waitCommand(softSeekState->handle);
+    softSeekFound = false;
+    finishSoftSeek(softSeekState->frequency);
+}
+
+/**
+ * @ingroup group32 Software seek
+ *
+ * @brief Runs a whole software seek (blocking version of startSoftSeek / softSeekTick).
+ *
+ * @details It uses the default steps and no filter.
+ *
+ * @see startSoftSeek
+ *
+ * @param up_down 1 = seek up; 0 = seek down
+ * @param wrap 1 = wraps around at the band limit; 0 = halts at the band limit
+ * @param showFunc function called with each coarse point (and with the final frequency) or NULL
+ * @param criteria criteria used to accept a channel or NULL (SI473X_SOFT_SEEK_RSSI and SI473X_SOFT_SEEK_SNR)
+ *
+ * @return true if a channel was found.
+ */
+bool SI4735::softSeek(uint8_t up_down, uint8_t wrap, void (*showFunc)(uint16_t f), const si47x_seek_criteria *criteria)
+{
+    si47x_soft_seek_state state;
+    si47x_async_command slot;
+    bool lent = lendCommandSlot(&slot);
+
+    memset(&state, 0, sizeof(state));
+    if (criteria != NULL)
+        state.criteria = *criteria;
+    softSeekFound = false;
+    if (startSoftSeek(&state, up_down, wrap, showFunc))
+    {
+        while (softSeekTick())
+            ;
+        softSeekState = NULL; // The state is gone
+    }
+    if (lent)
+        returnCommandSlot();
+    return softSeekFound;
+}
+
+/**
+ * @defgroup group33 Autostore
+ *
+ * @section group33 Autostore
+ *
+ * @brief Scans the current band and builds a station list (presets) sorted by frequency.
+ * @details The scan starts at the bottom of the band (see setFM, setAM, setSSB and setNBFM) and goes up with the
+ *          hardware seek (halting at the band limit) or, on SSB and NBFM, with the software seek (the criteria, filter and
+ *          steps set on the softSeek member of the state are kept; see setSoftSeekCriteria).
+ *          On FM and AM, the seek limits and spacing are set to the current band. For each station, the RSSI, SNR and
+ *          multipath are stored and, on FM, the RDS PI and PS name are collected for up to rdsTime ms (RDS must be
+ *          configured, see setRdsConfig).
+ * @details The table belongs to the caller. When it is full, the weakest station gives its place to a stronger one.
+ * @details The scan is non-blocking: startAutostore starts it and autostoreTick (call it in your loop function) runs it
+ *          for a bounded time slice. At the end (or after stopAutostore) the frequency used before the scan is tuned
+ *          again. The state of the scan is kept in a si47x_autostore_state declared by the sketch. autostore() is the
+ *          blocking version.
+ * @code
+ *   si47x_station presets[20];
+ *   si47x_autostore_state scan;
+ *
+ *   void setup() {
+ *      ...
+ *      rx.setRdsConfig(1, 2, 2, 2, 2);
+ *      rx.startAutostore(&scan, presets, 20, 400); // Up to 400 ms per station to get the RDS PS
+ *   }
+ *
+ *   void loop() {
+ *      if (rx.isAutostoring() && !rx.autostoreTick())
+ *          showPresets(presets, rx.getAutostoreCount());
+ *      ...
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Starts a band scan (non-blocking).
+ *
+ * @details Call autostoreTick until it returns false. Do not tune (setFrequency, seek etc) during the scan; call
+ *          stopAutostore before.
+ * @details The hardware seek uses the band limits and step (setFM, setAM etc). The seek limits and spacing set before
+ *          are restored when the scan ends or is stopped.
+ *
+ * @param state scan state declared by the sketch (it has to be valid until the end of the scan)
+ * @param table where the stations will be stored
+ * @param size number of stations the table can hold
+ * @param rdsTime maximum time (ms) to collect the RDS PI and PS of each FM station (0 = no RDS)
+ *
+ * @return false if the arguments are invalid (see getLastError).
+ */
+bool SI4735::startAutostore(si47x_autostore_state *state, si47x_station *table, uint8_t size, uint16_t rdsTime)
+{
+    uint16_t base = (currentTune == FM_TUNE_FREQ) ? FM_SEEK_BAND_BOTTOM : AM_SEEK_BAND_BOTTOM;
+    uint8_t softSeekSettings[offsetof(si47x_soft_seek_state, state)];
+    int32_t value;
+
+    if (state == NULL || table == NULL || size == 0 || currentMaximumFrequency <= currentMinimumFrequency)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return false;
+    }
+    if (!hasCommandQueue())
+        return false;
+    stopAutostore();
+
+    memcpy(softSeekSettings, &state->softSeek, sizeof(softSeekSettings)); // See setSoftSeekCriteria
+    memset(state, 0, sizeof(si47x_autostore_state));
+    memcpy(&state->softSeek, softSeekSettings, sizeof(softSeekSettings));
+    autostoreState = state;
+    if (tuneState == NULL)
+        setTuneCoalescing(&autostoreState->tune); // The tunes of the scan do not wait for the STC
+    autostoreState->table = table;
+    autostoreState->size = size;
+    autostoreCount = 0;
+    autostoreState->rdsTime = (currentTune == FM_TUNE_FREQ) ? rdsTime : 0;
+    autostoreState->restore = currentWorkFrequency;
+    autostoreState->useSoftSeek = (lastMode == SSB_CURRENT_MODE || currentTune == NBFM_TUNE_FREQ);
+
+    if (!autostoreState->useSoftSeek)
+    {
+        // Seek bottom, top and spacing of the caller: restored at the end (see autostoreTick)
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            value = getProperty(base + i);
+            autostoreState->seekBand[i] = (value < 0) ? 0 : (uint16_t)value;
+        }
+        if (autostoreState->seekBand[0] == 0 || autostoreState->seekBand[1] == 0)
+            autostoreState->seekBand[2] = 0;
+        if (currentTune == FM_TUNE_FREQ)
+        {
+            setSeekFmLimits(currentMinimumFrequency, currentMaximumFrequency);
+            setSeekFmSpacing(currentStep);
+        }
+        else
+        {
+            setSeekAmLimits(currentMinimumFrequency, currentMaximumFrequency);
+            setSeekAmSpacing(currentStep);
+        }
+    }
+
+    autostoreState->state = SI473X_AUTOSTORE_TUNE;
+    requestFrequency(currentMinimumFrequency);
+    return true;
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Runs the band scan for a time slice.
+ *
+ * @details Call this function as often as possible (in the loop function). It returns after about slice us (a step
+ *          that is already running, like an I2C transaction, is not interrupted).
+ *
+ * @param slice time (us) to be spent in this call
+ *
+ * @return true while the scan is in progress.
+ */
+bool SI4735::autostoreTick(uint16_t slice)
+{
+    unsigned long start = micros();
+    uint16_t base;
+
+    if (autostoreState == NULL)
+        return false;
+
+    do
+    {
+        switch (autostoreState->state)
+        {
+        case SI473X_AUTOSTORE_TUNE:
+            if (tuneTick())
+                break;
+            // The seek does not check the starting frequency. The hardware tells if the bottom of the band is a station.
+            if (!autostoreState->useSoftSeek && lastError == SI473X_OK && currentStatus.resp.VALID)
+                collectAutostoreStation();
+            else
+                nextAutostoreSeek();
+            break;
+        case SI473X_AUTOSTORE_SEEK:
+            if ((autostoreState->useSoftSeek) ? softSeekTick() : seekTick())
+                break;
+            if ((autostoreState->useSoftSeek) ? softSeekFound : (currentStatus.resp.VALID != 0))
+                collectAutostoreStation();
+            else if (!autostoreState->useSoftSeek && !currentStatus.resp.BLTF && lastError == SI473X_ERROR_TIMEOUT)
+            {
+                // maxSeekTime (see setMaxSeekTime) ran out before the band limit: goes on from the frequency reached,
+                // checking it first (the seek was cancelled on it)
+                autostoreState->state = SI473X_AUTOSTORE_TUNE;
+                requestFrequency(currentWorkFrequency);
+            }
+            else
+            {
+                autostoreState->state = SI473X_AUTOSTORE_RESTORE; // Band limit: the scan is over
+                requestFrequency(autostoreState->restore);
+            }
+            break;
+        case SI473X_AUTOSTORE_RDS:
+            readAutostoreRds();
+            break;
+        case SI473X_AUTOSTORE_RESTORE:
+            if (tuneTick())
+                break;
+            autostoreState->state = SI473X_AUTOSTORE_IDLE;
+            if (tuneState == &autostoreState->tune)
+                setTuneCoalescing(NULL);
+            if (seekState == &autostoreState->seek)
+                seekState = NULL;
+            if (softSeekState == &autostoreState->softSeek)
+                softSeekState = NULL;
+            if (!autostoreState->useSoftSeek && autostoreState->seekBand[2] != 0)
+            {
+                base = (currentTune == FM_TUNE_FREQ) ? FM_SEEK_BAND_BOTTOM : AM_SEEK_BAND_BOTTOM;
+                for (uint8_t i = 0; i < 3; i++)
+                    sendProperty(base + i, autostoreState->seekBand[i]);
+            }
+            break;
+        }
+    } while (autostoreState->state != SI473X_AUTOSTORE_IDLE && (micros() - start) < slice);
+
+    return autostoreState->state != SI473X_AUTOSTORE_IDLE;
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Measures the station just found and starts collecting its RDS data (FM) or stores it.
+ */
+void SI4735::collectAutostoreStation()
+{
+    getCurrentReceivedSignalQuality(0);
+    autostoreState->station.frequency = currentWorkFrequency;
+    autostoreState->station.rssi = currentRqsStatus.resp.RSSI;
+    autostoreState->station.snr = currentRqsStatus.resp.SNR;
+    autostoreState->station.multipath = (currentTune == FM_TUNE_FREQ) ? currentRqsStatus.resp.MULT : 0;
+    autostoreState->station.pi = 0;
+    memset(autostoreState->station.ps, ' ', 8);
+    autostoreState->station.ps[8] = '\0';
+    autostoreState->psSegments = 0;
+
+    if (autostoreState->rdsTime == 0)
+    {
+        addAutostoreStation();
+        nextAutostoreSeek();
+        return;
+    }
+    getRdsStatus(0, 1, 1); // Empties the FIFO (groups of the previous frequency)
+    autostoreState->rdsMore = false;
+    autostoreState->rdsStart = autostoreState->rdsPoll = millis();
+    autostoreState->state = SI473X_AUTOSTORE_RDS;
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Reads one RDS group (if any) and keeps the PI and the PS segments of the station.
+ */
+void SI4735::readAutostoreRds()
+{
+    si47x_rds_blockb blkB;
+    unsigned long now = millis();
+
+    if (autostoreState->rdsMore || (now - autostoreState->rdsPoll) >= SI473X_AUTOSTORE_RDS_POLL)
+    {
+        autostoreState->rdsPoll = now;
+        getRdsStatus(0, 0, 0); // Takes the oldest group from the FIFO
+        autostoreState->rdsMore = currentRdsStatus.resp.RDSFIFOUSED > 1;
+        if (currentRdsStatus.resp.RDSFIFOUSED > 0)
+        {
+            if (currentRdsStatus.resp.BLEA < 3)
+                autostoreState->station.pi = ((uint16_t)currentRdsStatus.resp.BLOCKAH << 8) | currentRdsStatus.resp.BLOCKAL;
+            blkB.raw.highValue = currentRdsStatus.resp.BLOCKBH;
+            blkB.raw.lowValue = currentRdsStatus.resp.BLOCKBL;
+            if (blkB.group0.groupType == 0 && currentRdsStatus.resp.BLEB < 3 && currentRdsStatus.resp.BLED < 3)
+            {
+                autostoreState->station.ps[blkB.group0.address * 2] = currentRdsStatus.resp.BLOCKDH;
+                autostoreState->station.ps[blkB.group0.address * 2 + 1] = currentRdsStatus.resp.BLOCKDL;
+                autostoreState->psSegments |= 1 << blkB.group0.address;
+            }
+        }
+    }
+
+    if ((autostoreState->psSegments == 0x0F && autostoreState->station.pi != 0) || (now - autostoreState->rdsStart) >= autostoreState->rdsTime)
+    {
+        addAutostoreStation();
+        nextAutostoreSeek();
+    }
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Stores the station in the table (sorted by frequency). If the table is full, the weakest station gives its
+ *        place to a stronger one.
+ */
+void SI4735::addAutostoreStation()
+{
+    uint8_t i;
+
+    if (autostoreState->psSegments == 0)
+        autostoreState->station.ps[0] = '\0'; // No PS (the missing segments of a partial one stay as spaces)
+
+    if (autostoreCount >= autostoreState->size)
+    {
+        uint8_t weakest = 0;
+        for (i = 1; i < autostoreCount; i++)
+            if (autostoreState->table[i].rssi < autostoreState->table[weakest].rssi)
+                weakest = i;
+        if (autostoreState->table[weakest].rssi >= autostoreState->station.rssi)
+            return;
+        for (i = weakest; i + 1 < autostoreCount; i++)
+            autostoreState->table[i] = autostoreState->table[i + 1];
+        autostoreCount--;
+    }
+
+    for (i = autostoreCount; i > 0 && autostoreState->table[i - 1].frequency > autostoreState->station.frequency; i--)
+        autostoreState->table[i] = autostoreState->table[i - 1];
+    autostoreState->table[i] = autostoreState->station;
+    autostoreCount++;
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Starts the seek of the next station (up, halting at the band limit).
+ */
+void SI4735::nextAutostoreSeek()
+{
+    bool started = (autostoreState->useSoftSeek) ? startSoftSeek(&autostoreState->softSeek, 1, 0) : startSeek(&autostoreState->seek, 1, 0);
+
+    if (started)
+        autostoreState->state = SI473X_AUTOSTORE_SEEK;
+    else
+    {
+        autostoreState->state = SI473X_AUTOSTORE_RESTORE;
+        requestFrequency(autostoreState->restore);
+    }
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Ends the band scan. The stations found so far stay in the table and the frequency used before the scan is
+ *        tuned again.
+ */
+void SI4735::stopAutostore()
+{
+    if (!isAutostoring())
+        return;
+    if (autostoreState->state == SI473X_AUTOSTORE_SEEK)
+    {
+        if (autostoreState->useSoftSeek)
+            cancelSoftSeek();
+        else
+            cancelSeek();
+    }
+    autostoreState->state = SI473X_AUTOSTORE_RESTORE;
+    requestFrequency(autostoreState->restore);
+    while (autostoreTick())
+        ;
+}
+
+/**
+ * @ingroup group33 Autostore
+ *
+ * @brief Scans the whole band (blocking version of startAutostore / autostoreTick).
+ *
+ * @details The software seek (SSB and NBFM) uses the default criteria and steps.
+ *
+ * @see startAutostore
+ *
+ * @return uint8_t number of stations stored in the table.
+ */
+uint8_t SI4735::autostore(si47x_station *table, uint8_t size, uint16_t rdsTime)
+{
+    si47x_autostore_state state;
+    si47x_async_command slot;
+    bool lent = lendCommandSlot(&slot);
+
+    memset(&state.softSeek, 0, sizeof(state.softSeek)); // Default software seek settings
+    autostoreCount = 0;
+    if (startAutostore(&state, table, size, rdsTime))
+    {
+        while (autostoreTick())
+            ;
+        autostoreState = NULL; // The state is gone
+    }
+    if (lent)
+        returnCommandSlot();
+    return autostoreCount;
+}
+
+/**
+ * @defgroup group34 Antenna capacitor table
+ *
+ * @section group34 Antenna capacitor table
+ *
+ * @brief Finds the best antenna tuning capacitor (ANTCAP) for your antenna and uses it on every tune.
+ * @details The capacitor selected automatically by the device is not always the best one for an external antenna
+ *          (a loop antenna, for example). findBestAntennaCapacitor starts from the automatic value (READANTCAP) and
+ *          looks for the capacitor with the highest RSSI + SNR, halving the search step at each round. Use a frequency
+ *          with a station.
+ * @details buildAntennaCapacitorTable does it for each segment of a band and stores the results in a small table
+ *          (4 bytes per segment) owned by the caller. While the table is set, each tune of that band (setFrequency,
+ *          frequencyUp, seek and sweep functions etc) gets its capacitor from the table (binary search and linear
+ *          interpolation between the segments), so the device does not have to search for it. The table can be saved (EEPROM) and set again with
+ *          setAntennaCapacitorTable.
+ * @details It works on FM (TXO/LPI antenna input) and LW/MW. On SW the capacitor is not used (see
+ *          setTuneFrequencyAntennaCapacitor).
+ * @code
+ *   si47x_antcap_segment mwCaps[12];
+ *
+ *   rx.setAM(520, 1710, 810, 10);
+ *   rx.buildAntennaCapacitorTable(mwCaps, 12, 520, 1710);  // Takes a few seconds per segment
+ *   ...
+ *   rx.setFrequency(1090);                                 // Capacitor interpolated between 1064 and 1163 kHz
+ *   rx.setAntennaCapacitorTable(NULL, 0);                  // Back to the automatic selection
+ * @endcode
+ */
+
+/**
+ * @ingroup group34 Antenna capacitor table
+ *
+ * @brief Finds the tuning capacitor with the best reception (RSSI + SNR) on a frequency.
+ *
+ * @details Blocking (each try is a normal tune). The search starts at the automatic value and tries span, span / 2,
+ *          ..., 1 capacitor units below and above the best value found so far. At the end, the receiver stays on
+ *          freq with the best capacitor, and the capacitor of the next tunes is the same as before.
+ *
+ * @param freq frequency (current band units)
+ * @param span first search step (0 = SI473X_ANTCAP_SPAN_FM or SI473X_ANTCAP_SPAN_AM)
+ *
+ * @return uint16_t the best capacitor (0 if the mode has no tuning capacitor: SW, NBFM).
+ */
+uint16_t SI4735::findBestAntennaCapacitor(uint16_t freq, uint16_t span)
+{
+    si47x_antcap_segment *table = antcapTable;
+    uint8_t antcapH = currentFrequencyParams.arg.ANTCAPH;
+    uint8_t antcapL = currentFrequencyParams.arg.ANTCAPL;
+    uint16_t maxCap = (currentTune == FM_TUNE_FREQ) ? 191 : 6143;
+    uint16_t best, bestScore, score, cap, tried;
+
+    if (currentTune == NBFM_TUNE_FREQ || (currentTune == AM_TUNE_FREQ && freq > 1800))
+        return 0;
+    if (span == 0)
+        span = (currentTune == FM_TUNE_FREQ) ? SI473X_ANTCAP_SPAN_FM : SI473X_ANTCAP_SPAN_AM;
+
+    antcapTable = NULL; // The tries set the capacitor by themselves
+    bestScore = measureAntennaCapacitor(freq, 0);
+    getStatus(0, 0);
+    best = getAntennaTuningCapacitor(); // Automatic value (READANTCAP)
+    if (best == 0 || best > maxCap)
+        best = 1;
+    tried = 0;
+
+    for (; span > 0; span >>= 1)
+    {
+        for (int8_t side = -1; side <= 1; side += 2)
+        {
+            if (side < 0)
+                cap = (best > span) ? best - span : 1;
+            else
+                cap = (best + span < maxCap) ? best + span : maxCap;
+            if (cap == best)
+                continue;
+            score = measureAntennaCapacitor(freq, cap);
+            tried = cap;
+            if (score > bestScore)
+            {
+                best = cap;
+                bestScore = score;
+                break; // The other side is worse (one peak)
+            }
+        }
+    }
+    if (tried != best) // The device is on a worse capacitor (or on the automatic one)
+        measureAntennaCapacitor(freq, best);
+
+    antcapTable = table;
+    currentFrequencyParams.arg.ANTCAPH = antcapH;
+    currentFrequencyParams.arg.ANTCAPL = antcapL;
+    return best;
+}
+
+/**
+ * @ingroup group34 Antenna capacitor table
+ *
+ * @brief Tunes a frequency with a given capacitor and measures the reception.
+ *
+ * @param freq frequency (current band units)
+ * @param capacitor 0 = automatic
+ *
+ * @return uint16_t RSSI + SNR.
+ */
+uint16_t SI4735::measureAntennaCapacitor(uint16_t freq, uint16_t capacitor)
+{
+    setAntennaCapacitorArguments(capacitor);
+    setFrequency(freq);
+    getCurrentReceivedSignalQuality(0);
+    return (uint16_t)currentRqsStatus.resp.RSSI + currentRqsStatus.resp.SNR;
+}
+
+/**
+ * @ingroup group34 Antenna capacitor table
+ *
+ * @brief Builds the antenna capacitor table of a band and starts using it.
+ *
+ * @details The band is split in size segments of the same width. The best capacitor of each segment is found at its
+ *          center (see findBestAntennaCapacitor). Blocking: it takes up to 2 x log2(span) + 1 tunes per segment. At the
+ *          end, the current frequency is tuned again (with its new capacitor).
+ *
+ * @param table where the segments will be stored
+ * @param size number of segments
+ * @param from first frequency of the band
+ * @param to last frequency of the band
+ * @param span first search step (0 = default; see findBestAntennaCapacitor)
+ *
+ * @return uint8_t number of segments stored (0 if the arguments are invalid or the mode has no tuning capacitor).
+ */
+uint8_t SI4735::buildAntennaCapacitorTable(si47x_antcap_segment *table, uint8_t size, uint16_t from, uint16_t to, uint16_t span)
+{
+    uint16_t width;
+    uint16_t freq = currentWorkFrequency;
+
+    if (table == NULL || size == 0 || to <= from || currentTune == NBFM_TUNE_FREQ)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return 0;
+    }
+    if (size > to - from)
+        size = to - from;
+    width = (to - from) / size;
+
+    cancelTune();
+    for (uint8_t i = 0; i < size; i++)
+    {
+        table[i].frequency = from + i * width + width / 2;
+        table[i].antcap = findBestAntennaCapacitor(table[i].frequency, span);
+    }
+
+    setAntennaCapacitorTable(table, size);
+    setFrequency(freq); // The tries moved the receiver to the segment centers
+    return size;
+}
+
+/**
+ * @ingroup group34 Antenna capacitor table
+ *
+ * @brief Sets the antenna capacitor table used by the tunes of the current band.
+ *
+ * @details The table must be sorted by frequency (like the one built by buildAntennaCapacitorTable) and stay valid
+ *          while it is used. It is used only in the mode (FM or AM/SSB) that is current when this function is called
+ *          and only inside its band: a band change out of it goes back to the automatic selection and coming back to
+ *          the band uses the table again (see lookupAntennaCapacitor).
+ *
+ * @param table the segments or NULL (back to the automatic selection)
+ * @param size number of segments
+ */
+void SI4735::setAntennaCapacitorTable(si47x_antcap_segment *table, uint8_t size)
+{
+    antcapTable = (size > 0) ? table : NULL;
+    antcapTableSize = size;
+    antcapTableTune = currentTune;
+    if (antcapTable == NULL)
+        setAntennaCapacitorArguments((currentTune == AM_TUNE_FREQ) ? 1 : 0); // Power up default (see setPowerUp)
+}
+
+/**
+ * @ingroup group34 Antenna capacitor table
+ *
+ * @brief Returns the capacitor of a frequency from the table.
+ *
+ * @details Binary search for the two segments around freq and linear interpolation between them. Up to half a
+ *          segment below the first and above the last one, the capacitor of that segment is used. Farther (another
+ *          band of the same mode: LW with a MW table, 64-76 MHz with a 87-108 MHz table etc), the capacitor is
+ *          selected automatically. On SW (AM above 1800 kHz) the capacitor is not used: ANTCAPL = 1 (AN332).
+ *
+ * @param freq frequency (current band units)
+ *
+ * @return uint16_t the capacitor or the default one (FM 0 = automatic; AM 1) if no table is set for this mode.
+ */
+uint16_t SI4735::lookupAntennaCapacitor(uint16_t freq)
+{
+    uint8_t low = 0, high = antcapTableSize - 1, middle;
+    uint16_t margin;
+    si47x_antcap_segment *a, *b;
+
+    if (antcapTable == NULL || currentTune != antcapTableTune || (currentTune == AM_TUNE_FREQ && freq > 1800))
+        return (currentTune == AM_TUNE_FREQ) ? 1 : 0;
+    margin = (high > 0) ? (antcapTable[high].frequency - antcapTable[0].frequency) / high / 2 : 0xFFFF;
+    if ((uint32_t)freq + margin < antcapTable[0].frequency || freq > (uint32_t)antcapTable[high].frequency + margin)
+        return 0; // Out of the band of the table: automatic
+    if (freq <= antcapTable[0].frequency)
+        return antcapTable[0].antcap;
+    if (freq >= antcapTable[high].frequency)
+        return antcapTable[high].antcap;
+
+    // antcapTable[low].frequency < freq < antcapTable[high].frequency
+    while (high - low > 1)
+    {
+        middle = (low + high) >> 1;
+        if (antcapTable[middle].frequency <= freq)
+            low = middle;
+        else
+            high = middle;
+    }
+    a = &antcapTable[low];
+    b = &antcapTable[high];
+    return a->antcap + (int16_t)(((int32_t)b->antcap - a->antcap) * (freq - a->frequency) / (b->frequency - a->frequency));
+}
+
+/**
+ * @defgroup group35 Band plan
+ *
+ * @section group35 Band plan
+ *
+ * @brief A band table (name, mode, limits, default frequency, step and bandwidth) kept by the library.
+ * @details The plan is an array of si47x_band declared by the sketch as constexpr and PROGMEM: it is checked at compile
+ *          time by isValidBandPlan and stays in the flash memory (no RAM used on AVR). The AM and SSB bands come first,
+ *          then the FM bands, each group sorted by frequency without overlapping, so findBand is a binary search.
+ * @details setBand selects a band with one call: mode (setFM, setAM or setSSB), limits, step, seek limits and spacing and
+ *          bandwidth. tuneBand tunes a frequency and changes the band only when the frequency is out of the current one.
+ * @details The SSB bands need the SSB patch (see loadPatch) loaded before.
+ * @code
+ *   constexpr si47x_band plan[] PROGMEM = {
+ *       {"LW", SI473X_BAND_AM, 1, 153, 279, 198, 9},
+ *       {"MW", SI473X_BAND_AM, 1, 520, 1710, 810, 10},
+ *       {"41m", SI473X_BAND_AM, 1, 7200, 7450, 7300, 5},
+ *       {"FM", SI473X_BAND_FM, 0, 8750, 10800, 10390, 10}};
+ *   static_assert(SI4735::isValidBandPlan(plan, sizeof(plan) / sizeof(si47x_band)), "invalid band plan");
+ *
+ *   rx.setBandPlan(plan, sizeof(plan) / sizeof(si47x_band));
+ *   rx.setBand(1);           // MW, 810 kHz
+ *   rx.tuneBand(7300);       // 41m band
+ *   rx.tuneBand(9390, true); // FM 93.9 MHz
+ * @endcode
+ */
+
+/**
+ * @ingroup group35 Band plan
+ *
+ * @brief Sets the band plan.
+ *
+ * @details The plan must stay valid while it is used (constexpr PROGMEM array). It is checked again here, band by band.
+ *
+ * @param plan the bands (flash memory) or NULL
+ * @param size number of bands
+ *
+ * @return false if the plan is invalid (see isValidBandPlan); the previous plan is kept.
+ */
+bool SI4735::setBandPlan(const si47x_band *plan, uint8_t size)
+{
+    si47x_band band;
+    uint32_t previousKey = 0; // End of the previous band
+
+    for (uint8_t i = 0; i < size; i++)
+    {
+        memcpy_P(&band, &plan[i], sizeof(si47x_band));
+        if (!isValidBand(band) || previousKey > bandKey(band.mode, band.minimumFrequency))
+        {
+            setError(SI473X_ERROR_INVALID_ARG, 0);
+            return false;
+        }
+        previousKey = bandKey(band.mode, band.maximumFrequency);
+    }
+
+    bandPlan = (size > 0) ? plan : NULL;
+    bandPlanSize = (plan != NULL) ? size : 0;
+    currentBandIdx = SI473X_BAND_NONE;
+    return true;
+}
+
+/**
+ * @ingroup group35 Band plan
+ *
+ * @brief Copies a band of the plan (flash memory) to band.
+ *
+ * @param idx band index (0 to getBandPlanSize() - 1)
+ * @param band where the band will be copied
+ */
+void SI4735::getBand(uint8_t idx, si47x_band *band)
+{
+    if (idx < bandPlanSize)
+        memcpy_P(band, &bandPlan[idx], sizeof(si47x_band));
+}
+
+/**
+ * @ingroup group35 Band plan
+ *
+ * @brief Finds the band of a frequency (binary search).
+ *
+ * @param freq frequency (FM 10 kHz units; AM and SSB kHz)
+ * @param fm true for an FM frequency
+ *
+ * @return uint8_t band index or SI473X_BAND_NONE.
+ */
+uint8_t SI4735::findBand(uint16_t freq, bool fm)
+{
+    uint32_t key = bandKey(fm ? SI473X_BAND_FM : SI473X_BAND_AM, freq);
+    uint8_t low = 0, high = bandPlanSize, middle;
+
+    if (bandPlanSize == 0 || key < bandKey(pgm_read_byte(&bandPlan[0].mode), pgm_read_word(&bandPlan[0].minimumFrequency)))
+        return SI473X_BAND_NONE;
+
+    // Last band that starts at or below freq
+    while (high - low > 1)
+    {
+        middle = (low + high) >> 1;
+        if (bandKey(pgm_read_byte(&bandPlan[middle].mode), pgm_read_word(&bandPlan[middle].minimumFrequency)) <= key)
+            low = middle;
+        else
+            high = middle;
+    }
+    if (key > bandKey(pgm_read_byte(&bandPlan[low].mode), pgm_read_word(&bandPlan[low].maximumFrequency)))
+        return SI473X_BAND_NONE; // Between two bands or out of the FM / AM part of the plan
+    return low;
+}
+
+/**
+ * @ingroup group35 Band plan
+ *
+ * @brief Selects a band of the plan.
+ *
+ * @details Sets the mode (setFM, setAM or setSSB), the limits, the step, the seek limits and spacing (FM and AM) and
+ *          the bandwidth and tunes freq (or the default frequency of the band).
+ *
+ * @param idx band index
+ * @param freq frequency (0 or out of the band = default frequency of the band)
+ *
+ * @return false if idx is invalid.
+ */
+bool SI4735::setBand(uint8_t idx, uint16_t freq)
+{
+    si47x_band band;
+
+    if (idx >= bandPlanSize)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return false;
+    }
+    getBand(idx, &band);
+    if (freq < band.minimumFrequency || freq > band.maximumFrequency)
+        freq = band.defaultFrequency;
+
+    if (band.mode == SI473X_BAND_FM)
+    {
+        setFM(band.minimumFrequency, band.maximumFrequency, freq, band.step);
+        setSeekFmLimits(band.minimumFrequency, band.maximumFrequency);
+        setSeekFmSpacing(band.step);
+        setFmBandwidth(band.bandwidthIdx);
+    }
+    else if (band.mode == SI473X_BAND_AM)
+    {
+        setAM(band.minimumFrequency, band.maximumFrequency, freq, band.step);
+        setSeekAmLimits(band.minimumFrequency, band.maximumFrequency);
+        setSeekAmSpacing(band.step);
+        setBandwidth(band.bandwidthIdx, 1);
+    }
+    else
+    {
+        setSSB(band.minimumFrequency, band.maximumFrequency, freq, band.step, band.mode - 1); // 1 = LSB; 2 = USB (no hardware seek)
+        setSSBAudioBandwidth(band.bandwidthIdx);
+        // The sideband cutoff filter is the band pass one only for the 2.2 to 4 kHz bandwidths
+        setSSBSidebandCutoffFilter((band.bandwidthIdx == 0 || band.bandwidthIdx == 4 || band.bandwidthIdx == 5) ? 0 : 1);
+    }
+    currentBandIdx = idx;
+    return true;
+}
+
+/**
+ * @ingroup group35 Band plan
+ *
+ * @brief Tunes a frequency of the plan, selecting its band only if it is not the current one.
+ *
+ * @param freq frequency (FM 10 kHz units; AM and SSB kHz)
+ * @param fm true for an FM frequency
+ *
+ * @return uint8_t band index or SI473X_BAND_NONE (nothing is done).
+ */
+uint8_t SI4735::tuneBand(uint16_t freq, bool fm)
+{
+    uint8_t idx = findBand(freq, fm);
+
+    if (idx == SI473X_BAND_NONE)
+        return idx;
+    if (idx == currentBandIdx)
+        setFrequency(freq);
+    else
+        setBand(idx, freq);
+    return idx;
+}
+
+/**
+ * @defgroup group36 Mode switch
+ *
+ * @section group36 Mode switch
+ *
+ * @brief Mode changes without losing the settings of each mode.
+ * @details A power up returns every property to its default value. So, the library keeps the last value written to
+ *          each FM property (0x1xxx: bandwidth, soft mute, seek limits, RDS, de-emphasis, blend etc), each AM
+ *          property (0x3xxx) and the last AGC override of each mode (one more entry: see SI473X_MODE_STATE_AGC). The 0x3xxx properties written on SSB are kept
+ *          apart from the AM ones: SSB_RF_AGC_ATTACK_RATE and SSB_RF_AGC_RELEASE_RATE (0x3700 and 0x3701) exist just on
+ *          the SSB patch. After the power up of setFM, setAM or setSSB, the ones of the mode are sent again in just
+ *          one property batch (see beginProperties).
+ * @details setFM and setAM do not power cycle the device if it is already on the mode. getModeSwitchTime returns the
+ *          time spent by the last call.
+ * @details The properties are kept in an array you give the library (see setModeState). Up to its size, properties are
+ *          kept for the three modes together; the next ones are not restored. Without it, nothing is restored.
+ * @code
+ *   si47x_property_cache_entry modeState[12];
+ *   ...
+ *   rx.setModeState(modeState, 12);
+ *   rx.setFM(8400, 10800, 10390, 10);
+ *   rx.setFmBandwidth(1);
+ *   rx.setFMDeEmphasis(1);
+ *   rx.setAM(520, 1710, 810, 10);
+ *   rx.setBandwidth(1, 1);
+ *   rx.setFM(8400, 10800, 10390, 10);  // Bandwidth and de-emphasis restored
+ *   Serial.print(rx.getModeSwitchTime());
+ * @endcode
+ */
+
+/**
+ * @ingroup group36 Mode switch
+ *
+ * @brief Keeps the value of an FM or AM property written to the device.
+ *
+ * @param propertyNumber property number (the other properties are ignored) or 0x1000 / 0x3000 | SI473X_MODE_STATE_AGC
+ *        (AGC override; value = the two arguments)
+ * @param value value written
+ */
+void SI4735::saveModeProperty(uint16_t propertyNumber, uint16_t value)
+{
+    if ((propertyNumber >> 12) == 0x3)
+    {
+        if (lastMode == SSB_CURRENT_MODE)
+            propertyNumber |= SI473X_MODE_STATE_SSB;
+        else if (propertyNumber == SSB_RF_AGC_ATTACK_RATE || propertyNumber == SSB_RF_AGC_RELEASE_RATE)
+            return; // SSB patch only
+    }
+    else if ((propertyNumber >> 12) != 0x1)
+        return; // Common properties (volume, interrupts, reference clock etc) are set by the power up functions
+
+    for (uint8_t i = 0; i < modeStateCount; i++)
+    {
+        if (modeState[i].property == propertyNumber)
+        {
+            modeState[i].value = value;
+            return;
+        }
+    }
+    if (modeStateCount < modeStateSize)
+    {
+        modeState[modeStateCount].property = propertyNumber;
+        modeState[modeStateCount].value = value;
+        modeStateCount++;
+    }
+}
+
+/**
+ * @ingroup group36 Mode switch
+ *
+ * @brief Sends the properties and the AGC override kept for a mode (just after its power up).
+ *
+ * @param mode FM_CURRENT_MODE, AM_CURRENT_MODE or SSB_CURRENT_MODE (lastMode already set to it)
+ */
+void SI4735::restoreModeState(uint8_t mode)
+{
+    uint8_t agc[2];
+    bool agcSet = false;
+
+    beginProperties();
+    for (uint8_t i = 0; i < modeStateCount; i++)
+    {
+        if (modeOfState(modeState[i].property) != mode)
+            continue;
+        if ((modeState[i].property & SI473X_MODE_STATE_AGC) == SI473X_MODE_STATE_AGC)
+        {
+            agc[0] = modeState[i].value >> 8;
+            agc[1] = modeState[i].value & 0xFF;
+            agcSet = true;
+        }
+        else
+            sendProperty(modeState[i].property & ~SI473X_MODE_STATE_SSB, modeState[i].value);
+    }
+    commitProperties();
+
+    if (agcSet)
+        runCommand((mode == FM_CURRENT_MODE) ? FM_AGC_OVERRIDE : AM_AGC_OVERRIDE, 2, agc);
+}
+
+/**
+ * @ingroup group36 Mode switch
+ *
+ * @brief Returns the number of properties (and AGC override) kept for a mode and restored after its next power up.
+ *
+ * @param mode FM_CURRENT_MODE, AM_CURRENT_MODE or SSB_CURRENT_MODE
+ */
+uint8_t SI4735::getModeStateCount(uint8_t mode)
+{
+    uint8_t count = 0;
+
+    for (uint8_t i = 0; i < modeStateCount; i++)
+    {
+        if (modeOfState(modeState[i].property) == mode)
+            count++;
+    }
+    return count;
+}
+
+/**
+ * @ingroup group36 Mode switch
+ *
+ * @brief Forgets the properties kept for the FM, AM and SSB modes. The next power ups will keep the device defaults.
+ */
+void SI4735::clearModeState()
+{
+    modeStateCount = 0;
+}
+
+/**
+ * @defgroup group37 Hz tuning
+ *
+ * @section group37 Hz tuning
+ *
+ * @brief Tunes a frequency in Hz. On SSB, the carrier stays on the 1 kHz grid and the BFO does the rest.
+ * @details On SSB, setFrequencyHz keeps the carrier (TUNE_FREQ, kHz) and changes just the BFO (one SET_PROPERTY, no
+ *          STC wait, no audio click) while the offset from the carrier is within +/- SI473X_BFO_WINDOW Hz (see
+ *          setBfoWindow). Out of the window, the carrier is tuned again to the nearest kHz and the BFO takes the
+ *          remaining +/- 500 Hz. A BFO write with the value already set is skipped (see Property cache).
+ * @details On AM and FM, the frequency is rounded to the step of the tune command (1 kHz on AM; 10 kHz on FM).
+ * @details Example (10 Hz encoder steps):
+ * @code
+ *   rx.setSSB(7000, 7300, 7100, 1, LSB_MODE);
+ *   ...
+ *   if (encoderCount != 0)
+ *       rx.setFrequencyHz(rx.getFrequencyHz() + encoderCount * 10);
+ * @endcode
+ */
+
+/**
+ * @ingroup group37 Hz tuning
+ *
+ * @brief Tunes a frequency given in Hz.
+ *
+ * @details On SSB, only the BFO is changed if the frequency is within the BFO window around the carrier.
+ *
+ * @param frequency frequency in Hz (example: 7074000 for 7.074 MHz)
+ */
+void SI4735::setFrequencyHz(uint32_t frequency)
+{
+    int32_t offset;
+    uint16_t carrier;
+
+    if (currentSsbStatus == 0)
+    {
+        if (currentTune == FM_TUNE_FREQ || currentTune == NBFM_TUNE_FREQ)
+            setFrequency((frequency + 5000) / 10000);
+        else
+            setFrequency((frequency + 500) / 1000);
+        return;
+    }
+
+    offset = (int32_t)(frequency - (uint32_t)currentWorkFrequency * 1000);
+    if (offset > bfoWindow || offset < -(int32_t)bfoWindow)
+    {
+        // Out of the window: the carrier goes to the nearest kHz
+        carrier = (frequency + 500) / 1000;
+        offset = (int32_t)(frequency - (uint32_t)carrier * 1000);
+        setSSBBfo(-offset);
+        setFrequency(carrier);
+        return;
+    }
+    setSSBBfo(-offset);
+}
+
+/**
+ * @ingroup group37 Hz tuning
+ *
+ * @brief Returns the current frequency in Hz (SSB: carrier and BFO offset).
+ *
+ * @return uint32_t frequency in Hz.
+ */
+uint32_t SI4735::getFrequencyHz()
+{
+    if (currentSsbStatus == 0)
+        return (uint32_t)currentWorkFrequency * ((currentTune == FM_TUNE_FREQ || currentTune == NBFM_TUNE_FREQ) ? 10000 : 1000);
+    return (uint32_t)currentWorkFrequency * 1000 + bfoOffset;
+}
+
+/**
+ * @defgroup group38 Priority channel
+ *
+ * @section group38 Priority channel
+ *
+ * @brief Dual watch: checks a priority channel from time to time while you listen to another frequency.
+ * @details Every period, priorityTick mutes the audio, tunes the priority channel (FAST bit), reads one RSQ_STATUS
+ *          after the STC (the TUNE_STATUS of a FAST tune has a rough RSSI and SNR) and, if the signal does not meet
+ *          the criteria (see setPriorityCriteria), tunes back. No fixed delay is used: the audio gap is just the two
+ *          tunes (STC) and a few I2C transactions. getPriorityGap returns the gap of the last check.
+ * @details The state of the watch is kept in a si47x_priority_state declared by the sketch.
+ * @details If the signal meets the criteria, the receiver stays on the priority channel (isOnPriority). From then on,
+ *          the signal is checked every period (RSQ_STATUS, no gap) and the receiver goes back to the previous
+ *          frequency when it falls below the criteria.
+ * @details priorityTick does nothing while a seek, software seek, sweep, autostore, memory scan or coalesced tune is
+ *          in progress.
+ *          Do not call setFrequency (or any other tune function) while a check is in progress (priorityTick returns
+ *          true); call stopPriorityWatch before.
+ * @code
+ *   void onPriority(uint16_t f) { showFrequency(f); }
+ *
+ *   si47x_priority_state watch;
+ *
+ *   rx.setFM(8400, 10800, 10390, 10);
+ *   rx.setPriorityCriteria(&watch, 30, 10);
+ *   rx.startPriorityWatch(&watch, 9390, 2000, onPriority);  // Checks 93.9 MHz every 2 seconds
+ *
+ *   void loop() {
+ *       rx.priorityTick();
+ *       ...
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group38 Priority channel
+ *
+ * @brief Starts watching a priority channel.
+ *
+ * @details The first check happens one period after this call. The channel must be in the current mode and band.
+ *
+ * @param state watch state declared by the sketch (it has to be valid until stopPriorityWatch)
+ * @param frequency priority channel (current band units; 0 = stops watching)
+ * @param period time (ms) between checks
+ * @param onSwitch function called with the new frequency when the receiver goes to or leaves the priority channel (or NULL)
+ */
+void SI4735::startPriorityWatch(si47x_priority_state *state, uint16_t frequency, uint16_t period, void (*onSwitch)(uint16_t))
+{
+    stopPriorityWatch();
+    if (state == NULL || frequency == 0 || !hasCommandQueue())
+        return;
+    // Keeps the criteria (see setPriorityCriteria)
+    memset(&state->frequency, 0, sizeof(si47x_priority_state) - offsetof(si47x_priority_state, frequency));
+    if (state->rssi == 0 && state->snr == 0)
+    {
+        state->rssi = SI473X_PRIORITY_RSSI;
+        state->snr = SI473X_PRIORITY_SNR;
+    }
+    priorityState = state;
+    priorityState->frequency = frequency;
+    priorityState->period = period;
+    priorityState->onSwitch = onSwitch;
+    priorityState->lastCheck = millis();
+}
+
+/**
+ * @ingroup group38 Priority channel
+ *
+ * @brief Runs the priority watch. Call it from the loop function.
+ *
+ * @return true while a check is in progress (the audio is muted and the device is not on the frequency you listen to).
+ */
+bool SI4735::priorityTick()
+{
+    if (priorityState == NULL)
+        return false;
+
+    switch (priorityState->state)
+    {
+    case SI473X_PRIORITY_IDLE:
+        if ((millis() - priorityState->lastCheck) < priorityState->period)
+            break;
+        priorityState->lastCheck = millis();
+        if (isSeeking() || isSoftSeeking() || isSweeping() || isAutostoring() || isScanning() || isTuning())
+            break; // Skips this check
+        if (priorityState->active)
+        {
+            // On the priority channel: just the signal is checked
+            getCurrentReceivedSignalQuality(0);
+            if (currentRqsStatus.resp.RSSI < priorityState->rssi || currentRqsStatus.resp.SNR < priorityState->snr)
+            {
+                priorityState->muted = false;
+                sendPriorityTune(priorityState->home, SI473X_PRIORITY_BACK); // priorityState->active is cleared at the end
+            }
+            break;
+        }
+        // Mutes just if the audio is not muted yet (see setAudioMute and setHardwareAudioMute)
+        priorityState->muted = (audioMuteMcuPin >= 0) ? !hardwareMuted : !audioMuted;
+        priorityState->gapStart = micros();
+        if (priorityState->muted)
+        {
+            if (audioMuteMcuPin >= 0)
+                setHardwareAudioMute(true);
+            else
+                setAudioMute(true);
+        }
+        priorityState->home = currentWorkFrequency;
+        sendPriorityTune(priorityState->frequency, SI473X_PRIORITY_CHECK);
+        break;
+    case SI473X_PRIORITY_MEASURE:
+        commandTick();
+        if (priorityState->handle == 0)
+            priorityState->handle = sendRsqAsync(); // Queue full after the STC. Tries again.
+        if (priorityState->handle == 0 || !isCommandDone(priorityState->handle))
+            break;
+        if (lastError == SI473X_OK && currentRqsStatus.resp.RSSI >= priorityState->rssi && currentRqsStatus.resp.SNR >= priorityState->snr)
+        {
+            // The priority channel takes the receiver
+            priorityState->active = true;
+            currentWorkFrequency = priorityState->frequency;
+            finishPriorityCheck(true);
+        }
+        else
+            sendPriorityTune(priorityState->home, SI473X_PRIORITY_BACK);
+        break;
+    default:
+        commandTick();
+        if (priorityState->handle == 0)
+        {
+            sendPriorityTune((priorityState->state == SI473X_PRIORITY_CHECK) ? priorityState->frequency : priorityState->home, priorityState->state);
+            break;
+        }
+        if (!isCommandDone(priorityState->handle) || !pollSeekTuneComplete(&sweepTiming, priorityState->sentAt, priorityState->lastPoll, priorityState->pollInterval, false))
+            break;
+        if (priorityState->state == SI473X_PRIORITY_CHECK && lastError == SI473X_OK)
+        {
+            // One RSQ_STATUS after the STC acknowledge (queued behind it)
+            priorityState->state = SI473X_PRIORITY_MEASURE;
+            priorityState->handle = sendRsqAsync();
+        }
+        else if (priorityState->state == SI473X_PRIORITY_CHECK)
+            sendPriorityTune(priorityState->home, SI473X_PRIORITY_BACK);
+        else
+        {
+            bool lost = priorityState->active; // false: back from a check that did not switch
+            priorityState->active = false;
+            currentWorkFrequency = priorityState->home;
+            finishPriorityCheck(lost);
+        }
+        break;
+    }
+
+    return priorityState->state != SI473X_PRIORITY_IDLE;
+}
+
+/**
+ * @ingroup group38 Priority channel
+ *
+ * @brief Sends the FAST tune of a priority check step.
+ *
+ * @details If the command queue is full, priorityTick tries again on the next call.
+ *
+ * @param frequency frequency to be tuned
+ * @param state SI473X_PRIORITY_CHECK or SI473X_PRIORITY_BACK
+ */
+void SI4735::sendPriorityTune(uint16_t frequency, uint8_t state)
+{
+    priorityState->state = state;
+    priorityState->handle = sendTuneAsync(frequency, 1);
+    if (priorityState->handle == 0)
+        return;
+    priorityState->sentAt = micros();
+    priorityState->pollInterval = sweepTiming.pollInterval;
+    priorityState->lastPoll = priorityState->sentAt - priorityState->pollInterval;
+    commandTick();
+}
+
+/**
+ * @ingroup group38 Priority channel
+ *
+ * @brief Ends a check: unmutes the audio (if the check muted it), measures the gap and reports a switch.
+ *
+ * @param switched true if the receiver went to or left the priority channel
+ */
+void SI4735::finishPriorityCheck(bool switched)
+{
+    priorityState->state = SI473X_PRIORITY_IDLE;
+    if (priorityState->muted)
+    {
+        if (audioMuteMcuPin >= 0)
+            setHardwareAudioMute(false);
+        else
+            setAudioMute(false);
+        priorityState->gap = micros() - priorityState->gapStart;
+        priorityState->muted = false;
+    }
+    priorityState->lastCheck = millis();
+    if (switched && priorityState->onSwitch != NULL)
+        priorityState->onSwitch(currentWorkFrequency);
+}
+
+/**
+ * @ingroup group38 Priority channel
+ *
+ * @brief Stops watching the priority channel.
+ *
+ * @details A check in progress is finished first (blocking): the receiver goes back to the frequency you were
+ *          listening to. If the receiver is on the priority channel, it stays there.
+ */
+void SI4735::stopPriorityWatch()
+{
+    while (priorityTick())
+        ;
+    priorityState = NULL;
+}
+
+/**
+ * @defgroup group39 Memory scan
+ *
+ * @section group39 Memory scan
+ *
+ * @brief Scans a list of memory channels of any mode (FM, AM, LSB and USB), stopping on the active ones.
+ * @details Each channel is tuned and qualified by its RSQ_STATUS (see setScanCriteria). The scan stops on an active
+ *          channel and unmutes the audio: it stays there while the signal holds, up to the dwell time, and resumes
+ *          when the signal has been gone for the hang time (see setScanTimes) or when resumeScan is called.
+ * @details A mode change is a power cycle (and a patch download for SSB). So, each pass scans the channels by mode
+ *          group: all FM channels, then all AM channels, then all LSB/USB channels (in the list order inside each
+ *          group), starting with the current mode. A pass costs at most one power up per group whatever the order
+ *          of the list. LSB and USB channels share the group: the sideband is just an argument of the tune.
+ * @details The state of the scan (and the lockout of the list) is kept in a si47x_scan_state declared by the sketch.
+ * @details Locked out channels (setScanLockout) are skipped. getScanRate returns the channels checked per second
+ *          (the time on active channels is not counted).
+ * @details scanTick never waits for the STC, but a mode switch (setFM, setAM or the SSB loader and setSSB) blocks.
+ *          Do not call tune functions while the scan runs.
+ * @details The band limits and step follow the channel (see setScanBand): the band of the plan (see setBandPlan), the
+ *          band set when the scan started or the whole range of the mode, so frequencyUp, seek etc work from the
+ *          channel the scan stopped on.
+ * @code
+ *   const si47x_memory_channel memories[] = {{10390, SI473X_BAND_FM}, {810, SI473X_BAND_AM}, {9470, SI473X_BAND_FM},
+ *                                            {7100, SI473X_BAND_LSB}};
+ *   void loadSsb() { rx.loadPatch(ssb_patch_content, size_content, 2); }
+ *   void onStop(uint8_t idx) { showFrequency(memories[idx].frequency); }
+ *
+ *   si47x_scan_state scan;             // Global: no channel locked out at the start
+ *
+ *   rx.setScanTimes(&scan, 10000, 2000); // Up to 10 s on a channel; resumes 2 s after the signal is gone
+ *   rx.setScanSsbLoader(loadSsb);
+ *   rx.startScan(&scan, memories, 4, onStop);
+ *   rx.setScanLockout(2, true);        // Skips 94.7 MHz
+ *
+ *   void loop() {
+ *       rx.scanTick();
+ *       ...
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Starts scanning a channel list.
+ *
+ * @details The audio is muted while the scan looks for an active channel. The scan starts with the channels of the
+ *          current mode.
+ *
+ * @details The lockout bitmap, the criteria and the times of the state are not cleared: a state declared as a global
+ *          variable starts with no channel locked out and the default criteria and times; otherwise call clearScanLockout
+ *          after startScan (and setScanCriteria / setScanTimes before it).
+ *
+ * @param state scan state declared by the sketch (it has to be valid while the scan runs and while its lockout is used)
+ * @param channels channel list (kept by the caller while the scan runs)
+ * @param size number of channels (1 to 255)
+ * @param onStop function called with the channel index when the scan stops on an active channel (or NULL)
+ *
+ * @return false if the state or the list is missing, the list is empty or has an invalid mode (SI473X_ERROR_INVALID_ARG),
+ *         or there is no command queue (SI473X_ERROR_QUEUE_FULL; see setCommandQueue).
+ */
+bool SI4735::startScan(si47x_scan_state *state, const si47x_memory_channel *channels, uint8_t size, void (*onStop)(uint8_t idx))
+{
+    stopScan();
+    if (state == NULL || channels == NULL || size == 0)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return false;
+    }
+    for (uint8_t i = 0; i < size; i++)
+    {
+        if (channels[i].mode > SI473X_BAND_USB)
+        {
+            setError(SI473X_ERROR_INVALID_ARG, 0);
+            return false;
+        }
+    }
+    if (!hasCommandQueue())
+        return false;
+
+    scanState = state;
+    if (scanState->rssi == 0 && scanState->snr == 0)
+    {
+        scanState->rssi = SI473X_SCAN_RSSI;
+        scanState->snr = SI473X_SCAN_SNR;
+    }
+    if (!scanState->timesSet)
+    {
+        scanState->dwell = 0;
+        scanState->hang = SI473X_SCAN_HANG_TIME;
+    }
+    scanState->list = channels;
+    scanState->size = size;
+    scanState->onStop = onStop;
+    scanState->muted = false;
+    scanState->count = 0;
+    scanState->time = 0;
+    scanState->switches = 0;
+    if (tuneState == NULL)
+    {
+        memset(&scanState->tune, 0, sizeof(si47x_tune_state));
+        setTuneCoalescing(&scanState->tune); // The tunes of the scan do not wait for the STC
+    }
+    scanState->homeGroup = (lastMode == SSB_CURRENT_MODE) ? SI473X_BAND_LSB : (lastMode == FM_CURRENT_MODE) ? SI473X_BAND_FM : SI473X_BAND_AM;
+    scanState->homeBand[0] = currentMinimumFrequency;
+    scanState->homeBand[1] = currentMaximumFrequency;
+    scanState->homeBand[2] = currentStep;
+    // Just before the first channel of the current mode group (see nextScanChannel)
+    scanState->group = (lastMode == SSB_CURRENT_MODE) ? 1 : (lastMode == FM_CURRENT_MODE) ? 2 : 0;
+    scanState->idx = size - 1;
+    setScanMute(true);
+    scanState->runStart = millis();
+    scanState->state = SI473X_SCAN_NEXT;
+    return true;
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Runs the memory scan. Call it from the loop function.
+ *
+ * @return true while the scan runs.
+ */
+bool SI4735::scanTick()
+{
+    unsigned long now;
+    bool active;
+
+    if (scanState == NULL)
+        return false;
+
+    switch (scanState->state)
+    {
+    case SI473X_SCAN_NEXT:
+        if (!nextScanChannel())
+            break; // All channels locked out: tries again on the next call
+        switchScanMode(&scanState->list[scanState->idx]);
+        setScanBand(&scanState->list[scanState->idx]);
+        requestFrequency(scanState->list[scanState->idx].frequency);
+        scanState->state = SI473X_SCAN_TUNE;
+        break;
+    case SI473X_SCAN_TUNE:
+        if (tuneTick())
+            break;
+        scanState->count++;
+        getCurrentReceivedSignalQuality(0);
+        if (lastError != SI473X_OK || currentRqsStatus.resp.RSSI < scanState->rssi || currentRqsStatus.resp.SNR < scanState->snr)
+        {
+            scanState->state = SI473X_SCAN_NEXT;
+            break;
+        }
+        now = millis();
+        scanState->time += now - scanState->runStart;
+        scanState->stopAt = scanState->lastRsq = now;
+        scanState->state = SI473X_SCAN_DWELL;
+        setScanMute(false);
+        if (scanState->onStop != NULL)
+            scanState->onStop(scanState->idx);
+        break;
+    case SI473X_SCAN_DWELL:
+    case SI473X_SCAN_HANG:
+        now = millis();
+        if (scanState->dwell != 0 && (now - scanState->stopAt) >= scanState->dwell)
+        {
+            resumeScan();
+            break;
+        }
+        if ((now - scanState->lastRsq) < SI473X_SCAN_POLL)
+            break;
+        scanState->lastRsq = now;
+        getCurrentReceivedSignalQuality(0);
+        active = currentRqsStatus.resp.RSSI >= scanState->rssi && currentRqsStatus.resp.SNR >= scanState->snr;
+        if (active)
+            scanState->state = SI473X_SCAN_DWELL; // The signal is back
+        else
+        {
+            if (scanState->state == SI473X_SCAN_DWELL)
+            {
+                scanState->state = SI473X_SCAN_HANG;
+                scanState->lostAt = now;
+            }
+            if ((now - scanState->lostAt) >= scanState->hang)
+                resumeScan();
+        }
+        break;
+    }
+
+    return scanState->state != SI473X_SCAN_IDLE;
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Selects the next channel to be scanned: next one of the current mode group or first one of the next group.
+ *
+ * @details The list is walked as group 0 (FM), group 1 (AM) and group 2 (SSB) in turn; position = group x size + index.
+ *          Locked out channels are skipped, as the LSB/USB channels when the patch cannot be loaded.
+ *
+ * @return false if no channel can be scanned.
+ */
+bool SI4735::nextScanChannel()
+{
+    uint16_t total = (uint16_t)scanState->size * 3;
+    uint16_t position = (uint16_t)scanState->group * scanState->size + scanState->idx;
+    uint8_t group, idx;
+
+    for (uint16_t n = 0; n < total; n++)
+    {
+        position = (position + 1 < total) ? position + 1 : 0;
+        group = position / scanState->size;
+        idx = position % scanState->size;
+        if (scanGroupOf(scanState->list[idx].mode) != group || isScanLocked(idx))
+            continue;
+        if (group == SI473X_BAND_LSB && lastMode != SSB_CURRENT_MODE && scanSsbLoader == NULL)
+            continue; // The device has no SSB patch
+        scanState->group = group;
+        scanState->idx = idx;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Sets the mode of a channel. Nothing is sent if the device is already on it (LSB and USB: just the sideband).
+ *
+ * @param channel channel to be tuned
+ */
+void SI4735::switchScanMode(const si47x_memory_channel *channel)
+{
+    bool muted = (audioMuteMcuPin >= 0) ? hardwareMuted : audioMuted; // Muted by the scan or by the user
+
+    if (channel->mode == SI473X_BAND_FM)
+    {
+        if (lastMode == FM_CURRENT_MODE)
+            return;
+        setFM();
+    }
+    else if (channel->mode == SI473X_BAND_AM)
+    {
+        if (lastMode == AM_CURRENT_MODE)
+            return;
+        setAM();
+    }
+    else
+    {
+        if (lastMode == SSB_CURRENT_MODE)
+        {
+            currentSsbStatus = channel->mode - 1; // 1 = LSB; 2 = USB (argument of the tune)
+            return;
+        }
+        scanSsbLoader();
+        setSSB(channel->mode - 1);
+    }
+    scanState->switches++;
+    if (!muted)
+        return;
+    // The power up unmutes the audio
+    if (audioMuteMcuPin >= 0)
+        setHardwareAudioMute(true);
+    else
+        setAudioMute(true);
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Sets the band limits and step for a channel.
+ *
+ * @details The band of the plan that has the channel (see findBand); otherwise the band set when the scan started if
+ *          the channel is in it and of the same mode group; otherwise the whole range of the mode (SI473X_SCAN_FM_BAND
+ *          or SI473X_SCAN_AM_BAND).
+ *
+ * @param channel channel to be tuned
+ */
+void SI4735::setScanBand(const si47x_memory_channel *channel)
+{
+    static const uint16_t fmBand[3] PROGMEM = {SI473X_SCAN_FM_BAND};
+    static const uint16_t amBand[3] PROGMEM = {SI473X_SCAN_AM_BAND};
+    uint8_t group = scanGroupOf(channel->mode);
+    uint8_t idx = findBand(channel->frequency, group == SI473X_BAND_FM);
+    si47x_band band;
+
+    if (idx != SI473X_BAND_NONE)
+    {
+        getBand(idx, &band);
+        currentMinimumFrequency = band.minimumFrequency;
+        currentMaximumFrequency = band.maximumFrequency;
+        currentStep = band.step;
+    }
+    else if (group == scanState->homeGroup && channel->frequency >= scanState->homeBand[0] && channel->frequency <= scanState->homeBand[1])
+    {
+        currentMinimumFrequency = scanState->homeBand[0];
+        currentMaximumFrequency = scanState->homeBand[1];
+        currentStep = scanState->homeBand[2];
+    }
+    else
+    {
+        const uint16_t *range = (group == SI473X_BAND_FM) ? fmBand : amBand;
+        currentMinimumFrequency = pgm_read_word(&range[0]);
+        currentMaximumFrequency = pgm_read_word(&range[1]);
+        currentStep = pgm_read_word(&range[2]);
+    }
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Mutes or unmutes the audio for the scan (MCU pin if set by setAudioMuteMcuPin).
+ *
+ * @details The audio is muted just if it is not muted yet (see setAudioMute and setHardwareAudioMute), and unmuted just
+ *          if the scan muted it.
+ *
+ * @param value true = mute
+ */
+void SI4735::setScanMute(bool value)
+{
+    if (value)
+    {
+        scanState->muted = (audioMuteMcuPin >= 0) ? !hardwareMuted : !audioMuted;
+        if (!scanState->muted)
+            return;
+    }
+    else if (!scanState->muted)
+        return;
+    else
+        scanState->muted = false;
+
+    if (audioMuteMcuPin >= 0)
+        setHardwareAudioMute(value);
+    else
+        setAudioMute(value);
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Leaves the active channel the scan stopped on and looks for the next one.
+ */
+void SI4735::resumeScan()
+{
+    if (!isScanStopped())
+        return;
+    setScanMute(true);
+    scanState->runStart = millis();
+    scanState->state = SI473X_SCAN_NEXT;
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Stops the scan. The receiver stays on the channel tuned (a tune in progress is finished first) and the audio
+ *        is unmuted.
+ *
+ * @details The state stays attached: the lockout and the statistics (getScanCount, getScanRate etc) can still be used.
+ */
+void SI4735::stopScan()
+{
+    if (!isScanning())
+        return;
+    if (scanState->state == SI473X_SCAN_NEXT || scanState->state == SI473X_SCAN_TUNE)
+    {
+        flushTune();
+        scanState->time += millis() - scanState->runStart;
+    }
+    if (tuneState == &scanState->tune)
+        setTuneCoalescing(NULL);
+    setScanMute(false);
+    scanState->state = SI473X_SCAN_IDLE;
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Locks out (skips) or unlocks a channel of the list. The lockout is kept in the scan state (see startScan) by
+ *        the next startScan calls.
+ *
+ * @param idx channel index
+ * @param locked true = the scan skips the channel
+ */
+void SI4735::setScanLockout(uint8_t idx, bool locked)
+{
+    if (scanState == NULL)
+        return;
+    if (locked)
+        scanState->lockout[idx >> 3] |= (uint8_t)(1 << (idx & 7));
+    else
+        scanState->lockout[idx >> 3] &= (uint8_t)~(1 << (idx & 7));
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Returns true if a channel is locked out (see setScanLockout).
+ */
+bool SI4735::isScanLocked(uint8_t idx)
+{
+    return scanState != NULL && (scanState->lockout[idx >> 3] & (1 << (idx & 7))) != 0;
+}
+
+/**
+ * @ingroup group39 Memory scan
+ *
+ * @brief Returns the scan speed: channels checked per second since startScan.
+ *
+ * @details The time on active channels (dwell and hang) is not counted; mode switches are.
+ */
+uint16_t SI4735::getScanRate()
+{
+    uint32_t time;
+
+    if (scanState == NULL)
+        return 0;
+    time = scanState->time;
+    if (scanState->state == SI473X_SCAN_NEXT || scanState->state == SI473X_SCAN_TUNE)
+        time += millis() - scanState->runStart;
+    return (time == 0) ? 0 : (uint16_t)((uint32_t)scanState->count * 1000 / time);
+}
+
+/**
+ * @defgroup group40 Signal snapshot
+ *
+ * @section group40 Signal snapshot
+ *
+ * @brief All the signal indicators of the current channel in one reading, cached for a short time.
+ * @details A display usually shows several indicators (S-meter, SNR, stereo, AGC etc) and each widget calling
+ *          getCurrentReceivedSignalQuality or getAutomaticGainControl costs a full I2C round trip. getSignalSnapshot
+ *          reads RSQ_STATUS and AGC_STATUS once and fills a si47x_signal_snapshot with the time of the reading. With a
+ *          cache declared by the sketch (setSnapshotCache), the calls within the TTL (setSnapshotTtl; default
+ *          SI473X_SNAPSHOT_TTL) return the cached snapshot without any I2C transaction. After any tune or seek (even to the same frequency), BFO change or mode change, the device is read again.
+ * @details A reading also updates the values returned by getCurrentRSSI, getCurrentSNR, getAgcGainIndex etc.
+ * @code
+ *   si47x_snapshot_cache snapshotCache;
+ *
+ *   rx.setSnapshotCache(&snapshotCache);
+ *
+ *   void loop() {
+ *       si47x_signal_snapshot s = rx.getSignalSnapshot();
+ *       showSMeter(s.rssi);
+ *       showStereo(s.pilot);
+ *       ...
+ *       showAgc(rx.getSignalSnapshot().agcIndex); // Same reading: no I2C transaction
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group40 Signal snapshot
+ *
+ * @brief Returns the signal snapshot of the current channel, from the cache if it is recent enough.
+ *
+ * @details If the reading fails, the previous snapshot is returned (check getLastError) and the next call reads the
+ *          device again. Without a cache (see setSnapshotCache), the device is always read and a failed reading
+ *          returns a cleared snapshot.
+ *
+ * @param refresh true = reads the device even if the cached snapshot is recent
+ *
+ * @return si47x_signal_snapshot
+ */
+si47x_signal_snapshot SI4735::getSignalSnapshot(bool refresh)
+{
+    si47x_signal_snapshot snapshot;
+
+    if (snapshotCache == NULL)
+    {
+        memset(&snapshot, 0, sizeof(snapshot));
+        readSignalSnapshot(&snapshot);
+        return snapshot;
+    }
+    if (refresh || !snapshotCache->valid || snapshotCache->mode != lastMode ||
+        snapshotCache->snapshot.frequency != currentWorkFrequency || (millis() - snapshotCache->snapshot.timestamp) >= snapshotTtl)
+    {
+        snapshotCache->valid = readSignalSnapshot(&snapshotCache->snapshot);
+        snapshotCache->mode = lastMode;
+        if (snapshotCache->valid)
+            snapshotCache->reads++;
+    }
+    else
+        snapshotCache->hits++;
+    return snapshotCache->snapshot;
+}
+
+/**
+ * @ingroup group40 Signal snapshot
+ *
+ * @brief Sets the cache of the signal snapshot.
+ *
+ * @details Without a cache (default), each getSignalSnapshot call reads the device.
+ *
+ * @param cache snapshot cache declared by the sketch (NULL = no cache)
+ */
+void SI4735::setSnapshotCache(si47x_snapshot_cache *cache)
+{
+    snapshotCache = cache;
+    if (cache != NULL)
+        memset(cache, 0, sizeof(si47x_snapshot_cache));
+}
+
+/**
+ * @ingroup group40 Signal snapshot
+ *
+ * @brief Reads RSQ_STATUS and AGC_STATUS (two I2C round trips) into a snapshot.
+ *
+ * @param snapshot filled just if the reading succeeds
+ *
+ * @return false if the reading failed (see getLastError).
+ */
+bool SI4735::readSignalSnapshot(si47x_signal_snapshot *snapshot)
+{
+    bool fm = (currentTune == FM_TUNE_FREQ);
+
+    getCurrentReceivedSignalQuality(0);
+    if (lastError != SI473X_OK)
+        return false;
+    getAutomaticGainControl();
+    if (lastError != SI473X_OK)
+        return false;
+
+    snapshot->timestamp = millis();
+    snapshot->frequency = currentWorkFrequency;
+    snapshot->rssi = currentRqsStatus.resp.RSSI;
+    snapshot->snr = currentRqsStatus.resp.SNR;
+    // AM_RSQ_STATUS has no multipath, blend, pilot or offset (6 bytes response)
+    snapshot->multipath = (fm) ? currentRqsStatus.resp.MULT : 0;
+    snapshot->blend = (fm) ? currentRqsStatus.resp.STBLEND : 0;
+    snapshot->freqOffset = (fm) ? (int8_t)currentRqsStatus.resp.FREQOFF : 0;
+    snapshot->agcIndex = currentAgcStatus.refined.AGCIDX;
+    snapshot->valid = currentRqsStatus.resp.VALID;
+    snapshot->pilot = (fm) ? currentRqsStatus.resp.PILOT : 0;
+    snapshot->afcRail = currentRqsStatus.resp.AFCRL;
+    snapshot->softMute = currentRqsStatus.resp.SMUTE;
+    snapshot->agcDisabled = currentAgcStatus.refined.AGCDIS;
+    snapshot->fm = fm;
+    return true;
+}
+
+/**
+ * @defgroup group41 Signal monitor
+ *
+ * @section group41 Signal monitor
+ *
+ * @brief Signal indicators updated by the RSQ interrupt instead of periodic RSQ_STATUS reads.
+ * @details startSignalMonitor programs RSSI and SNR threshold windows around the current signal (RSQ interrupt
+ *          properties: FM_RSQ_*, AM_RSQ_* or SSB_RSQ_* and NBFM_RSQ_*). The device sets RSQINT when the signal leaves
+ *          a window. signalMonitorTick then reads RSQ_STATUS (acknowledging the interrupt), centers the windows on the
+ *          new values and calls your function. While the signal holds, no RSQ_STATUS is read.
+ * @details In interrupt mode (setInterruptPin), the RSQ interrupt is enabled on the GPO2/INT pin and
+ *          signalMonitorTick does not use the I2C bus until a pulse arrives. In polling mode, it checks RSQINT with a
+ *          GET_INT_STATUS (one byte each way) every SI473X_RSQ_MONITOR_POLL ms.
+ * @details After a tune, the new channel is usually out of the windows: the change is reported by the next interrupt.
+ *          After a mode change, the windows are programmed again for the new mode.
+ * @details The state of the monitor is kept in a si47x_signal_monitor_state declared by the sketch.
+ * @details The thresholds can also be set directly (setRsqInterrupts, setRsqRssiThreshold and setRsqSnrThreshold).
+ * @code
+ *   si47x_signal_monitor_state monitor;
+ *
+ *   void onSignal(uint8_t rssi, uint8_t snr) { showSMeter(rssi); showSnr(snr); }
+ *
+ *   rx.setInterruptPin(INT_PIN);
+ *   rx.setFM(8400, 10800, 10390, 10);
+ *   rx.startSignalMonitor(&monitor, 3, 3, onSignal);  // Reports changes larger than 3 dB
+ *
+ *   void loop() {
+ *       rx.signalMonitorTick();
+ *       ...
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Returns an RSQ interrupt property of the current mode (FM 0x12xx, AM/SSB 0x32xx or NBFM 0x52xx).
+ *
+ * @param offset 0 = interrupt sources; 1 = SNR high; 2 = SNR low; 3 = RSSI high; 4 = RSSI low
+ */
+uint16_t SI4735::rsqProperty(uint8_t offset)
+{
+    if (currentTune == FM_TUNE_FREQ)
+        return FM_RSQ_INT_SOURCE + offset;
+    if (currentTune == NBFM_TUNE_FREQ)
+        return NBFM_RSQ_INT_SOURCE + offset;
+    return AM_RSQ_INTERRUPTS + offset;
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Selects the RSQ interrupt sources of the current mode.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 103 and 166
+ *
+ * @param sources SI473X_RSQ_RSSI_LOW, SI473X_RSQ_RSSI_HIGH, SI473X_RSQ_SNR_LOW and SI473X_RSQ_SNR_HIGH (FM also
+ *                SI473X_RSQ_MULT_LOW, SI473X_RSQ_MULT_HIGH and SI473X_RSQ_BLEND) combined; 0 = disabled (default)
+ */
+void SI4735::setRsqInterrupts(uint8_t sources)
+{
+    sendProperty(rsqProperty(0), sources);
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Sets the RSSI window of the RSQ interrupt (current mode).
+ *
+ * @param low the interrupt is set when the RSSI falls below this value (dBuV; default 0)
+ * @param high the interrupt is set when the RSSI rises above this value (dBuV; default 127)
+ */
+void SI4735::setRsqRssiThreshold(uint8_t low, uint8_t high)
+{
+    sendProperty(rsqProperty(4), low);
+    sendProperty(rsqProperty(3), high);
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Sets the SNR window of the RSQ interrupt (current mode).
+ *
+ * @param low the interrupt is set when the SNR falls below this value (dB; default 0)
+ * @param high the interrupt is set when the SNR rises above this value (dB; default 127)
+ */
+void SI4735::setRsqSnrThreshold(uint8_t low, uint8_t high)
+{
+    sendProperty(rsqProperty(2), low);
+    sendProperty(rsqProperty(1), high);
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Sets the RSSI and SNR windows around the last RSQ_STATUS (currentRqsStatus).
+ */
+void SI4735::centerRsqWindow()
+{
+    uint8_t rssi = rsqState->rssi = currentRqsStatus.resp.RSSI;
+    uint8_t snr = rsqState->snr = currentRqsStatus.resp.SNR;
+
+    // Values not changed since the last call are not sent (see Property cache)
+    setRsqRssiThreshold((rssi > rsqState->rssiWindow) ? rssi - rsqState->rssiWindow : 0, (rssi + rsqState->rssiWindow < 127) ? rssi + rsqState->rssiWindow : 127);
+    setRsqSnrThreshold((snr > rsqState->snrWindow) ? snr - rsqState->snrWindow : 0, (snr + rsqState->snrWindow < 127) ? snr + rsqState->snrWindow : 127);
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Starts monitoring the signal of the current channel.
+ *
+ * @details Reads RSQ_STATUS, programs the windows (one property batch) and the interrupt sources and, in interrupt
+ *          mode, adds the RSQ interrupt to the GPO2/INT sources.
+ *
+ * @param state monitor state declared by the sketch (it has to be valid until stopSignalMonitor)
+ * @param rssiWindow change of the RSSI (dB) reported (1 to 127)
+ * @param snrWindow change of the SNR (dB) reported (1 to 127)
+ * @param onChange function called with the new RSSI and SNR after each change (or NULL)
+ */
+void SI4735::startSignalMonitor(si47x_signal_monitor_state *state, uint8_t rssiWindow, uint8_t snrWindow, void (*onChange)(uint8_t rssi, uint8_t snr))
+{
+    stopSignalMonitor();
+    if (state == NULL)
+        return;
+    memset(state, 0, sizeof(si47x_signal_monitor_state));
+    rsqState = state;
+    rsqState->rssiWindow = (rssiWindow == 0) ? 1 : rssiWindow;
+    rsqState->snrWindow = (snrWindow == 0) ? 1 : snrWindow;
+    rsqState->onChange = onChange;
+    armSignalMonitor();
+
+    if (interruptPin >= 0 && !(interruptSources & 0x0008))
+    {
+        interruptSources |= 0x0008; // RSQIEN
+        rsqState->ienAdded = true;
+        sendProperty(GPO_IEN, interruptSources);
+    }
+    interruptFlags.refined.RSQINT = 0;
+    rsqState->lastPoll = millis();
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Programs the windows and the interrupt sources of the current mode.
+ */
+void SI4735::armSignalMonitor()
+{
+    getCurrentReceivedSignalQuality(1); // Clears a pending RSQ interrupt
+    beginProperties();
+    centerRsqWindow();
+    commitProperties();
+    // After the thresholds (a batch is sent in property order)
+    setRsqInterrupts(SI473X_RSQ_RSSI_LOW | SI473X_RSQ_RSSI_HIGH | SI473X_RSQ_SNR_LOW | SI473X_RSQ_SNR_HIGH);
+    rsqState->tune = currentTune;
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Runs the signal monitor. Call it from the loop function.
+ *
+ * @return true if the signal changed (the new values are in currentRqsStatus: getCurrentRSSI, getCurrentSNR etc).
+ */
+bool SI4735::signalMonitorTick()
+{
+    if (rsqState == NULL || !poweredUp)
+        return false;
+    if (rsqState->tune != currentTune)
+    {
+        armSignalMonitor(); // Power up or mode change: the thresholds are gone
+        return false;
+    }
+
+    if (interruptPin >= 0)
+    {
+        checkInterrupt();
+        if (!interruptFlags.refined.RSQINT)
+            return false;
+        interruptFlags.refined.RSQINT = 0;
+    }
+    else
+    {
+        if ((millis() - rsqState->lastPoll) < SI473X_RSQ_MONITOR_POLL)
+            return false;
+        rsqState->lastPoll = millis();
+        if (!getInterruptStatus().refined.RSQINT)
+            return false;
+    }
+
+    getCurrentReceivedSignalQuality(1); // Acknowledges the RSQ interrupt
+    if (lastError != SI473X_OK)
+        return false;
+    // Still inside the windows: the interrupt was latched by a measurement done before the windows moved
+    if (abs((int)currentRqsStatus.resp.RSSI - rsqState->rssi) <= rsqState->rssiWindow && abs((int)currentRqsStatus.resp.SNR - rsqState->snr) <= rsqState->snrWindow)
+        return false;
+    beginProperties();
+    centerRsqWindow();
+    commitProperties();
+    invalidateSignalSnapshot();
+    rsqState->events++;
+    if (rsqState->onChange != NULL)
+        rsqState->onChange(currentRqsStatus.resp.RSSI, currentRqsStatus.resp.SNR);
+    return true;
+}
+
+/**
+ * @ingroup group41 Signal monitor
+ *
+ * @brief Stops the signal monitor: disables the RSQ interrupt sources (and the GPO2/INT RSQ interrupt it enabled).
+ */
+void SI4735::stopSignalMonitor()
+{
+    if (rsqState == NULL)
+        return;
+    setRsqInterrupts(0);
+    if (rsqState->ienAdded)
+    {
+        interruptSources &= ~0x0008;
+        sendProperty(GPO_IEN, interruptSources);
+    }
+    rsqState = NULL;
+}
+
+/**
+ * @defgroup group42 S-meter
+ *
+ * @section group42 S-meter
+ *
+ * @brief S-meter and signal statistics computed from the RSQ samples with integer arithmetic only.
+ * @details Each sample (RSSI and SNR) updates:
+ *          - an exponential average with 1/16 dB resolution, for a steady bar or needle (setMeterSmoothing);
+ *          - a peak that is held for a while and then decays (setMeterPeak);
+ *          - the minimum, maximum and mean of consecutive windows (setMeterTimes and getSignalStats).
+ * @details The dBm and S-unit conversions take the RSSI in dBuV (50 ohms: 0 dBm = 107 dBuV) plus the calibration
+ *          offset of the current mode (setMeterCalibration). S9 is -73 dBm on AM and SSB and -93 dBm on FM and NBFM,
+ *          with 6 dB per S-unit.
+ * @details meterTick takes a sample every SI473X_METER_PERIOD ms with getSignalSnapshot, so a recent snapshot read by
+ *          other parts of the sketch costs no I2C transaction (see setSnapshotCache). meterSample takes the values your sketch already has
+ *          (for example, after getCurrentReceivedSignalQuality). After a mode change the meter starts again.
+ * @details The average, the peak, the statistics and the settings (smoothing, peak, times and calibration) are kept
+ *          in a si47x_meter_state declared by the sketch (see startMeter). Without it, the conversions use no calibration.
+ * @details There is no floating point: a sample costs a few 16-bit additions and shifts (a division closes each
+ *          window), cheap enough for the sampling rate on an ATmega328.
+ * @code
+ *   si47x_meter_state meter;
+ *
+ *   rx.startMeter(&meter);
+ *   rx.setMeterCalibration(AM_CURRENT_MODE, -3); // The RSSI of this receiver reads 3 dB high on AM
+ *
+ *   void loop() {
+ *       if (rx.meterTick()) {
+ *           uint8_t over;
+ *           uint8_t s = rx.getSMeter(&over);       // S7, S9+20 etc
+ *           showBar(rx.getMeterRssi(), rx.getMeterPeak());
+ *           showStats(rx.getSignalStats());        // min, max and mean of the last second
+ *       }
+ *       ...
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Adds a sample to the S-meter.
+ *
+ * @details The first sample after startMeter, resetMeter or a mode change sets the average and the peak directly.
+ *
+ * @param rssi received signal strength (dBuV)
+ * @param snr signal to noise ratio (dB)
+ */
+void SI4735::meterSample(uint8_t rssi, uint8_t snr)
+{
+    unsigned long now = millis();
+
+    if (meterState == NULL)
+        return;
+    if (meterState->mode != lastMode)
+    {
+        meterState->mode = lastMode;
+        meterState->rssi = (uint16_t)rssi << 4;
+        meterState->snr = (uint16_t)snr << 4;
+        meterState->peak = rssi;
+        meterState->peakAt = now;
+        meterState->stats.samples = 0;
+        openMeterWindow(now);
+    }
+    else
+    {
+        meterState->rssi = smoothMeter(meterState->rssi, rssi);
+        meterState->snr = smoothMeter(meterState->snr, snr);
+        if (rssi >= getMeterPeak())
+        {
+            meterState->peak = rssi;
+            meterState->peakAt = now;
+        }
+        if ((now - meterState->windowStart) >= meterState->window)
+        {
+            meterState->stats.timestamp = now;
+            meterState->stats.samples = meterState->count;
+            meterState->stats.rssiMin = meterState->rssiMin;
+            meterState->stats.rssiMax = meterState->rssiMax;
+            meterState->stats.rssiMean = (uint8_t)((meterState->rssiSum + meterState->count / 2) / meterState->count);
+            meterState->stats.snrMin = meterState->snrMin;
+            meterState->stats.snrMax = meterState->snrMax;
+            meterState->stats.snrMean = (uint8_t)((meterState->snrSum + meterState->count / 2) / meterState->count);
+            // Back to back windows unless the samples stopped for a while
+            openMeterWindow(((now - meterState->windowStart) < 2 * (uint32_t)meterState->window) ? meterState->windowStart + meterState->window : now);
+        }
+    }
+
+    meterState->count++;
+    meterState->rssiSum += rssi;
+    meterState->snrSum += snr;
+    if (rssi < meterState->rssiMin)
+        meterState->rssiMin = rssi;
+    if (rssi > meterState->rssiMax)
+        meterState->rssiMax = rssi;
+    if (snr < meterState->snrMin)
+        meterState->snrMin = snr;
+    if (snr > meterState->snrMax)
+        meterState->snrMax = snr;
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Moves an average (1/16 dB) towards a sample by 1/2^shift of the difference (see setMeterSmoothing).
+ *
+ * @details The step is rounded to the nearest, so the average settles within 1/4 dB of a steady signal.
+ */
+uint16_t SI4735::smoothMeter(uint16_t average, uint8_t sample)
+{
+    int16_t diff = (int16_t)((uint16_t)sample << 4) - (int16_t)average;
+
+    if (meterState->shift == 0)
+        return (uint16_t)sample << 4;
+    return (uint16_t)((int16_t)average + ((diff + (1 << (meterState->shift - 1))) >> meterState->shift));
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Starts a new statistics window.
+ */
+void SI4735::openMeterWindow(unsigned long now)
+{
+    meterState->windowStart = now;
+    meterState->count = 0;
+    meterState->rssiSum = meterState->snrSum = 0;
+    meterState->rssiMin = meterState->snrMin = 0xFF;
+    meterState->rssiMax = meterState->snrMax = 0;
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Takes a sample every period (see setMeterTimes). Call it from the loop function.
+ *
+ * @details The sample comes from getSignalSnapshot: with a snapshot cache (setSnapshotCache), a snapshot read by other
+ *          code since the last sample costs no I2C transaction. After a mode change, the sample is taken at once.
+ *
+ * @return true if a sample was taken (the S-meter values changed); false without a meter state (see startMeter).
+ */
+bool SI4735::meterTick()
+{
+    si47x_signal_snapshot snapshot;
+
+    if (meterState == NULL || ((millis() - meterState->lastSample) < meterState->period && meterState->mode == lastMode))
+        return false;
+    if (snapshotCache == NULL)
+    {
+        if (!readSignalSnapshot(&snapshot))
+            return false;
+    }
+    else
+    {
+        // A snapshot read by other code since the last sample is used; the one of the last sample is not
+        snapshot = getSignalSnapshot(snapshotCache->valid && snapshotCache->snapshot.timestamp == meterState->readAt);
+        if (!snapshotCache->valid)
+            return false;
+    }
+    meterState->readAt = snapshot.timestamp;
+    // Keeps the sampling rate: the next sample is due one period after this one was due, not after it was read
+    if (meterState->mode == lastMode && (millis() - meterState->lastSample) < 2 * (uint32_t)meterState->period)
+        meterState->lastSample += meterState->period;
+    else
+        meterState->lastSample = millis();
+    meterSample(snapshot.rssi, snapshot.snr);
+    return true;
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Starts the S-meter with a state declared by the sketch.
+ *
+ * @details Without a state, meterTick and meterSample do nothing and the meter values are 0. The settings are set to
+ *          their defaults (SI473X_METER_SMOOTHING, SI473X_METER_PERIOD etc; no calibration): change them after this call
+ *          (setMeterSmoothing, setMeterPeak, setMeterTimes and setMeterCalibration).
+ *
+ * @param state meter state (it has to be valid until stopMeter; NULL = stops the meter)
+ */
+void SI4735::startMeter(si47x_meter_state *state)
+{
+    meterState = state;
+    if (state == NULL)
+        return;
+    memset(state->calibration, 0, sizeof(state->calibration));
+    state->shift = SI473X_METER_SMOOTHING;
+    state->peakDecay = SI473X_METER_PEAK_DECAY;
+    state->peakHold = SI473X_METER_PEAK_HOLD;
+    state->period = SI473X_METER_PERIOD;
+    state->window = SI473X_METER_WINDOW;
+    resetMeter();
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Drops the average, the peak and the statistics: the next sample starts the meter again.
+ *
+ * @details The settings (calibration offsets included) are kept.
+ */
+void SI4735::resetMeter()
+{
+    if (meterState == NULL)
+        return;
+    memset(&meterState->mode, 0, sizeof(si47x_meter_state) - offsetof(si47x_meter_state, mode));
+    meterState->mode = 0xFF;
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Sets the calibration offset of a mode, added to the RSSI by the dBm and S-unit conversions.
+ *
+ * @details The offset corrects the RSSI of a given receiver and antenna input against a reference signal generator.
+ *          Call it after startMeter (the offsets are kept in the meter state).
+ *
+ * @param mode FM_CURRENT_MODE, AM_CURRENT_MODE, SSB_CURRENT_MODE or NBFM_CURRENT_MODE
+ * @param offset dB added to the RSSI (-128 to 127)
+ */
+void SI4735::setMeterCalibration(uint8_t mode, int8_t offset)
+{
+    if (mode > NBFM_CURRENT_MODE)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, 0);
+        return;
+    }
+    if (meterState != NULL)
+        meterState->calibration[mode] = offset;
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Returns the peak RSSI (dBuV): held for the hold time and then decaying (see setMeterPeak).
+ */
+uint8_t SI4735::getMeterPeak()
+{
+    uint32_t elapsed, decay;
+
+    if (meterState == NULL)
+        return 0;
+    elapsed = millis() - meterState->peakAt;
+    if (elapsed <= meterState->peakHold || meterState->peakDecay == 0)
+        return meterState->peak;
+    elapsed -= meterState->peakHold;
+    if (elapsed >= 255000UL) // Fully decayed at 1 dB/s or more (and no overflow below)
+        return 0;
+    decay = (elapsed * meterState->peakDecay + 500) / 1000;
+    return (decay >= meterState->peak) ? 0 : (uint8_t)(meterState->peak - decay);
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Converts an RSSI (dBuV) to dBm (50 ohms) with the calibration offset of the current mode (if the meter is started).
+ */
+int16_t SI4735::rssiToDbm(uint8_t rssi)
+{
+    if (meterState == NULL)
+        return (int16_t)rssi - 107;
+    return (int16_t)rssi - 107 + meterState->calibration[(lastMode <= NBFM_CURRENT_MODE) ? lastMode : FM_CURRENT_MODE];
+}
+
+/**
+ * @ingroup group42 S-meter
+ *
+ * @brief Converts a signal level (dBm) to S-units with the S9 level of the current mode.
+ *
+ * @details A level between two S-units returns the lower one (-76 dBm on AM is S8).
+ *
+ * @param dbm signal level (see rssiToDbm)
+ * @param over if not NULL, receives the dB above S9 (0 below S9)
+ *
+ * @return S-units (0 to 9)
+ */
+uint8_t SI4735::dbmToSUnit(int16_t dbm, uint8_t *over)
+{
+    int16_t below = ((lastMode == FM_CURRENT_MODE || lastMode == NBFM_CURRENT_MODE) ? SI473X_METER_S9_VHF : SI473X_METER_S9_HF) - dbm;
+
+    if (over != NULL)
+        *over = (below < 0) ? (uint8_t)-below : 0;
+    if (below <= 0)
+        return 9;
+    below = (below + SI473X_METER_S_UNIT - 1) / SI473X_METER_S_UNIT;
+    return (below >= 9) ? 0 : (uint8_t)(9 - below);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the bottom frequency and top frequency of the AM band for seek. Default is 520 to 1710.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 127, 161, and 162
+ *
+ * @param uint16_t bottom - the bottom of the AM (MW/SW) mode for seek
+ * @param uint16_t    top - the top of the AM (MW/SW) mode for seek
+ */
+void SI4735::setSeekAmLimits(uint16_t bottom, uint16_t top)
+{
+    sendProperty(AM_SEEK_BAND_BOTTOM, bottom);
+    sendProperty(AM_SEEK_BAND_TOP, top);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the bottom frequency and top frequency of the FM band for seek. Default is 8750 to 10790.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 100 and  101
+ *
+ * @param uint16_t bottom - the bottom of the FM(VHF) mode for seek
+ * @param uint16_t    top - the top of the FM(VHF) mode for seek
+ */
+void SI4735::setSeekFmLimits(uint16_t bottom, uint16_t top)
+{
+    sendProperty(FM_SEEK_BAND_BOTTOM, bottom);
+    sendProperty(FM_SEEK_BAND_TOP, top);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Selects frequency spacingfor AM seek. Default is 10 kHz spacing.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 163, 229 and 283
+ *
+ * @param uint16_t spacing - step in kHz
+ */
+void SI4735::setSeekAmSpacing(uint16_t spacing)
+{
+    sendProperty(AM_SEEK_FREQ_SPACING, spacing);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Selects frequency spacingfor FM seek. Default is 100 kHz (value 10) spacing. There are only 3 valid values: 5, 10, and 20.
+ * @details Although the guide does not mention it, the value 1 (10 kHz) seems to work better
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 101
+ *
+ * @param uint16_t spacing - step in kHz
+ */
+void SI4735::setSeekFmSpacing(uint16_t spacing)
+{
+    sendProperty(FM_SEEK_FREQ_SPACING, spacing);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the RSSI threshold for a valid AM Seek/Tune.
+ *
+ * @details If the value is zero then RSSI threshold is not considered when doing a seek. Default value is 25 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 127
+ */
+void SI4735::setSeekAmRssiThreshold(uint16_t value)
+{
+    sendProperty(AM_SEEK_RSSI_THRESHOLD, value);
+}
+
+/**
+ * @ingroup group08 Seek
+ *
+ * @brief Sets the RSSI threshold for a valid FM Seek/Tune.
+ *
+ * @details RSSI threshold which determines if a valid channel has been found during seek/tune. Specified in units of dBμV in 1 dBμV steps (0–127). Default is 20 dBμV.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 102
+ */
+void SI4735::setSeekFmRssiThreshold(uint16_t value)
+{
+    sendProperty(FM_SEEK_TUNE_RSSI_THRESHOLD, value);
+}
+
+/** @defgroup group10 Generic SI473X Command and Property methods
+ * @details A set of functions used to support other functions
+ */
+
+/**
+ * @ingroup group10 Generic send property
+ *
+ * @brief Sends (sets) property to the SI47XX
+ *
+ * @details This method is used for others to send generic properties and params to SI47XX
+ * @details If the property already has the given value (see Property cache), nothing is sent.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 68, 124 and  133.
+ * @see setProperty, sendCommand, getProperty, getCommandResponse, invalidatePropertyCache
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ * @param parameter   property value that will be seted
+ */
+void SI4735::sendProperty(uint16_t propertyNumber, uint16_t parameter)
+{
+    si47x_property property;
+    si47x_property param;
+    si47x_status status;
+    int8_t idx;
+    uint8_t arg[5];
+
+    // Inside a batch (see beginProperties), just stores the property. If it is already there, keeps the last value.
+    if (propertyBatchActive)
+    {
+        for (uint8_t i = 0; i < propertyBatchCount; i++)
+        {
+            if (propertyBatch[i].property == propertyNumber)
+            {
+                propertyBatch[i].value = parameter;
+                return;
+            }
+        }
+        if (propertyBatchCount >= propertyBatchSize)
+        {
+            commitProperties(); // The batch is full. Sends what is there and starts again.
+            propertyBatchActive = true;
+        }
+        propertyBatch[propertyBatchCount].property = propertyNumber;
+        propertyBatch[propertyBatchCount].value = parameter;
+        propertyBatchCount++;
+        return;
+    }
+
+    // Skips the I2C transaction if the property already has this value
+    if (propertyCacheSize != 0)
+    {
+        idx = findCachedProperty(propertyNumber);
+        if (idx >= 0 && propertyCache[idx].value == parameter)
+        {
+            propertyCacheHits++;
+            return;
+        }
+        propertyCacheMisses++;
+    }
+
+    property.value = propertyNumber;
+    param.value = parameter;
+
+    arg[0] = 0x00;
+    arg[1] = property.raw.byteHigh; // Send property - High byte - most significant first
+    arg[2] = property.raw.byteLow;  // Send property - Low byte - less significant after
+    arg[3] = param.raw.byteHigh;    // Send the argments. High Byte - Most significant first
+    arg[4] = param.raw.byteLow;     // Send the argments. Low Byte - Less significant after
+    status = runCommand(SET_PROPERTY, 5, arg);
+
+    if (!status.refined.ERR)
+    {
+        cacheProperty(propertyNumber, parameter);
+        saveModeProperty(propertyNumber, parameter);
+    }
+}
+
+/**
+ * @ingroup group10 Generic Command and Response
+ * @brief Sends a given command to the SI47XX devices.
+ * @details This function can be useful when you want to execute a SI47XX device command and it was not implemented by this library.
+ * @details In this case you have to check the  AN332-Si47XX PROGRAMMING GUIDE to know how the command works.
+ * @details Also, you need to work with bit operators to compose the parameters of the command [ &(and), ˆ(xor), |(or) etc ].
+ *
+ * @see getCommandResponse, setProperty
+ *
+ * @param cmd command number (see AN332-Si47XX PROGRAMMING GUIDE)
+ * @param parameter_size Parameter size in bytes. Tell the number of argument used by the command.
+ * @param parameter unsigned byte array with the arguments of the command
+ */
+void SI4735::sendCommand(uint8_t cmd, int parameter_size, const uint8_t *parameter)
+{
+    // Sends the command and the argments (parameters) of the command to the device
+    runCommand(cmd, parameter_size, parameter);
+}
+
+/**
+ * @ingroup group10 Generic Command and Response
+ * @brief   Returns with the command response.
+ * @details After a command is executed by the device, you can get the result (response) of the command by calling this method.
+ *
+ * @see sendCommand, setProperty
+ *
+ * @param response_size  num of bytes returned by the command.
+ * @param response  byte array where the response will be stored.
+ */
+void SI4735::getCommandResponse(int response_size, uint8_t *response)
+{
+    waitToSend();
+    // Asks the device to return a given number o bytes response
+    i2cRead(deviceAddress, response, response_size);
+}
+
+/**
+ * @ingroup group10 Generic Command and Response
+ * @brief Gets the first byte response.
+ * @details In this context status is the first response byte for any SI47XX command. See si47x_status structure.
+ * @details This function can be useful to check, for example, the success or failure of a command.
+ *
+ * @see si47x_status
+ *
+ * @return si47x_status
+ */
+si47x_status SI4735::getStatusResponse()
+{
+    si47x_status status;
+
+    i2cRead(deviceAddress, &status.raw, 1);
+
+    return status;
+}
+
+/**
+ * @ingroup group10 Generic get property
+ *
+ * @brief Gets a given property from the SI47XX
+ *
+ * @details This method is used to get a given property from SI47XX
+ * @details You might need to extract set of bits information from the returned value to know the real value
+ * @details If the value of the property is known (see Property cache), the I2C bus is not used.
+ *
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 69, 124 and  134.
+ * @see sendProperty, setProperty, sendCommand, getCommandResponse, invalidatePropertyCache
+ *
+ * @param propertyNumber property number (example: RX_VOLUME)
+ *
+ * @return property value  (the content of the property)
+ */
+int32_t
+SI4735::getProperty(uint16_t propertyNumber)
+{
+    si47x_property property;
+    si47x_status status;
+    int8_t idx;
+    uint8_t arg[3];
+    uint8_t resp[4];
+
+    // A property waiting in the batch (see beginProperties) has the most recent value
+    for (uint8_t i = 0; i < propertyBatchCount; i++)
+    {
+        if (propertyBatch[i].property == propertyNumber)
+            return propertyBatch[i].value;
+    }
+
+    if (propertyCacheSize != 0)
+    {
+        idx = findCachedProperty(propertyNumber);
+        if (idx >= 0)
+        {
+            propertyCacheHits++;
+            return propertyCache[idx].value;
+        }
+        propertyCacheMisses++;
+    }
+
+    property.value = propertyNumber;
+    arg[0] = 0x00;
+    arg[1] = property.raw.byteHigh; // Send property - High byte - most significant first
+    arg[2] = property.raw.byteLow;  // Send property - Low byte - less significant after
+
+    runCommand(GET_PROPERTY, 3, arg, 4, resp);
+    status.raw = resp[0];
+
+    // if error, return 0;
+    if (status.refined.ERR == 1)
+        return -1;
+
+    // gets the property value (resp[1] is dummy)
+    property.raw.byteHigh = resp[2];
+    property.raw.byteLow = resp[3];
+
+    cacheProperty(propertyNumber, property.value);
+    return property.value;
+}
+
+/**
+ * @defgroup group21 Asynchronous command engine
+ *
+ * @section group21 Asynchronous command engine
+ *
+ * @brief The asynchronous command engine lets your sketch queue commands to the SI47XX and keep doing
+ *        other things (refreshing a display, reading an encoder etc) while the device is busy.
+ * @details Instead of spinning on the Clear to Send (CTS) bit, the commands are stored in a small queue (your array:
+ *          see setCommandQueue) and advanced by calling commandTick from the loop function.
+ *          Each call to commandTick reads just the status byte once. If the device is ready, the next command
+ *          is sent or the response of the current command is read.
+ * @details All blocking functions of this library (setFrequency, setVolume, getStatus etc) are built on this engine.
+ *          So, calling a blocking function processes the commands queued before. Without a queue, they use a slot
+ *          of one command on the stack.
+ * @details Example:
+ * @code
+ *   si47x_async_command queue[4];
+ *   uint8_t cmdHandle;
+ *   uint8_t resp[8];
+ *
+ *   void setup() {
+ *      ...
+ *      rx.setCommandQueue(queue, 4);
+ *      cmdHandle = rx.sendCommandAsync(GET_REV, 0, NULL, 8, resp);
+ *   }
+ *
+ *   void loop() {
+ *      rx.commandTick();
+ *      if ( rx.isCommandDone(cmdHandle) ) {
+ *          ...
+ *      }
+ *      // Other things
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group21 Asynchronous command engine
+ *
+ * @brief Queues a command to be sent to the SI47XX device.
+ *
+ * @details The command is not sent immediately. It will be sent by commandTick as soon as the device is ready (CTS).
+ * @details The arrays parameter and response have to be valid until the command is done.
+ *
+ * @see commandTick, isCommandDone, waitCommand, flushCommands
+ *
+ * @param cmd command number (see AN332-Si47XX PROGRAMMING GUIDE)
+ * @param parameter_size number of arguments of the command (0 to 7)
+ * @param parameter unsigned byte array with the arguments of the command (it is copied to the queue)
+ * @param response_size number of bytes of the response (including the status byte). Use 0 if you do not need it.
+ * @param response byte array where the response will be stored.
+ * @param onDone function to be called when the command is done. Use NULL if you do not need it.
+ *
+ * @return uint8_t handle of the command or 0 if the queue is full (or not set) or the command is invalid.
+ */
+uint8_t SI4735::sendCommandAsync(uint8_t cmd, uint8_t parameter_size, const uint8_t *parameter, uint8_t response_size, uint8_t *response, si47x_command_callback onDone)
+{
+    si47x_async_command *c;
+    uint8_t i;
+
+    if (parameter_size > 7)
+    {
+        setError(SI473X_ERROR_INVALID_ARG, cmd);
+        return 0;
+    }
+    // Keeps the order of the property batch (see beginProperties) against the other commands
+    if (propertyBatchActive && propertyBatchCount != 0 && cmd != SET_PROPERTY && cmd != GET_PROPERTY)
+    {
+        if (cmd == POWER_UP || cmd == POWER_DOWN)
+            propertyBatchCount = 0; // The power cycle resets the properties. The pending ones are discarded.
+        else
+        {
+            commitProperties();
+            propertyBatchActive = true;
+        }
+    }
+    if (asyncCount >= asyncQueueSize)
+    {
+        lastError = SI473X_ERROR_QUEUE_FULL; // Not counted. The blocking functions just wait for a free slot.
+        return 0;
+    }
+    if (asyncCount == 0)
+    {
+        // Starts counting the wait for the CTS (see commandTick)
+        asyncTiming = &commandTiming[0];
+        asyncSentAt = micros();
+    }
+
+    // Keeps the property cache coherent with the device
+    if (cmd == POWER_UP || cmd == POWER_DOWN)
+    {
+        invalidatePropertyCache();
+        if (rsqState != NULL)
+            rsqState->tune = 0; // The power cycle clears the RSQ thresholds (see signalMonitorTick)
+    }
+    else if (cmd == SET_PROPERTY && parameter_size >= 3)
+        dropCachedProperty(((uint16_t)parameter[1] << 8) | parameter[2]);
+
+    // A tune, seek or BFO change makes the signal snapshot stale, even on the same frequency (see getSignalSnapshot)
+    if (cmd == FM_TUNE_FREQ || cmd == AM_TUNE_FREQ || cmd == NBFM_TUNE_FREQ || cmd == FM_SEEK_START || cmd == AM_SEEK_START ||
+        cmd == POWER_UP || cmd == POWER_DOWN ||
+        (cmd == SET_PROPERTY && parameter_size >= 3 && (((uint16_t)parameter[1] << 8) | parameter[2]) == SSB_BFO))
+        invalidateSignalSnapshot();
+
+    i = asyncHead + asyncCount;
+    c = &asyncQueue[(i < asyncQueueSize) ? i : i - asyncQueueSize];
+    c->cmd[0] = cmd;
+    for (i = 0; i < parameter_size; i++)
+        c->cmd[i + 1] = parameter[i];
+    c->cmdSize = parameter_size + 1;
+    c->responseSize = (response != NULL) ? response_size : 0;
+    c->response = response;
+    c->onDone = onDone;
+
+    if (++asyncLastHandle == 0) // 0 means invalid handle
+        asyncLastHandle = 1;
+    c->handle = asyncLastHandle;
+    c->state = SI473X_ASYNC_PENDING;
+    asyncCount++;
+
+    return c->handle;
+}
+
+/**
+ * @ingroup group21 Asynchronous command engine
+ *
+ * @brief Advances the asynchronous command queue.
+ *
+ * @details Call this function as often as possible (in the loop function).
+ * @details It never waits for the device. It checks the CTS bit once (following the command timing table) and,
+ *          if the device is ready, reads the response of the current command and sends the next one.
+ * @details If a command does not finish before its timeout, the engine gives it up with the ERR bit set (SI473X_ERROR_TIMEOUT).
+ *          A command that cannot be sent because the device is still busy is given up in the same way (default timeout).
+ *          A command that cannot be written to the bus is given up with SI473X_ERROR_BUS. So the queue always drains.
+ * @details For commands with response, the CTS check is done by reading the response itself (the first byte is the status).
+ *          Fast queries (expected time within the bus turnaround time) are written and read in just one
+ *          transaction by using repeated start (see setCombinedWriteRead).
+ * @details In interrupt mode (see setInterruptPin) with CTS interrupt enabled, the CTS bit is checked just after an INT pulse.
+ *
+ * @return true if there are commands to be processed yet.
+ */
+bool SI4735::commandTick()
+{
+    si47x_async_command *c;
+    si47x_status status, probe;
+    unsigned long now, elapsed;
+    uint8_t error;
+    uint8_t edges;
+
+    if (asyncCount == 0)
+        return false;
+
+    c = &asyncQueue[asyncHead];
+    now = micros();
+    elapsed = now - asyncSentAt;
+
+    if (c->state == SI473X_ASYNC_PENDING && deviceReady)
+        probe.raw = 0B10000000; // The last status byte read had the CTS and nothing was written since
+    else
+    {
+        if (c->state == SI473X_ASYNC_RUNNING && interruptEdgesSeen == interruptEdges)
+        {
+            // Follows the command timing table: first check after the expected time, then every poll interval
+            if (elapsed < asyncTiming->expected || (now - asyncLastProbe) < asyncPollInterval)
+                return true;
+            // In interrupt mode, the CTS bit is checked when the INT pin reports it (or after MAX_DELAY_CTS_FALLBACK µs)
+            if (interruptPin >= 0 && ctsIntEnable && (now - asyncLastProbe) < MAX_DELAY_CTS_FALLBACK)
+                return true;
+        }
+        else if (c->state == SI473X_ASYNC_PENDING && (now - asyncLastProbe) < asyncPollInterval)
+            return true;
+        asyncLastProbe = now;
+
+        if (c->state == SI473X_ASYNC_RUNNING && c->responseSize > 0)
+        {
+            // The CTS check is folded into the response read (the first response byte is the status).
+            // It handles the INT pulses counted before the read too (a later pulse waits for the next check).
+            edges = interruptEdges;
+            if (i2cRead(deviceAddress, c->response, c->responseSize) == c->responseSize)
+                probe.raw = c->response[0];
+            else
+            {
+                if (errorStats != NULL)
+                    errorStats->busErrors++;
+                probe.raw = 0; // No CTS
+            }
+            deviceReady = probe.refined.CTS;
+            if (interruptPin >= 0 && interruptEdgesSeen != edges)
+            {
+                interruptEdgesSeen = edges;
+                latchInterrupt(probe);
+            }
+        }
+        else if (checkInterrupt())
+            probe = interruptStatus; // The INT pulse was just handled with a status read
+        else
+            probe = readStatus();
+        SI473X_TRACE_HOOK(if (traceOpen && traceBuffer[traceNext].polls < 255) traceBuffer[traceNext].polls++;)
+    }
+
+    if (!probe.refined.CTS)
+    {
+        // A running command waits for its own CTS. A pending one waits for the CTS of the previous command.
+        if (elapsed < (uint32_t)asyncTiming->timeout * 1000)
+        {
+            if (asyncPollInterval < (asyncTiming->pollInterval << 2)) // Backoff
+                asyncPollInterval += asyncPollInterval >> 1;
+            return true;
+        }
+        // Gives up the current command
+        status.raw = 0B01000000; // ERR and no CTS
+        if (c->responseSize > 0)
+            c->response[0] = status.raw;
+        finishCommand(status, SI473X_ERROR_TIMEOUT);
+        return asyncCount > 0;
+    }
+
+    if (c->state == SI473X_ASYNC_RUNNING)
+    {
+        updateCommandTiming(asyncTiming, elapsed);
+        finishCommand(probe, (probe.refined.ERR) ? SI473X_ERROR_DEVICE : SI473X_OK);
+
+        if (asyncCount == 0)
+            return false;
+        c = &asyncQueue[asyncHead];
+    }
+
+    // The device is ready (CTS). Sends the next command.
+    while (c->state == SI473X_ASYNC_PENDING)
+    {
+        // For tune and seek commands, the table refers to the STC. The CTS uses the default timing.
+        asyncTiming = isSeekTuneCommand(c->cmd[0]) ? &commandTiming[0] : findCommandTiming(c->cmd[0]);
+        asyncPollInterval = asyncTiming->pollInterval;
+        c->state = SI473X_ASYNC_RUNNING;
+
+        asyncSentAt = micros();
+        SI473X_TRACE_HOOK(if (traceBuffer != NULL) traceBegin(c);)
+        if (!combinedWriteRead || c->responseSize == 0 || asyncTiming->expected > busTurnaround)
+        {
+            error = i2cWrite(deviceAddress, c->cmd, c->cmdSize);
+            asyncLastProbe = asyncSentAt = micros(); // The device starts the command at the end of the write
+            if (error == 0)
+                break;
+        }
+        else
+        {
+            // Fast query: writes the command and reads the response in one transaction (repeated start).
+            // If the first response byte already has the CTS, the command is done.
+            error = i2cWriteRead(deviceAddress, c->cmd, c->cmdSize, c->response, c->responseSize);
+            asyncLastProbe = micros();
+            SI473X_TRACE_HOOK(if (traceOpen) traceBuffer[traceNext].polls = 1;)
+            status.raw = c->response[0];
+            if (error == 0 && !status.refined.CTS)
+                break;
+        }
+
+        if (error != 0)
+        {
+            // The command did not reach the device
+            status.raw = 0B01000000; // ERR
+            if (c->responseSize > 0)
+                c->response[0] = status.raw;
+            finishCommand(status, SI473X_ERROR_BUS);
+        }
+        else
+        {
+            updateCommandTiming(asyncTiming, asyncLastProbe - asyncSentAt);
+            finishCommand(status, (status.refined.ERR) ? SI473X_ERROR_DEVICE : SI473X_OK);
+        }
+
+        if (asyncCount == 0)
+            return false;
+        c = &asyncQueue[asyncHead];
+    }
+
+    return true;
+}
+
+/**
+ * @ingroup group21 Asynchronous command engine
+ *
+ * @brief Releases the current (oldest) command of the queue.
+ *
+ * @details Stores the status and the result code, updates the error statistics and calls the callback of the command (if any).
+ *
+ * @param status status byte of the command
+ * @param result result code (SI473X_OK, SI473X_ERROR_TIMEOUT etc)
+ */
+void SI4735::finishCommand(si47x_status status, uint8_t result)
+{
+    si47x_async_command *c = &asyncQueue[asyncHead];
+    si47x_command_callback onDone = c->onDone;
+    uint8_t handle = c->handle;
+    uint32_t now = micros();
+
+    if (errorStats != NULL)
+    {
+        errorStats->commands++;
+        if ((now - asyncSentAt) > errorStats->maxLatency)
+            errorStats->maxLatency = now - asyncSentAt;
+    }
+    if (result == SI473X_OK)
+        lastError = SI473X_OK;
+    else
+        setError(result, c->cmd[0]);
+
+#ifdef SI473X_TRACE
+    if (traceBuffer != NULL)
+    {
+        if (!traceOpen) // Given up before being sent
+            traceBegin(c);
+        traceEnd(result);
+    }
+#endif
+
+    // The next command waits for the CTS from now on (see commandTick)
+    asyncTiming = &commandTiming[0];
+    asyncSentAt = now;
+
+    asyncLastStatus = status;
+    c->state = SI473X_ASYNC_FREE;
+    if (++asyncHead >= asyncQueueSize)
+        asyncHead = 0;
+    asyncCount--;
+
+    if (onDone != NULL)
+        onDone(handle, status);
+}
+
+/**
+ * @defgroup group26 Error handling
+ *
+ * @section group26 Error handling
+ *
+ * @brief Every wait and every retry loop of the library is bounded.
+ * @details A command is given up if the CTS does not come within the timeout of its entry in the command timing table.
+ *          The functions that repeat a query when the device answers with ERR (getStatus, getRdsStatus, getFirmware,
+ *          queryLibraryId and the AGC status functions) give up after the retry budget (see setRetryBudget).
+ * @details Call getLastError after a function to know its result. getErrorStats returns the error counters and the
+ *          worst latencies measured in your struct (see setErrorStats).
+ * @code
+ *   si47x_error_stats errors;
+ *   ...
+ *   rx.setErrorStats(&errors);
+ *   ...
+ *   rx.getStatus();
+ *   if (rx.getLastError() != SI473X_OK) {
+ *       si47x_error_stats stats = rx.getErrorStats();
+ *       Serial.println(stats.timeouts);
+ *   }
+ * @endcode
+ */
+
+/**
+ * @ingroup group26 Error handling
+ *
+ * @brief Records an error.
+ *
+ * @param result result code (SI473X_ERROR_TIMEOUT, SI473X_ERROR_DEVICE etc)
+ * @param cmd command that caused the error (0 if none)
+ */
+void SI4735::setError(uint8_t result, uint8_t cmd)
+{
+    lastError = result;
+    if (errorStats == NULL)
+        return;
+    errorStats->lastError = result;
+    errorStats->lastErrorCmd = cmd;
+
+    if (result == SI473X_ERROR_TIMEOUT)
+        errorStats->timeouts++;
+    else if (result == SI473X_ERROR_DEVICE)
+        errorStats->deviceErrors++;
+    else if (result == SI473X_ERROR_BUS)
+        errorStats->busErrors++;
 }
 
 /**
- * @ingroup group08 AGC
+ * @ingroup group26 Error handling
  *
- * @brief Queries Automatic Gain Control STATUS
+ * @brief Gives the library a struct to keep the error counters and the latency measurements.
  *
- * @details After call this method, you can call isAgcEnabled to know the AGC status and getAgcGainIndex to know the gain index value.
+ * @details Without it (the default), nothing is counted. The struct is cleared.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); For FM page 80; for AM page 142.
- * @see AN332 REV 0.8 Universal Programming Guide Amendment for SI4735-D60 SSB and NBFM patches; page 18.
+ * @code
+ *   si47x_error_stats stats;
+ *   ...
+ *   rx.setErrorStats(&stats);
+ * @endcode
  *
+ * @param stats error statistics declared by the sketch (it has to be valid while it is in use) or NULL
  */
-void SI4735::getAutomaticGainControl()
+void SI4735::setErrorStats(si47x_error_stats *stats)
 {
-    uint8_t cmd;
-
-    if (currentTune == FM_TUNE_FREQ)
-    { // FM TUNE
-        cmd = FM_AGC_STATUS;
-    }
-    else if (currentTune == NBFM_TUNE_FREQ)
-    {
-        cmd = NBFM_AGC_STATUS;
-    }
-    else
-    { // AM TUNE - SAME COMMAND used on SSB mode
-        cmd = AM_AGC_STATUS;
-    }
+    if (stats != NULL)
+        memset(stats, 0, sizeof(si47x_error_stats));
+    errorStats = stats;
+}
 
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(cmd);
-    Wire.endTransmission();
+/**
+ * @ingroup group26 Error handling
+ *
+ * @brief Returns the error counters and the latency measurements (see si47x_error_stats and setErrorStats).
+ *
+ * @return si47x_error_stats a copy of the counters (all zero without setErrorStats).
+ */
+si47x_error_stats SI4735::getErrorStats()
+{
+    si47x_error_stats stats;
 
-    do
-    {
-        waitToSend();
-        Wire.requestFrom(deviceAddress, 3);
-        currentAgcStatus.raw[0] = Wire.read(); // STATUS response
-        currentAgcStatus.raw[1] = Wire.read(); // RESP 1
-        currentAgcStatus.raw[2] = Wire.read(); // RESP 2
-    } while (currentAgcStatus.refined.ERR);    // If error, try get AGC status again.
+    if (errorStats != NULL)
+        return *errorStats;
+    memset(&stats, 0, sizeof(stats));
+    return stats;
 }
 
 /**
- * @ingroup group08 AGC
+ * @ingroup group26 Error handling
  *
- * @brief Automatic Gain Control setup
+ * @brief Checks if a query answered with ERR can be repeated.
  *
- * @details If FM, overrides AGC setting by disabling the AGC and forcing the LNA to have a certain gain that ranges between 0
- * (minimum attenuation) and 26 (maximum attenuation).
- * @details If AM/SSB, Overrides the AGC setting by disabling the AGC and forcing the gain index that ranges between 0
- * (minimum attenuation) and 37+ATTN_BACKUP (maximum attenuation).
+ * @details Only the errors reported by the device are retried. A timeout or a bus failure would just repeat the wait.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); For FM page 81; for AM page 143
+ * @param retry number of retries done so far (incremented here)
  *
- * @param uint8_t AGCDIS This param selects whether the AGC is enabled or disabled (0 = AGC enabled; 1 = AGC disabled);
- * @param uint8_t AGCIDX AGC Index (0 = Minimum attenuation (max gain); 1 – 36 = Intermediate attenuation);
- *                if >greater than 36 - Maximum attenuation (min gain) ).
+ * @return true if the retry budget allows one more try.
  */
-void SI4735::setAutomaticGainControl(uint8_t AGCDIS, uint8_t AGCIDX)
+bool SI4735::retryCommand(uint8_t &retry)
 {
-    si47x_agc_overrride agc;
-
-    uint8_t cmd;
-
-    // cmd = (currentTune == FM_TUNE_FREQ) ? FM_AGC_OVERRIDE : AM_AGC_OVERRIDE; // AM_AGC_OVERRIDE = SSB_AGC_OVERRIDE = 0x48
-
-    if (currentTune == FM_TUNE_FREQ)
-        cmd = FM_AGC_OVERRIDE;
-    else if (currentTune == NBFM_TUNE_FREQ)
-        cmd = NBFM_AGC_OVERRIDE;
-    else
-        cmd = AM_AGC_OVERRIDE;
-
-    agc.arg.DUMMY = 0; // ARG1: bits 7:1 Always write to 0;
-    agc.arg.AGCDIS = AGCDIS;
-    agc.arg.AGCIDX = AGCIDX;
-
-    waitToSend();
+    if (lastError != SI473X_ERROR_DEVICE || retry >= retryBudget)
+        return false;
+    retry++;
+    if (errorStats != NULL)
+        errorStats->retries++;
+    return true;
+}
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(cmd);
-    Wire.write(agc.raw[0]);
-    Wire.write(agc.raw[1]);
-    Wire.endTransmission();
+/**
+ * @defgroup group27 I2C tracer
+ *
+ * @section group27 I2C tracer
+ *
+ * @brief Records the I2C traffic in a ring buffer you give the library (see si47x_trace_entry and setTraceBuffer).
+ * @details The tracer is compiled out by default: no tracer member, no code in the I2C functions. Define SI473X_TRACE
+ *          for the library and the sketch (uncomment it in SI4735.h or use the compiler flags) to get getTraceEntry,
+ *          clearTrace and dumpTrace. Without SI473X_TRACE, setTraceBuffer is ignored and getTraceCount returns 0.
+ * @details Each command is recorded from the write to the response: command, property (SET_PROPERTY and GET_PROPERTY),
+ *          bytes written and read, number of CTS checks, elapsed time and result. Direct transactions (patch upload,
+ *          getCommandResponse, EEPROM etc) are recorded one by one.
+ * @code
+ *   si47x_trace_entry trace[32];
+ *   ...
+ *   rx.setTraceBuffer(trace, 32);
+ *   rx.setFM(8400, 10800, 10390, 10);  // Band switch to be profiled
+ *   rx.dumpTrace(Serial);
+ * @endcode
+ */
 
-    waitToSend();
+/**
+ * @ingroup group27 I2C tracer
+ *
+ * @brief Sets the array used as tracer ring buffer (the oldest entry is overwritten when it is full) or stops the tracer.
+ *
+ * @details Ignored if the library was built without SI473X_TRACE. The buffer is cleared.
+ *
+ * @param buffer array of entries (it has to be valid while it is in use) or NULL (tracer off)
+ * @param size number of entries of the array
+ */
+void SI4735::setTraceBuffer(si47x_trace_entry *buffer, uint8_t size)
+{
+#ifdef SI473X_TRACE
+    if (size == 0)
+        buffer = NULL;
+    traceBuffer = buffer;
+    traceSize = (buffer != NULL) ? size : 0;
+    traceOpen = false;
+    traceNext = traceCount = 0;
+#endif
 }
 
+#ifdef SI473X_TRACE
+
 /**
- * @ingroup group08 Automatic Volume Control
+ * @ingroup group27 I2C tracer
  *
- * @brief Sets the gain for automatic volume control.
+ * @brief Returns a tracer entry.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 152
- * @see setAvcAmMaxGain()
+ * @param index 0 = oldest entry; getTraceCount() - 1 = newest entry
  *
- * @param uint8_t gain  Select a value between 12 and 90.  Defaul value 48dB.
+ * @return si47x_trace_entry (all fields 0 if the index is invalid or the tracer is off)
  */
-void SI4735::setAvcAmMaxGain(uint8_t gain)
+si47x_trace_entry SI4735::getTraceEntry(uint8_t index)
 {
-    if (gain < 12 || gain > 90)
-        return;
-    currentAvcAmMaxGain = gain;
-    sendProperty(AM_AUTOMATIC_VOLUME_CONTROL_MAX_GAIN, gain * 340);
+    si47x_trace_entry entry;
+    uint16_t i;
+
+    if (index < traceCount)
+    {
+        i = (uint16_t)traceNext + traceSize - traceCount + index;
+        return traceBuffer[(i >= traceSize) ? i - traceSize : i];
+    }
+    memset(&entry, 0, sizeof(entry));
+    return entry;
 }
 
 /**
- * @ingroup group08 Received Signal Quality
+ * @ingroup group27 I2C tracer
  *
- * @brief Queries the status of the Received Signal Quality (RSQ) of the current channel.
+ * @brief Clears the tracer buffer.
+ */
+void SI4735::clearTrace()
+{
+    traceOpen = false;
+    traceNext = traceCount = 0;
+}
+
+/**
+ * @ingroup group27 I2C tracer
  *
- * @details This method sould be called berore call getCurrentRSSI(), getCurrentSNR() etc.
- * Command FM_RSQ_STATUS
+ * @brief Prints the tracer buffer (oldest entry first).
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 75 and 141
+ * @details One line per entry: start (us), command (hex), property (hex), bytes written, bytes read, CTS checks,
+ *          elapsed time (us) and result code.
  *
- * @param INTACK Interrupt Acknowledge.
- *        0 = Interrupt status preserved;
- *        1 = Clears RSQINT, BLENDINT, SNRHINT, SNRLINT, RSSIHINT, RSSILINT, MULTHINT, MULTLINT.
+ * @param out where to print (Serial, for example)
  */
-void SI4735::getCurrentReceivedSignalQuality(uint8_t INTACK)
+void SI4735::dumpTrace(Print &out)
 {
-    uint8_t arg;
-    uint8_t cmd;
-    int sizeResponse;
+    si47x_trace_entry e;
 
-    if (currentTune == FM_TUNE_FREQ)
-    { // FM TUNE
-        cmd = FM_RSQ_STATUS;
-        sizeResponse = 8;
-    }
-    else if (currentTune == NBFM_TUNE_FREQ)
+    if (traceBuffer == NULL)
+        return;
+
+    out.println(F("start cmd prop wr rd polls us result"));
+    for (uint8_t i = 0; i < traceCount; i++)
     {
-        cmd = NBFM_RSQ_STATUS;
-        sizeResponse = 8; // Check it
-    }
-    else
-    { // AM TUNE
-        cmd = AM_RSQ_STATUS;
-        sizeResponse = 6; // Check it
+        e = getTraceEntry(i);
+        out.print(e.start);
+        out.print(' ');
+        out.print(e.cmd, HEX);
+        out.print(' ');
+        out.print(e.property, HEX);
+        out.print(' ');
+        out.print(e.written);
+        out.print(' ');
+        out.print(e.read);
+        out.print(' ');
+        out.print(e.polls);
+        out.print(' ');
+        out.print(e.elapsed);
+        out.print(' ');
+        out.println(e.result);
     }
+}
 
-    waitToSend();
+/**
+ * @ingroup group27 I2C tracer
+ *
+ * @brief Returns the next entry of the ring buffer (the oldest one is overwritten when it is full).
+ */
+si47x_trace_entry *SI4735::traceAppend()
+{
+    si47x_trace_entry *e = &traceBuffer[traceNext];
 
-    arg = INTACK;
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(cmd);
-    Wire.write(arg); // send B00000001
-    Wire.endTransmission();
-
-    // Check it
-    // do
-    //{
-    waitToSend();
-    Wire.requestFrom(deviceAddress, sizeResponse);
-    // Gets response information
-    for (uint8_t i = 0; i < sizeResponse; i++)
-        currentRqsStatus.raw[i] = Wire.read();
-    //} while (currentRqsStatus.resp.ERR); // Try again if error found
+    if (++traceNext >= traceSize)
+        traceNext = 0;
+    if (traceCount < traceSize)
+        traceCount++;
+    return e;
 }
 
 /**
- * @ingroup group08 Received Signal Quality
+ * @ingroup group27 I2C tracer
  *
- * @brief Queries the status of the Received Signal Quality (RSQ) of the current channel (FM_RSQ_STATUS)
+ * @brief Starts tracing a command of the asynchronous engine.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 75 and 141
+ * @details The command is built in the next entry of the ring buffer and stored by traceEnd.
  *
- * @param INTACK Interrupt Acknowledge.
- *        0 = Interrupt status preserved;
- *        1 = Clears RSQINT, BLENDINT, SNRHINT, SNRLINT, RSSIHINT, RSSILINT, MULTHINT, MULTLINT.
+ * @param c command
  */
-void SI4735::getCurrentReceivedSignalQuality(void)
+void SI4735::traceBegin(si47x_async_command *c)
 {
-    getCurrentReceivedSignalQuality(0);
+    si47x_trace_entry *e = &traceBuffer[traceNext];
+
+    traceOpen = true;
+    e->start = micros();
+    e->elapsed = 0;
+    e->cmd = c->cmd[0];
+    e->property = (c->cmdSize >= 4 && (c->cmd[0] == SET_PROPERTY || c->cmd[0] == GET_PROPERTY)) ? ((uint16_t)c->cmd[2] << 8) | c->cmd[3] : 0;
+    e->written = e->read = e->polls = 0;
+    e->result = SI473X_OK;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group27 I2C tracer
  *
- * @brief Look for a station (Automatic tune)
- * @details Starts a seek process for a channel that meets the RSSI and SNR criteria for AM.
- * @details __This function does not work on SSB mode__.
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 72, 125 and 137
+ * @brief Stores the command being traced.
  *
- * @param SEEKUP Seek Up/Down. Determines the direction of the search, either UP = 1, or DOWN = 0.
- * @param Wrap/Halt. Determines whether the seek should Wrap = 1, or Halt = 0 when it hits the band limit.
+ * @param result result code of the command
  */
-void SI4735::seekStation(uint8_t SEEKUP, uint8_t WRAP)
+void SI4735::traceEnd(uint8_t result)
 {
-    si47x_seek seek;
-    si47x_seek_am_complement seek_am_complement;
-
-    // Check which FUNCTION (AM or FM) is working now
-    uint8_t seek_start_cmd = (currentTune == FM_TUNE_FREQ) ? FM_SEEK_START : AM_SEEK_START;
+    si47x_trace_entry *e;
 
-    waitToSend();
+    if (!traceOpen)
+        return;
+    e = traceAppend();
+    e->elapsed = micros() - e->start;
+    e->result = result;
+    traceOpen = false;
+}
 
-    seek.arg.SEEKUP = SEEKUP;
-    seek.arg.WRAP = WRAP;
-    seek.arg.RESERVED1 = 0;
-    seek.arg.RESERVED2 = 0;
+/**
+ * @ingroup group27 I2C tracer
+ *
+ * @brief Records an I2C transaction (called by i2cWrite, i2cRead and i2cWriteRead).
+ *
+ * @details Inside a traced command, the bytes are added to the command. Otherwise, the transaction gets its own entry.
+ *          Consecutive status reads are merged into one entry (polls).
+ *
+ * @param data bytes written (NULL if none)
+ * @param written number of bytes written
+ * @param read number of bytes read
+ * @param start time (us) the transaction started
+ * @param error 0 if the transaction succeeded
+ */
+void SI4735::traceTransfer(const uint8_t *data, uint8_t written, uint8_t read, uint32_t start, uint8_t error)
+{
+    si47x_trace_entry *e;
+    uint32_t now = micros();
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(seek_start_cmd);
-    Wire.write(seek.raw); // ARG1
+    if (traceOpen)
+    {
+        traceBuffer[traceNext].written += written;
+        traceBuffer[traceNext].read += read;
+        return;
+    }
 
-    if (seek_start_cmd == AM_SEEK_START) // Sets additional configuration for AM mode
+    if (written == 0 && read == 1 && traceCount > 0)
     {
-        seek_am_complement.ARG2 = seek_am_complement.ARG3 = 0;
-        seek_am_complement.ANTCAPH = 0;
-        seek_am_complement.ANTCAPL = (currentWorkFrequency > 1800) ? 1 : 0; // if SW = 1
-        Wire.write(seek_am_complement.ARG2);                                // ARG2 - Always 0
-        Wire.write(seek_am_complement.ARG3);                                // ARG3 - Always 0
-        Wire.write(seek_am_complement.ANTCAPH);                             // ARG4 - Tuning Capacitor: The tuning capacitor value
-        Wire.write(seek_am_complement.ANTCAPL);                             // ARG5 - will be selected automatically.
+        e = &traceBuffer[(traceNext == 0) ? traceSize - 1 : traceNext - 1];
+        if (e->cmd == 0 && e->written == 0 && e->read == e->polls && e->polls < 255)
+        {
+            // Status polling (waiting for the CTS or the STC)
+            e->polls++;
+            e->read++;
+            e->elapsed = now - e->start;
+            if (error != 0)
+                e->result = SI473X_ERROR_BUS;
+            return;
+        }
     }
 
-    Wire.endTransmission();
-    delay(MAX_DELAY_AFTER_SET_FREQUENCY << 2);
+    e = traceAppend();
+    e->start = start;
+    e->elapsed = now - start;
+    e->cmd = (written > 0) ? data[0] : 0;
+    e->property = (written >= 4 && (e->cmd == SET_PROPERTY || e->cmd == GET_PROPERTY)) ? ((uint16_t)data[2] << 8) | data[3] : 0;
+    e->written = written;
+    e->read = read;
+    e->polls = (written == 0 && read == 1) ? 1 : 0;
+    e->result = (error != 0) ? SI473X_ERROR_BUS : SI473X_OK;
 }
+#endif
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group21 Asynchronous command engine
  *
- * @brief Search for the next station.
- * @details Like seekStationUp this function goes to a next station.
- * @details The main difference is the method used to look for a station.
+ * @brief Checks if a given command is done.
  *
- * @see seekStation, seekStationUp, seekStationDown, seekPreviousStation, seekStationProgress
+ * @param handle value returned by sendCommandAsync
+ *
+ * @return true if the command is not in the queue anymore.
  */
-void SI4735::seekNextStation()
+bool SI4735::isCommandDone(uint8_t handle)
 {
-    seekStation(1, 1);
-    delay(maxDelaySetFrequency);
-    getFrequency();
+    uint8_t idx = asyncHead;
+
+    for (uint8_t i = 0; i < asyncCount; i++)
+    {
+        if (asyncQueue[idx].handle == handle)
+            return false;
+        if (++idx >= asyncQueueSize)
+            idx = 0;
+    }
+    return true;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group21 Asynchronous command engine
  *
- * @brief Search the previous station
- * @details Like seekStationDown this function goes to a previous station.
- * @details The main difference is the method used to look for a station.
- * @see seekStation, seekStationUp, seekStationDown, seekPreviousStation, seekStationProgress
+ * @brief Waits (processing the queue) until a given command is done.
+ *
+ * @param handle value returned by sendCommandAsync
  */
-void SI4735::seekPreviousStation()
+void SI4735::waitCommand(uint8_t handle)
 {
-    seekStation(0, 1);
-    delay(maxDelaySetFrequency);
-    getFrequency();
+    while (!isCommandDone(handle))
+        commandTick();
 }
 
 /**
- * @ingroup group08 Seek
- * @brief Seeks a station up or down.
- * @details Seek up or down a station and call a function defined by the developer to show the frequency.
- * @details The first parameter of this function is a name of your function that you have to implement to show the current frequency.
- * @details If you do not want to show the seeking progress,  you can set NULL instead the name of the function.
- * @details The code below shows an example using ta function the shows the current frequency on he Serial Monitor. You might want to implement a function that shows the frequency on your display device.
- * @details Also, you have to declare the frequency parameter that will be used by the function to show the frequency value.
- * @details __This function does not work on SSB mode__.
- * @code
- * void showFrequency( uint16_t freq ) {
- *    Serial.print(freq);
- *    Serial.println("MHz ");
- * }
+ * @ingroup group21 Asynchronous command engine
  *
- * void loop() {
+ * @brief Waits (processing the queue) until all queued commands are done.
+ */
+void SI4735::flushCommands()
+{
+    while (asyncCount > 0)
+        commandTick();
+}
+
+/**
+ * @ingroup group21 Asynchronous command engine
  *
- *  receiver.seekStationProgress(showFrequency,1); // Seek Up
- *  .
- *  .
- *  .
- *  receiver.seekStationProgress(showFrequency,0); // Seek Down
+ * @brief Gives the asynchronous engine a command queue.
  *
- * }
+ * @details There is no queue by default: sendCommandAsync returns 0, and each blocking function uses a slot of one
+ *          command on the stack. The non-blocking functions (startSweep, startSoftSeek, startPriorityWatch,
+ *          requestFrequency etc) need the queue: with it, they and your own code can queue the next command while the
+ *          device is busy. Four commands are enough for the library.
+ * @details The queued commands are processed before the change. Stop the non-blocking functions before removing the queue.
+ *
+ * @code
+ *   si47x_async_command queue[4];
+ *   ...
+ *   rx.setCommandQueue(queue, 4);
  * @endcode
  *
- * @see seekStation, seekStationUp, seekStationDown, getStatus, setMaxSeekTime
- * @param showFunc  function that you have to implement to show the frequency during the seeking process. Set NULL if you do not want to show the progress.
- * @param up_down   set up_down = 1 for seeking station up; set up_down = 0 for seeking station down
+ * @param queue array of commands (it has to be valid while it is in use). NULL = no queue.
+ * @param size number of commands of the array
  */
-void SI4735::seekStationProgress(void (*showFunc)(uint16_t f), uint8_t up_down)
+void SI4735::setCommandQueue(si47x_async_command *queue, uint8_t size)
 {
-    si47x_frequency freq;
-    long elapsed_seek = millis();
-
-    // seek command does not work for SSB
-    if (lastMode == SSB_CURRENT_MODE)
-        return;
-    do
+    flushCommands();
+    if (queue == NULL || size == 0)
     {
-        seekStation(up_down, 0);
-        delay(maxDelaySetFrequency);
-        getStatus(0, 0);
-        delay(maxDelaySetFrequency);
-        freq.raw.FREQH = currentStatus.resp.READFREQH;
-        freq.raw.FREQL = currentStatus.resp.READFREQL;
-        currentWorkFrequency = freq.value;
-        if (showFunc != NULL)
-            showFunc(freq.value);
-    } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (millis() - elapsed_seek) < maxSeekTime);
+        queue = NULL;
+        size = 0;
+    }
+    asyncQueue = queue;
+    asyncQueueSize = size;
+    asyncHead = 0;
 }
 
 /**
- * @ingroup group08 Seek
- * @brief Seeks a station up or down.
- * @details Seek up or down a station and call a function defined by the developer to show the frequency and stop seeking process by the user.
- * @details The first parameter of this function is a name of your function that you have to implement to show the current frequency.
- * @details The second parameter is the name function that will check stop seeking action. Thus function should return true or false and should read a button, encoder or some status to make decision to stop or keep seeking.
- * @details If you do not want to show the seeking progress,  you can set NULL instead the name of the function.
- * @details If you do not want stop seeking checking, you can set NULL instead the name of a function.
- * @details The code below shows an example using ta function the shows the current frequency on he Serial Monitor. You might want to implement a function that shows the frequency on your display device.
- * @details Also, you have to declare the frequency parameter that will be used by the function to show the frequency value.
- * @details __This function does not work on SSB mode__.
- * @code
- * void showFrequency( uint16_t freq ) {
- *    Serial.print(freq);
- *    Serial.println("MHz ");
- * }
+ * @ingroup group21 Asynchronous command engine
+ *
+ * @brief Lends a command slot (on the stack of a blocking function) to the engine when the sketch did not set a queue.
+ *
+ * @param slot command slot of the caller
+ *
+ * @return true if the slot is in use. Call returnCommandSlot before leaving the caller.
+ */
+bool SI4735::lendCommandSlot(si47x_async_command *slot)
+{
+    if (asyncQueueSize != 0)
+        return false;
+    asyncQueue = slot;
+    asyncQueueSize = 1;
+    asyncHead = 0;
+    return true;
+}
+
+/**
+ * @ingroup group21 Asynchronous command engine
+ *
+ * @brief Finishes the queued command and takes back the slot given by lendCommandSlot.
+ */
+void SI4735::returnCommandSlot()
+{
+    flushCommands();
+    asyncQueue = NULL;
+    asyncQueueSize = 0;
+}
+
+/**
+ * @ingroup group21 Asynchronous command engine
  *
- * void loop() {
+ * @brief Sends a command and waits for it to be done.
  *
- *  receiver.seekStationProgress(showFrequency, checkStopSeeking, 1); // Seek Up
- *  .
- *  .
- *  .
- *  receiver.seekStationProgress(showFrequency, checkStopSeeking, 0); // Seek Down
+ * @details Blocking version of sendCommandAsync used by the library internally.
  *
- * }
- * @endcode
+ * @param cmd command number
+ * @param parameter_size number of arguments of the command (0 to 7)
+ * @param parameter unsigned byte array with the arguments of the command
+ * @param response_size number of bytes of the response
+ * @param response byte array where the response will be stored.
  *
- * @see seekStation, seekStationUp, seekStationDown, getStatus, setMaxSeekTime
- * @param showFunc  function that you have to implement to show the frequency during the seeking process. Set NULL if you do not want to show the progress.
- * @param stopSeeking functionthat you have to implement if you want to control the stop seeking action. Useful if you want abort the seek process.
- * @param up_down   set up_down = 1 for seeking station up; set up_down = 0 for seeking station down
+ * @return si47x_status the status byte of the command (see also getLastError)
  */
-void SI4735::seekStationProgress(void (*showFunc)(uint16_t f), bool (*stopSeking)(), uint8_t up_down)
+si47x_status SI4735::runCommand(uint8_t cmd, uint8_t parameter_size, const uint8_t *parameter, uint8_t response_size, uint8_t *response)
 {
-    si47x_frequency freq;
-    long elapsed_seek = millis();
+    si47x_async_command slot;
+    uint8_t handle;
+    uint32_t start = micros(), elapsed;
+    bool lent;
 
-    // seek command does not work for SSB
-    if (lastMode == SSB_CURRENT_MODE)
-        return;
-    do
+    if (parameter_size > 7) // Invalid command. The SI47XX commands have at most 7 arguments.
     {
-        seekStation(up_down, 0);
-        delay(maxDelaySetFrequency);
-        getStatus(0, 0);
-        delay(maxDelaySetFrequency);
-        freq.raw.FREQH = currentStatus.resp.READFREQH;
-        freq.raw.FREQL = currentStatus.resp.READFREQL;
-        currentWorkFrequency = freq.value;
-        if (showFunc != NULL)
-            showFunc(freq.value);
-        if (stopSeking != NULL)
-            if (stopSeking())
-                return;
+        setError(SI473X_ERROR_INVALID_ARG, cmd);
+        return asyncLastStatus;
+    }
+
+    lent = lendCommandSlot(&slot);
+    // Bounded: every queued command finishes or is given up within its timeout
+    while ((handle = sendCommandAsync(cmd, parameter_size, parameter, response_size, response)) == 0)
+        commandTick();
+    waitCommand(handle);
+    if (lent)
+        returnCommandSlot();
 
-    } while (!currentStatus.resp.VALID && !currentStatus.resp.BLTF && (millis() - elapsed_seek) < maxSeekTime);
+    elapsed = micros() - start;
+    if (errorStats != NULL && elapsed > errorStats->maxWait)
+        errorStats->maxWait = elapsed;
+
+    return asyncLastStatus;
 }
 
 /**
- * @ingroup group08 Seek
+ * @defgroup group22 Property cache
  *
- * @brief Sets the bottom frequency and top frequency of the AM band for seek. Default is 520 to 1710.
+ * @section group22 Property cache
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 127, 161, and 162
+ * @brief The library keeps a shadow of the properties it writes in an array you give it (see setPropertyCache).
+ * @details sendProperty skips the I2C transaction (and the delay after it) when the property already has the value.
+ * @details getProperty answers from the cache when the value is known.
+ * @details The cache is cleared every time the device is reset, powered down or powered up (the properties go back to
+ *          their default values). If you change properties by using sendCommand, call invalidatePropertyCache.
+ * @details Use getPropertyCacheHits and getPropertyCacheMisses to know how many I2C transactions were saved.
+ * @code
+ *   si47x_property_cache_entry propertyCache[16];
+ *   ...
+ *   rx.setPropertyCache(propertyCache, 16);
+ * @endcode
+ */
+
+/**
+ * @ingroup group22 Property cache
  *
- * @param uint16_t bottom - the bottom of the AM (MW/SW) mode for seek
- * @param uint16_t    top - the top of the AM (MW/SW) mode for seek
+ * @brief Clears the property cache.
+ *
+ * @details It is called automatically after reset, POWER_DOWN and POWER_UP.
  */
-void SI4735::setSeekAmLimits(uint16_t bottom, uint16_t top)
+void SI4735::invalidatePropertyCache()
 {
-    sendProperty(AM_SEEK_BAND_BOTTOM, bottom);
-    sendProperty(AM_SEEK_BAND_TOP, top);
+    propertyCacheCount = 0;
+    propertyCacheNext = 0;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group22 Property cache
  *
- * @brief Sets the bottom frequency and top frequency of the FM band for seek. Default is 8750 to 10790.
+ * @brief Looks for a property in the cache.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 100 and  101
+ * @param propertyNumber property number (example: RX_VOLUME)
  *
- * @param uint16_t bottom - the bottom of the FM(VHF) mode for seek
- * @param uint16_t    top - the top of the FM(VHF) mode for seek
+ * @return int8_t position of the property in the cache or -1 if it is not there.
  */
-void SI4735::setSeekFmLimits(uint16_t bottom, uint16_t top)
+int8_t SI4735::findCachedProperty(uint16_t propertyNumber)
 {
-    sendProperty(FM_SEEK_BAND_BOTTOM, bottom);
-    sendProperty(FM_SEEK_BAND_TOP, top);
+    for (uint8_t i = 0; i < propertyCacheCount; i++)
+    {
+        if (propertyCache[i].property == propertyNumber)
+            return i;
+    }
+    return -1;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group22 Property cache
  *
- * @brief Selects frequency spacingfor AM seek. Default is 10 kHz spacing.
+ * @brief Stores the current value of a property in the cache.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 163, 229 and 283
+ * @details If the cache is full, the entries are replaced in a round-robin way.
  *
- * @param uint16_t spacing - step in kHz
+ * @param propertyNumber property number (example: RX_VOLUME)
+ * @param value current value of the property
  */
-void SI4735::setSeekAmSpacing(uint16_t spacing)
+void SI4735::cacheProperty(uint16_t propertyNumber, uint16_t value)
 {
-    sendProperty(AM_SEEK_FREQ_SPACING, spacing);
+    int8_t idx;
+
+    if (propertyCacheSize == 0)
+        return;
+
+    idx = findCachedProperty(propertyNumber);
+    if (idx < 0)
+    {
+        if (propertyCacheCount < propertyCacheSize)
+            idx = propertyCacheCount++;
+        else
+        {
+            idx = propertyCacheNext;
+            if (++propertyCacheNext >= propertyCacheSize)
+                propertyCacheNext = 0;
+        }
+        propertyCache[idx].property = propertyNumber;
+    }
+    propertyCache[idx].value = value;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group22 Property cache
  *
- * @brief Selects frequency spacingfor FM seek. Default is 100 kHz (value 10) spacing. There are only 3 valid values: 5, 10, and 20.
- * @details Although the guide does not mention it, the value 1 (10 kHz) seems to work better
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 101
+ * @brief Removes a property from the cache.
  *
- * @param uint16_t spacing - step in kHz
+ * @param propertyNumber property number (example: RX_VOLUME)
  */
-void SI4735::setSeekFmSpacing(uint16_t spacing)
+void SI4735::dropCachedProperty(uint16_t propertyNumber)
 {
-    sendProperty(FM_SEEK_FREQ_SPACING, spacing);
+    int8_t idx = findCachedProperty(propertyNumber);
+
+    if (idx < 0)
+        return;
+
+    // Moves the last valid entry to the released position
+    propertyCache[idx] = propertyCache[--propertyCacheCount];
+    if (propertyCacheNext >= propertyCacheCount)
+        propertyCacheNext = 0;
 }
 
 /**
- * @ingroup group08 Seek
+ * @defgroup group23 Property batch
+ *
+ * @section group23 Property batch
+ *
+ * @brief Groups several property writes in just one transaction.
+ * @details Between beginProperties and commitProperties, sendProperty (and all functions based on it, like setBandwidth,
+ *          setAvcAmMaxGain, setSeekAmLimits etc) just store the property in the array you give the library (see setPropertyBatch).
+ *          If the same property is written more than once, only the last value is kept.
+ * @details Commands that are not properties (setFrequency, getStatus etc) are not batched. The pending properties are sent
+ *          just before them, so the device gets everything in the order it was written, and the batch goes on.
+ *          POWER_DOWN and POWER_UP (and reset) discard the pending properties: the power cycle resets them anyway.
+ * @details commitProperties sends the properties in ascending order through the asynchronous command engine.
+ *          Each SET_PROPERTY is sent as soon as the device reports CTS (no fixed delay between them). Properties that
+ *          already have the value (see Property cache) are skipped.
+ * @details Example:
+ * @code
+ *   si47x_property_batch_entry batch[20];
+ *   ...
+ *   rx.setPropertyBatch(batch, 20);
+ *   ...
+ *   rx.beginProperties();
+ *   rx.setBandwidth(2, 1);
+ *   rx.setAvcAmMaxGain(48);
+ *   rx.setAmSoftMuteMaxAttenuation(8);
+ *   rx.setSeekAmLimits(520, 1750);
+ *   rx.setSeekAmSpacing(10);
+ *   uint32_t us = rx.commitProperties();  // Time spent in microseconds
+ * @endcode
+ */
+
+/**
+ * @ingroup group23 Property batch
  *
- * @brief Sets the RSSI threshold for a valid AM Seek/Tune.
+ * @brief Starts a property batch.
  *
- * @details If the value is zero then RSSI threshold is not considered when doing a seek. Default value is 25 dBμV.
+ * @details The next property writes are stored until commitProperties is called. Without a batch array (see
+ *          setPropertyBatch), nothing is done and the properties are sent at once.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 127
+ * @see commitProperties
  */
-void SI4735::setSeekAmRssiThreshold(uint16_t value)
+void SI4735::beginProperties()
 {
-    sendProperty(AM_SEEK_RSSI_THRESHOLD, value);
+    if (propertyBatchActive || propertyBatchSize == 0)
+        return;
+    propertyBatchCount = 0;
+    propertyBatchActive = true;
 }
 
 /**
- * @ingroup group08 Seek
+ * @ingroup group23 Property batch
  *
- * @brief Sets the RSSI threshold for a valid FM Seek/Tune.
+ * @brief Sends all properties stored since beginProperties.
  *
- * @details RSSI threshold which determines if a valid channel has been found during seek/tune. Specified in units of dBμV in 1 dBμV steps (0–127). Default is 20 dBμV.
+ * @details The properties are sorted by number and sent back-to-back, paced just by the CTS bit.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 102
+ * @see beginProperties, getPropertyCommitTime
+ *
+ * @return uint32_t time spent (in microseconds).
  */
-void SI4735::setSeekFmRssiThreshold(uint16_t value)
+uint32_t SI4735::commitProperties()
 {
-    sendProperty(FM_SEEK_TUNE_RSSI_THRESHOLD, value);
+    si47x_property_batch_entry aux, *p;
+    si47x_async_command slot;
+    uint32_t start = micros();
+    uint8_t arg[5];
+    int8_t idx;
+    int8_t j;
+    bool lent;
+
+    propertyBatchActive = false;
+    lent = lendCommandSlot(&slot);
+
+    // Sorts the batch by property number (insertion sort - the batch is small)
+    for (uint8_t i = 1; i < propertyBatchCount; i++)
+    {
+        aux = propertyBatch[i];
+        for (j = i - 1; j >= 0 && propertyBatch[j].property > aux.property; j--)
+            propertyBatch[j + 1] = propertyBatch[j];
+        propertyBatch[j + 1] = aux;
+    }
+
+    for (uint8_t i = 0; i < propertyBatchCount; i++)
+    {
+        p = &propertyBatch[i];
+        p->status = 0B10000000; // CTS (nothing sent yet)
+        if (propertyCacheSize != 0)
+        {
+            idx = findCachedProperty(p->property);
+            if (idx >= 0 && propertyCache[idx].value == p->value)
+            {
+                propertyCacheHits++;
+                continue;
+            }
+            propertyCacheMisses++;
+        }
+        arg[0] = 0x00;
+        arg[1] = p->property >> 8;   // Property - High byte first
+        arg[2] = p->property & 0xFF; // Property - Low byte
+        arg[3] = p->value >> 8;      // Value - High byte first
+        arg[4] = p->value & 0xFF;    // Value - Low byte
+        while (sendCommandAsync(SET_PROPERTY, 5, arg, 1, &p->status) == 0)
+            commandTick();
+    }
+    flushCommands();
+    if (lent)
+        returnCommandSlot();
+
+    for (uint8_t i = 0; i < propertyBatchCount; i++)
+    {
+        if (!(propertyBatch[i].status & 0B01000000)) // ERR
+        {
+            cacheProperty(propertyBatch[i].property, propertyBatch[i].value);
+            saveModeProperty(propertyBatch[i].property, propertyBatch[i].value);
+        }
+    }
+    propertyBatchCount = 0;
+
+    propertyCommitTime = micros() - start;
+    return propertyCommitTime;
 }
 
-/** @defgroup group10 Generic SI473X Command and Property methods
- * @details A set of functions used to support other functions
+/**
+ * @defgroup group24 Command timing
+ *
+ * @section group24 Command timing
+ *
+ * @brief Per-command completion model used instead of fixed delays.
+ * @details Each entry of the command timing table (see si47x_command_timing) tells when the command is expected to be done,
+ *          how often the device is checked after that and when the library gives up. Commands not found in the table use the
+ *          default entry (cmd = 0x00).
+ * @details The defaults can be overridden at compile time (SI473X_TIMING_* macros, library-wide build flags: see
+ *          SI4735.cpp), by a derived class or at runtime (setCommandTiming). The last measured completion time of each entry can be read with getCommandTiming and
+ *          setCommandTimingAutoTune makes the expected times follow the measurements.
+ * @details The table is shared by all the receivers of the sketch. A receiver that needs its own timing (two different
+ *          devices, for example) gets a table of SI473X_COMMAND_TIMING_SIZE entries with setCommandTimingTable.
+ * @details Example:
+ * @code
+ *   si47x_command_timing timing[SI473X_COMMAND_TIMING_SIZE];
+ *   ...
+ *   rx.setCommandTimingTable(timing);                 // Optional: this receiver only
+ *   rx.setCommandTiming(SET_PROPERTY, 80, 50, 20);   // A fast board and SI4732-A10
+ *   rx.setCommandTimingAutoTune(true);
+ *   ...
+ *   si47x_command_timing t = rx.getCommandTiming(FM_TUNE_FREQ);
+ *   Serial.println(t.measured);
+ * @endcode
  */
 
 /**
- * @ingroup group10 Generic send property
- *
- * @brief Sends (sets) property to the SI47XX
+ * @ingroup group24 Command timing
  *
- * @details This method is used for others to send generic properties and params to SI47XX
+ * @brief Gives the receiver its own command timing table or goes back to the library-wide one.
  *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 68, 124 and  133.
- * @see setProperty, sendCommand, getProperty, getCommandResponse
+ * @details The table is filled with the current library-wide timing. Call it when no command is running.
  *
- * @param propertyNumber property number (example: RX_VOLUME)
- * @param parameter   property value that will be seted
+ * @param table array of SI473X_COMMAND_TIMING_SIZE entries (it has to be valid while it is in use) or NULL
  */
-void SI4735::sendProperty(uint16_t propertyNumber, uint16_t parameter)
+void SI4735::setCommandTimingTable(si47x_command_timing *table)
 {
-    si47x_property property;
-    si47x_property param;
-
-    property.value = propertyNumber;
-    param.value = parameter;
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SET_PROPERTY);
-    Wire.write(0x00);
-    Wire.write(property.raw.byteHigh); // Send property - High byte - most significant first
-    Wire.write(property.raw.byteLow);  // Send property - Low byte - less significant after
-    Wire.write(param.raw.byteHigh);    // Send the argments. High Byte - Most significant first
-    Wire.write(param.raw.byteLow);     // Send the argments. Low Byte - Less significant after
-    Wire.endTransmission();
-    delayMicroseconds(550);
+    flushCommands();
+    if (table == NULL)
+        table = sharedCommandTiming;
+    else
+        memcpy(table, sharedCommandTiming, sizeof(sharedCommandTiming));
+    commandTiming = table;
+    asyncTiming = &commandTiming[0];
+    if (seekTuneTiming != NULL)
+        seekTuneTiming = findCommandTiming(seekTuneTiming->cmd);
 }
 
 /**
- * @ingroup group10 Generic Command and Response
- * @brief Sends a given command to the SI47XX devices.
- * @details This function can be useful when you want to execute a SI47XX device command and it was not implemented by this library.
- * @details In this case you have to check the  AN332-Si47XX PROGRAMMING GUIDE to know how the command works.
- * @details Also, you need to work with bit operators to compose the parameters of the command [ &(and), ˆ(xor), |(or) etc ].
+ * @ingroup group24 Command timing
  *
- * @see getCommandResponse, setProperty
+ * @brief Finds the timing entry of a given command.
  *
- * @param cmd command number (see AN332-Si47XX PROGRAMMING GUIDE)
- * @param parameter_size Parameter size in bytes. Tell the number of argument used by the command.
- * @param parameter unsigned byte array with the arguments of the command
+ * @param cmd command number
+ *
+ * @return si47x_command_timing* the entry of the command or the default entry.
  */
-void SI4735::sendCommand(uint8_t cmd, int parameter_size, const uint8_t *parameter)
+si47x_command_timing *SI4735::findCommandTiming(uint8_t cmd)
 {
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    // Sends the command to the device
-    Wire.write(cmd);
-    // Sends the argments (parameters) of the command
-    for (byte i = 0; i < parameter_size; i++)
-        Wire.write(parameter[i]);
-    Wire.endTransmission();
+    for (uint8_t i = 1; i < SI473X_COMMAND_TIMING_SIZE; i++)
+    {
+        if (commandTiming[i].cmd == cmd)
+            return &commandTiming[i];
+    }
+    return &commandTiming[0];
 }
 
 /**
- * @ingroup group10 Generic Command and Response
- * @brief   Returns with the command response.
- * @details After a command is executed by the device, you can get the result (response) of the command by calling this method.
+ * @ingroup group24 Command timing
  *
- * @see sendCommand, setProperty
+ * @brief Stores a measured completion time.
  *
- * @param response_size  num of bytes returned by the command.
- * @param response  byte array where the response will be stored.
+ * @details If the auto tune is enabled (always for the sweep timing), moves the expected time 1/8 toward the measured one.
+ *          As the measured time includes part of a poll interval, half of the poll interval is discounted.
+ *
+ * @param timing entry of the command
+ * @param measured completion time in us
  */
-void SI4735::getCommandResponse(int response_size, uint8_t *response)
+void SI4735::updateCommandTiming(si47x_command_timing *timing, uint32_t measured)
 {
-    waitToSend();
-    // Asks the device to return a given number o bytes response
-    Wire.requestFrom(deviceAddress, response_size);
-    // Gets response information
-    for (byte i = 0; i < response_size; i++)
-        response[i] = Wire.read();
+    uint16_t sample;
+
+    timing->measured = (measured > 65535) ? 65535 : measured;
+
+    // The FAST tunes of the sweep always follow the measured STC time: every point is the same tune
+    if (!commandTimingAutoTune && timing != &sweepTiming)
+        return;
+
+    sample = (timing->measured > (timing->pollInterval >> 1)) ? timing->measured - (timing->pollInterval >> 1) : 0;
+    timing->expected = timing->expected - (timing->expected >> 3) + (sample >> 3);
 }
 
 /**
- * @ingroup group10 Generic Command and Response
- * @brief Gets the first byte response.
- * @details In this context status is the first response byte for any SI47XX command. See si47x_status structure.
- * @details This function can be useful to check, for example, the success or failure of a command.
+ * @ingroup group24 Command timing
  *
- * @see si47x_status
+ * @brief Sets the timing of a given command.
  *
- * @return si47x_status
+ * @details Only the commands of the table can be changed (see si47x_command_timing). Use 0x00 to change the default entry.
+ *
+ * @param cmd command number (example: SET_PROPERTY or FM_TUNE_FREQ)
+ * @param expected expected completion time in us
+ * @param pollInterval interval between checks in us
+ * @param timeout maximum time in ms
  */
-si47x_status SI4735::getStatusResponse()
+void SI4735::setCommandTiming(uint8_t cmd, uint16_t expected, uint16_t pollInterval, uint16_t timeout)
 {
-    si47x_status status;
+    si47x_command_timing *timing = findCommandTiming(cmd);
 
-    Wire.requestFrom(deviceAddress, 1);
-    status.raw = Wire.read();
+    if (timing->cmd != cmd)
+        return;
 
-    return status;
+    timing->expected = expected;
+    timing->pollInterval = (pollInterval > 0) ? pollInterval : 1;
+    timing->timeout = timeout;
 }
 
 /**
- * @ingroup group10 Generic get property
- *
- * @brief Gets a given property from the SI47XX
+ * @ingroup group24 Command timing
  *
- * @details This method is used to get a given property from SI47XX
- * @details You might need to extract set of bits information from the returned value to know the real value
- *
- * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); pages 55, 69, 124 and  134.
- * @see sendProperty, setProperty, sendCommand, getCommandResponse
+ * @brief Gets the timing of a given command (including the last measured completion time).
  *
- * @param propertyNumber property number (example: RX_VOLUME)
+ * @param cmd command number (example: SET_PROPERTY or FM_TUNE_FREQ)
  *
- * @return property value  (the content of the property)
+ * @return si47x_command_timing (the default entry if the command is not in the table)
  */
-int32_t
-SI4735::getProperty(uint16_t propertyNumber)
+si47x_command_timing SI4735::getCommandTiming(uint8_t cmd)
 {
-    si47x_property property;
-    si47x_status status;
-
-    property.value = propertyNumber;
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(GET_PROPERTY);
-    Wire.write(0x00);
-    Wire.write(property.raw.byteHigh); // Send property - High byte - most significant first
-    Wire.write(property.raw.byteLow);  // Send property - Low byte - less significant after
-    Wire.endTransmission();
-
-    waitToSend();
-    Wire.requestFrom(deviceAddress, 4);
-    status.raw = Wire.read();
-
-    // if error, return 0;
-    if (status.refined.ERR == 1)
-        return -1;
-
-    Wire.read(); // dummy
-
-    // gets the property value
-    property.raw.byteHigh = Wire.read();
-    property.raw.byteLow = Wire.read();
-
-    return property.value;
+    return *findCommandTiming(cmd);
 }
 
 /** @defgroup group12 FM Mono Stereo audio setup */
@@ -1754,15 +6722,8 @@ void SI4735::setFmStereoOn()
  */
 void SI4735::disableFmDebug()
 {
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(0x12);
-    Wire.write(0x00);
-    Wire.write(0xFF);
-    Wire.write(0x00);
-    Wire.write(0x00);
-    Wire.write(0x00);
-    Wire.endTransmission();
-    delayMicroseconds(2500);
+    const uint8_t arg[] = {0x00, 0xFF, 0x00, 0x00, 0x00};
+    runCommand(SET_PROPERTY, 5, arg);
 }
 
 /** @defgroup group13 Audio setup */
@@ -1850,6 +6811,7 @@ void SI4735::setAudioMute(bool off)
 {
     uint16_t value = (off) ? 3 : 0; // 3 means mute; 0 means unmute
     sendProperty(RX_HARD_MUTE, value);
+    audioMuted = off;
 }
 
 /**
@@ -1957,14 +6919,9 @@ void SI4735::RdsInit()
  */
 void SI4735::setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t BLETHC, uint8_t BLETHD)
 {
-    si47x_property property;
+    si47x_property param;
     si47x_rds_config config;
 
-    waitToSend();
-
-    // Set property value
-    property.value = FM_RDS_CONFIG;
-
     // Arguments
     config.arg.RDSEN = RDSEN;
     config.arg.BLETHA = BLETHA;
@@ -1973,15 +6930,9 @@ void SI4735::setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t
     config.arg.BLETHD = BLETHD;
     config.arg.DUMMY1 = 0;
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SET_PROPERTY);
-    Wire.write(0x00);                  // Always 0x00 (I need to check it)
-    Wire.write(property.raw.byteHigh); // Send property - High byte - most significant first
-    Wire.write(property.raw.byteLow);  // Low byte
-    Wire.write(config.raw[1]);         // Send the argments. Most significant first
-    Wire.write(config.raw[0]);
-    Wire.endTransmission();
-    delayMicroseconds(550);
+    param.raw.byteHigh = config.raw[1]; // Most significant first
+    param.raw.byteLow = config.raw[0];
+    sendProperty(FM_RDS_CONFIG, param.value);
 
     RdsInit();
 }
@@ -2003,7 +6954,7 @@ void SI4735::setRdsConfig(uint8_t RDSEN, uint8_t BLETHA, uint8_t BLETHB, uint8_t
  */
 void SI4735::setRdsIntSource(uint8_t RDSRECV, uint8_t RDSSYNCLOST, uint8_t RDSSYNCFOUND, uint8_t RDSNEWBLOCKA, uint8_t RDSNEWBLOCKB)
 {
-    si47x_property property;
+    si47x_property param;
     si47x_rds_int_source rds_int_source;
 
     if (currentTune != FM_TUNE_FREQ)
@@ -2017,19 +6968,9 @@ void SI4735::setRdsIntSource(uint8_t RDSRECV, uint8_t RDSSYNCLOST, uint8_t RDSSY
     rds_int_source.refined.DUMMY1 = 0;
     rds_int_source.refined.DUMMY2 = 0;
 
-    property.value = FM_RDS_INT_SOURCE;
-
-    waitToSend();
-
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SET_PROPERTY);
-    Wire.write(0x00);                  // Always 0x00 (I need to check it)
-    Wire.write(property.raw.byteHigh); // Send property - High byte - most significant first
-    Wire.write(property.raw.byteLow);  // Low byte
-    Wire.write(rds_int_source.raw[1]); // Send the argments. Most significant first
-    Wire.write(rds_int_source.raw[0]);
-    Wire.endTransmission();
-    waitToSend();
+    param.raw.byteHigh = rds_int_source.raw[1]; // Most significant first
+    param.raw.byteLow = rds_int_source.raw[0];
+    sendProperty(FM_RDS_INT_SOURCE, param.value);
 }
 
 /**
@@ -2061,26 +7002,18 @@ void SI4735::getRdsStatus(uint8_t INTACK, uint8_t MTFIFO, uint8_t STATUSONLY)
         clearRdsBuffer0A();
     }
 
-    waitToSend();
-
     rds_cmd.arg.INTACK = INTACK;
     rds_cmd.arg.MTFIFO = MTFIFO;
     rds_cmd.arg.STATUSONLY = STATUSONLY;
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(FM_RDS_STATUS);
-    Wire.write(rds_cmd.raw);
-    Wire.endTransmission();
+    uint8_t retry = 0;
 
     do
     {
-        waitToSend();
         // Gets response information
-        Wire.requestFrom(deviceAddress, 13);
-        for (uint8_t i = 0; i < 13; i++)
-            currentRdsStatus.raw[i] = Wire.read();
-    } while (currentRdsStatus.resp.ERR);
-    delayMicroseconds(550);
+        runCommand(FM_RDS_STATUS, 1, &rds_cmd.raw, 13, currentRdsStatus.raw);
+    } while (currentRdsStatus.resp.ERR && retryCommand(retry));
+    // No delay: the response was read with the CTS set, so the next command can be sent right away
 }
 
 
@@ -2756,31 +7689,17 @@ char *SI4735::getRdsDateTime()
  * @see AN332 REV 0.8 UNIVERSAL PROGRAMMING GUIDE; pages 5 and 23
  *
  * @param offset 16-bit signed value (unit in Hz). The valid range is -16383 to +16383 Hz.
+ *
+ * @see setFrequencyHz
  */
 void SI4735::setSSBBfo(int offset)
 {
-
-    si47x_property property;
-    si47x_frequency bfo_offset;
-
     if (currentTune == FM_TUNE_FREQ) // Only for AM/SSB mode
         return;
 
-    waitToSend();
-
-    property.value = SSB_BFO;
-    bfo_offset.value = offset;
-
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SET_PROPERTY);
-    Wire.write(0x00);                  // Always 0x00
-    Wire.write(property.raw.byteHigh); // High byte first
-    Wire.write(property.raw.byteLow);  // Low byte after
-    Wire.write(bfo_offset.raw.FREQH);  // Offset freq. high byte first
-    Wire.write(bfo_offset.raw.FREQL);  // Offset freq. low byte first
-
-    Wire.endTransmission();
-    delayMicroseconds(550);
+    // 16-bit signed offset (two's complement); high byte first
+    sendProperty(SSB_BFO, (uint16_t)offset);
+    bfoOffset = -offset; // See getFrequencyHz
 }
 
 /**
@@ -2953,12 +7872,15 @@ void SI4735::setSSB(uint8_t usblsb)
     // powerDown();
     // It starts with the same AM parameters.
     // setPowerUp(1, 1, 0, 1, 1, currentAudioMode);
-    setPowerUp(this->ctsIntEnable, 0, 0, this->currentClockType, 1, this->currentAudioMode);
+    setPowerUp(this->ctsIntEnable, this->gpo2Enable, 0, this->currentClockType, 1, this->currentAudioMode);
     radioPowerUp();
     // ssbPowerUp(); // Not used for regular operation
+    lastMode = SSB_CURRENT_MODE;
+    restoreModeState(SSB_CURRENT_MODE); // Properties and AGC set the last time the device was on SSB
     setVolume(volume); // Set to previus configured volume
     currentSsbStatus = usblsb;
-    lastMode = SSB_CURRENT_MODE;
+    bfoOffset = 0; // The power up clears the BFO
+    currentBandIdx = SI473X_BAND_NONE; // See setBand
 }
 
 /**
@@ -3004,19 +7926,10 @@ void SI4735::setSSB(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, ui
  */
 void SI4735::sendSSBModeProperty()
 {
-    si47x_property property;
-    property.value = SSB_MODE;
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SET_PROPERTY);
-    Wire.write(0x00);                  // Always 0x00
-    Wire.write(property.raw.byteHigh); // High byte first
-    Wire.write(property.raw.byteLow);  // Low byte after
-    Wire.write(currentSSBMode.raw[1]); // SSB MODE params; freq. high byte first
-    Wire.write(currentSSBMode.raw[0]); // SSB MODE params; freq. low byte after
-
-    Wire.endTransmission();
-    delayMicroseconds(550);
+    si47x_property param;
+    param.raw.byteHigh = currentSSBMode.raw[1]; // SSB MODE params; high byte first
+    param.raw.byteLow = currentSSBMode.raw[0];  // SSB MODE params; low byte after
+    sendProperty(SSB_MODE, param.value);
 }
 
 /**
@@ -3030,19 +7943,12 @@ void SI4735::sendSSBModeProperty()
  */
 void SI4735::getSsbAgcStatus()
 {
-    waitToSend();
+    uint8_t retry = 0;
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SSB_AGC_STATUS);
-    Wire.endTransmission();
     do
     {
-        waitToSend();
-        Wire.requestFrom(deviceAddress, 3);
-        currentAgcStatus.raw[0] = Wire.read(); // STATUS response
-        currentAgcStatus.raw[1] = Wire.read(); // RESP 1
-        currentAgcStatus.raw[2] = Wire.read(); // RESP 2
-    } while (currentAgcStatus.refined.ERR);    // If error, try get AGC status again.
+        runCommand(SSB_AGC_STATUS, 0, NULL, 3, currentAgcStatus.raw); // STATUS response, RESP 1 and RESP 2
+    } while (currentAgcStatus.refined.ERR && retryCommand(retry)); // If error, try get AGC status again.
 }
 
 /**
@@ -3063,15 +7969,7 @@ void SI4735::setSsbAgcOverrite(uint8_t SSBAGCDIS, uint8_t SSBAGCNDX, uint8_t res
     agc.arg.AGCDIS = SSBAGCDIS;
     agc.arg.AGCIDX = SSBAGCNDX;
 
-    waitToSend();
-
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(SSB_AGC_OVERRIDE);
-    Wire.write(agc.raw[0]);
-    Wire.write(agc.raw[1]);
-    Wire.endTransmission();
-
-    waitToSend();
+    runCommand(SSB_AGC_OVERRIDE, 2, agc.raw);
 }
 
 /***************************************************************************************
@@ -3103,27 +8001,23 @@ void SI4735::setSsbAgcOverrite(uint8_t SSBAGCDIS, uint8_t SSBAGCNDX, uint8_t res
 si47x_firmware_query_library SI4735::queryLibraryId()
 {
     si47x_firmware_query_library libraryID;
+    const uint8_t arg[] = {0b00011111,           // Set to Read Library ID, disable interrupt; disable GPO2OEN; boot normaly; enable External Crystal Oscillator  .
+                           SI473X_ANALOG_AUDIO}; // Set to Analog Line Input.
 
     powerDown(); // Is it necessary
 
     // delay(500);
 
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(POWER_UP);
-    Wire.write(0b00011111);          // Set to Read Library ID, disable interrupt; disable GPO2OEN; boot normaly; enable External Crystal Oscillator  .
-    Wire.write(SI473X_ANALOG_AUDIO); // Set to Analog Line Input.
-    Wire.endTransmission();
+    uint8_t retry = 0;
 
     do
     {
-        waitToSend();
-        Wire.requestFrom(deviceAddress, 8);
-        for (int i = 0; i < 8; i++)
-            libraryID.raw[i] = Wire.read();
-    } while (libraryID.resp.ERR); // If error found, try it again.
+        runCommand(POWER_UP, 2, arg, 8, libraryID.raw);
+    } while (libraryID.resp.ERR && retryCommand(retry)); // If error found, try it again.
 
-    delayMicroseconds(2500);
+    // The device goes back to the powerdown mode after the reply: waits for the CTS instead of a fixed delay
+    deviceReady = false;
+    waitToSend();
 
     return libraryID;
 }
@@ -3143,15 +8037,34 @@ si47x_firmware_query_library SI4735::queryLibraryId()
  */
 void SI4735::patchPowerUp()
 {
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(POWER_UP);
-    Wire.write(0b00110001);          // This is a condition for loading the patch: Set to AM, Enable External Crystal Oscillator; Set patch enable; GPO2 output disabled; CTS interrupt disabled. You can change this calling setSSB.
-    Wire.write(SI473X_ANALOG_AUDIO); // This is a condition for loading the patch: Set to Analog Output. You can change this calling setSSB.
-    Wire.endTransmission();
+    sendPatchPowerUp(1, POWER_UP_AM); // This is a condition for loading the patch: Set to AM; Set patch enable
     delay(maxDelayAfterPouwerUp);
 }
 
+/**
+ * @ingroup group17 Patch and SSB support
+ *
+ * @brief Sends the POWER_UP used to load a patch: crystal oscillator and analog audio output.
+ *
+ * @details The CTS interrupt and the GPO2/INT output follow setInterruptPin, like radioPowerUp. With them disabled,
+ *          the device would not signal the CTS of the patch lines and of the next commands on the INT pin.
+ *
+ * @param PATCH 1 = Copy non-volatile memory to RAM (patch download); 0 = Boot normally
+ * @param FUNC POWER_UP_FM or POWER_UP_AM
+ */
+void SI4735::sendPatchPowerUp(uint8_t PATCH, uint8_t FUNC)
+{
+    si473x_powerup arg;
+
+    arg.arg.CTSIEN = this->ctsIntEnable;
+    arg.arg.GPO2OEN = this->gpo2Enable;
+    arg.arg.PATCH = PATCH;
+    arg.arg.XOSCEN = XOSCEN_CRYSTAL;
+    arg.arg.FUNC = FUNC;
+    arg.arg.OPMODE = SI473X_ANALOG_AUDIO; // This is a condition for loading the patch. You can change this calling setSSB or setNBFM.
+    runCommand(POWER_UP, 2, arg.raw);
+}
+
 /**
  * @ingroup group17 Patch and SSB support
  *
@@ -3159,16 +8072,10 @@ void SI4735::patchPowerUp()
  */
 void SI4735::ssbPowerUp()
 {
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(POWER_UP);
-    Wire.write(0b00010001); // This is a condition for loading the patch: Set to AM, Enable External Crystal Oscillator; Set patch enable; GPO2 output disabled; CTS interrupt disabled. You can change this calling setSSB.
-    Wire.write(0b00000101); // This is a condition for loading the patch: Set to Analog Output. You can change this calling setSSB.
-    Wire.endTransmission();
-    delayMicroseconds(2500);
+    sendPatchPowerUp(0, POWER_UP_AM);
 
     powerUp.arg.CTSIEN = this->ctsIntEnable;     // 1 -> Interrupt anabled;
-    powerUp.arg.GPO2OEN = 0;                     // 1 -> GPO2 Output Enable;
+    powerUp.arg.GPO2OEN = this->gpo2Enable;      // 1 -> GPO2 Output Enable;
     powerUp.arg.PATCH = 0;                       // 0 -> Boot normally;
     powerUp.arg.XOSCEN = this->currentClockType; // 1 -> Use external crystal oscillator;
     powerUp.arg.FUNC = 1;                        // 0 = FM Receive; 1 = AM/SSB (LW/MW/SW) Receiver.
@@ -3217,17 +8124,13 @@ void SI4735::ssbPowerUp()
  */
 bool SI4735::downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size)
 {
-    uint8_t content;
+    uint8_t content[8];
     // Send patch to the SI4735 device
     for (uint16_t offset = 0; offset < ssb_patch_content_size; offset += 8)
     {
-        Wire.beginTransmission(deviceAddress);
         for (uint16_t i = 0; i < 8; i++)
-        {
-            content = pgm_read_byte_near(ssb_patch_content + (i + offset));
-            Wire.write(content);
-        }
-        Wire.endTransmission();
+            content[i] = pgm_read_byte_near(ssb_patch_content + (i + offset));
+        i2cWrite(deviceAddress, content, 8);
 
         // Testing download performance
         // approach 1 - Faster - less secure (it might crash in some architectures)
@@ -3305,29 +8208,24 @@ bool SI4735::downloadPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_
  */
 bool SI4735::downloadCompressedPatch(const uint8_t *ssb_patch_content, const uint16_t ssb_patch_content_size, const uint16_t *cmd_0x15, const int16_t cmd_0x15_size)
 {
-    uint8_t cmd, content;
+    uint8_t content[8];
     uint16_t command_line = 0;
     // Send patch to the SI4735 device
     for (uint16_t offset = 0; offset < ssb_patch_content_size; offset += 7)
     {
         // Checks if the current line starts with 0x15
-        cmd = 0x16;
+        content[0] = 0x16;
         for (uint16_t i = 0; i < cmd_0x15_size / sizeof(uint16_t); i++)
         {
             if (pgm_read_word_near(cmd_0x15 + i) == command_line)
             { // it needs performance improvement: save the last "i" value to be used next time
-                cmd = 0x15;
+                content[0] = 0x15;
                 break;
             }
         }
-        Wire.beginTransmission(deviceAddress);
-        Wire.write(cmd);
         for (uint16_t i = 0; i < 7; i++)
-        {
-            content = pgm_read_byte_near(ssb_patch_content + (i + offset));
-            Wire.write(content);
-        }
-        Wire.endTransmission();
+            content[i + 1] = pgm_read_byte_near(ssb_patch_content + (i + offset));
+        i2cWrite(deviceAddress, content, 8);
         delayMicroseconds(MIN_DELAY_WAIT_SEND_LOOP); // Need check the minimum value
         command_line++;
     }
@@ -3407,47 +8305,33 @@ si4735_eeprom_patch_header SI4735::downloadPatchFromEeprom(int eeprom_i2c_addres
     si4735_eeprom_patch_header eep;
     const int header_size = sizeof eep;
     uint8_t bufferAux[8];
+    uint8_t eepromOffset[2];
     int offset, i;
 
     // Gets the EEPROM patch header information
-    Wire.beginTransmission(eeprom_i2c_address);
-    Wire.write(0x00); // offset Most significant Byte
-    Wire.write(0x00); // offset Less significant Byte
-    Wire.endTransmission();
+    eepromOffset[0] = 0x00; // offset Most significant Byte
+    eepromOffset[1] = 0x00; // offset Less significant Byte
+    i2cWrite(eeprom_i2c_address, eepromOffset, 2);
     delay(5);
 
     // The first two bytes of the header will be ignored.
     for (int k = 0; k < header_size; k += 8)
-    {
-        Wire.requestFrom(eeprom_i2c_address, 8);
-        for (int i = k; i < (k + 8); i++)
-            eep.raw[i] = Wire.read();
-    }
+        i2cRead(eeprom_i2c_address, &eep.raw[k], 8);
 
     // Transferring patch from EEPROM to SI4735 device
     offset = header_size;
     for (i = 0; i < (int)eep.refined.patch_size; i += 8)
     {
         // Reads patch content from EEPROM
-        Wire.beginTransmission(eeprom_i2c_address);
-        Wire.write((int)offset >> 8);   // header_size >> 8 wil be always 0 in this case
-        Wire.write((int)offset & 0XFF); // offset Less significant Byte
-        Wire.endTransmission();
-
-        Wire.requestFrom(eeprom_i2c_address, 8);
-        for (int j = 0; j < 8; j++)
-        {
-            bufferAux[j] = Wire.read();
-        }
+        eepromOffset[0] = (int)offset >> 8;   // header_size >> 8 wil be always 0 in this case
+        eepromOffset[1] = (int)offset & 0XFF; // offset Less significant Byte
+        i2cWriteRead(eeprom_i2c_address, eepromOffset, 2, bufferAux, 8);
 
-        Wire.beginTransmission(deviceAddress);
-        Wire.write(bufferAux, 8);
-        Wire.endTransmission();
+        i2cWrite(deviceAddress, bufferAux, 8);
 
         waitToSend();
         uint8_t cmd_status;
-        Wire.requestFrom(deviceAddress, 1);
-        cmd_status = Wire.read();
+        cmd_status = readStatus().raw;
         // The SI4735 issues a status after each 8 byte transfered.Just the bit 7(CTS)should be seted.if bit 6(ERR)is seted, the system halts.
         if (cmd_status != 0x80)
         {
@@ -3588,12 +8472,7 @@ void SI4735::removeUnwantedChar(char *str, int size) {
  */
 void SI4735::patchPowerUpNBFM()
 {
-    waitToSend();
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(POWER_UP);
-    Wire.write(0b00110000);          // This is a condition for loading the patch: Set to AM, Enable External Crystal Oscillator; Set patch enable; GPO2 output disabled; CTS interrupt disabled.
-    Wire.write(SI473X_ANALOG_AUDIO); // This is a condition for loading the patch: Set to Analog Output. You can change this calling setNBFM.
-    Wire.endTransmission();
+    sendPatchPowerUp(1, POWER_UP_FM); // This is a condition for loading the patch: Set to FM; Set patch enable
     delay(maxDelayAfterPouwerUp);
 }
 
@@ -3642,6 +8521,7 @@ void SI4735::setNBFM()
     setVolume(volume); // Set to previus configured volume
     currentSsbStatus = 0;
     lastMode = NBFM_CURRENT_MODE;
+    currentBandIdx = SI473X_BAND_NONE; // See setBand
 }
 
 /**
@@ -3690,18 +8570,17 @@ void SI4735::setNBFM(uint16_t fromFreq, uint16_t toFreq, uint16_t initialFreq, u
  */
 void SI4735::setFrequencyNBFM(uint16_t freq)
 {
-    waitToSend(); // Wait for the si473x is ready.
+    uint8_t arg[3];
+
     currentFrequency.value = freq;
     currentFrequencyParams.arg.FREQH = currentFrequency.raw.FREQH;
     currentFrequencyParams.arg.FREQL = currentFrequency.raw.FREQL;
 
-    Wire.beginTransmission(deviceAddress);
-    Wire.write(0x50);
-    Wire.write(0x00); // Send a byte with FAST and  FREEZE information; if not FM must be 0;
-    Wire.write(currentFrequency.raw.FREQH);
-    Wire.write(currentFrequency.raw.FREQL);
-    Wire.endTransmission();
-    waitToSend();                // Wait for the si473x is ready.
+    arg[0] = 0x00; // Send a byte with FAST and  FREEZE information; if not FM must be 0;
+    arg[1] = currentFrequency.raw.FREQH;
+    arg[2] = currentFrequency.raw.FREQL;
+    prepareSeekTune(NBFM_TUNE_FREQ);
+    runCommand(NBFM_TUNE_FREQ, 3, arg);
     currentWorkFrequency = freq; // check it
-    delay(250);                  // For some reason I need to delay here.
+    waitSeekTuneComplete(); // See SI473X_TIMING_NBFM_TUNE
 }
@@ -60,6 +60,16 @@
 #define FM_RDS_CONFIG 0x1502
 #define FM_RDS_CONFIDENCE 0x1503
 
+// FM RSQ interrupt properties
+#define FM_RSQ_INT_SOURCE 0x1200             // Configures interrupts related to Received Signal Quality metrics. All interrupts are disabled by default.
+#define FM_RSQ_SNR_HI_THRESHOLD 0x1201       // Sets high threshold for SNR interrupt.
+#define FM_RSQ_SNR_LO_THRESHOLD 0x1202       // Sets low threshold for SNR interrupt.
+#define FM_RSQ_RSSI_HI_THRESHOLD 0x1203      // Sets high threshold for RSSI interrupt.
+#define FM_RSQ_RSSI_LO_THRESHOLD 0x1204      // Sets low threshold for RSSI interrupt.
+#define FM_RSQ_MULTIPATH_HI_THRESHOLD 0x1205 // Sets high threshold for multipath interrupt.
+#define FM_RSQ_MULTIPATH_LO_THRESHOLD 0x1206 // Sets low threshold for multipath interrupt.
+#define FM_RSQ_BLEND_THRESHOLD 0x1207        // Sets the blend threshold for blend interrupt.
+
 #define FM_DEEMPHASIS 0x1100
 #define FM_BLEND_STEREO_THRESHOLD 0x1105
 #define FM_BLEND_MONO_THRESHOLD 0x1106
@@ -203,6 +213,207 @@
 #define MAX_DELAY_AFTER_POWERUP 10       // In ms - Max delay you have to setup after a power up command.
 #define MIN_DELAY_WAIT_SEND_LOOP 300     // In uS (Microsecond) - each loop of waitToSend sould wait this value in microsecond
 #define MAX_SEEK_TIME 8000               // defines the maximum seeking time 8s is default.
+#define MAX_DELAY_CTS_FALLBACK 5000      // In uS - In interrupt mode, the CTS bit is checked at least once in this interval even without INT pulse.
+
+#if defined(ESP32) || defined(ESP8266)
+#define SI473X_ISR_ATTR IRAM_ATTR
+#else
+#define SI473X_ISR_ATTR
+#endif
+
+// Command timing defaults: SI473X_TIMING_* in SI4735.cpp (library-wide build flags; see group24 Command timing)
+#define SI473X_COMMAND_TIMING_SIZE 9 // Number of entries of the command timing table
+
+#ifndef SI473X_SWEEP_SAMPLE_INTERVAL
+#define SI473X_SWEEP_SAMPLE_INTERVAL 1000 // In us - Interval between the RSQ readings averaged for each sweep point
+#endif
+
+#define SI473X_SWEEP_IDLE 0    // No sweep in progress
+#define SI473X_SWEEP_TUNE 1    // Sweep: the next point has to be tuned
+#define SI473X_SWEEP_SETTLE 2  // Sweep: waiting for the STC of the point
+#define SI473X_SWEEP_MEASURE 3 // Sweep: reading the RSQ of the point
+
+#ifndef SI473X_SOFT_SEEK_MARGIN
+#define SI473X_SOFT_SEEK_MARGIN 12 // In dB - A coarse point this close to the RSSI threshold is refined (adjacent channel leakage)
+#endif
+#ifndef SI473X_SOFT_SEEK_RSSI
+#define SI473X_SOFT_SEEK_RSSI 20 // In dBuV - Default minimum RSSI of the software seek (see setSoftSeekCriteria)
+#endif
+#ifndef SI473X_SOFT_SEEK_SNR
+#define SI473X_SOFT_SEEK_SNR 5 // In dB - Default minimum SNR of the software seek (see setSoftSeekCriteria)
+#endif
+#ifndef SI473X_SOFT_SEEK_AM_COARSE
+#define SI473X_SOFT_SEEK_AM_COARSE 4 // In kHz - Default coarse step of the software seek on AM and SSB (see setSoftSeekSteps)
+#endif
+#ifndef SI473X_SOFT_SEEK_RDS_POLL
+#define SI473X_SOFT_SEEK_RDS_POLL 20 // In ms - Interval between RDS sync checks of a software seek candidate
+#endif
+
+#define SI473X_SOFT_SEEK_IDLE 0    // No software seek in progress
+#define SI473X_SOFT_SEEK_TUNE 1    // Software seek: the next point has to be tuned
+#define SI473X_SOFT_SEEK_SETTLE 2  // Software seek: waiting for the STC of the point
+#define SI473X_SOFT_SEEK_RDS 3     // Software seek: waiting for the RDS sync of the candidate
+#define SI473X_SOFT_SEEK_MEASURE 4 // Software seek: waiting for the RSQ_STATUS of the point
+
+#define SI473X_SOFT_SEEK_COARSE 0 // Software seek phase: coarse steps
+#define SI473X_SOFT_SEEK_REFINE 1 // Software seek phase: fine steps around a candidate
+#define SI473X_SOFT_SEEK_VERIFY 2 // Software seek phase: normal tune and full check of the strongest point
+
+#ifndef SI473X_AUTOSTORE_SLICE
+#define SI473X_AUTOSTORE_SLICE 2000 // In us - Default time spent by each autostoreTick call
+#endif
+#ifndef SI473X_AUTOSTORE_RDS_POLL
+#define SI473X_AUTOSTORE_RDS_POLL 40 // In ms - Interval between RDS FIFO reads while the PI and PS of a station are collected
+#endif
+
+#define SI473X_AUTOSTORE_IDLE 0    // No band scan in progress
+#define SI473X_AUTOSTORE_TUNE 1    // Autostore: tuning the bottom of the band
+#define SI473X_AUTOSTORE_SEEK 2    // Autostore: seeking the next station
+#define SI473X_AUTOSTORE_RDS 3     // Autostore: collecting the PI and PS of the station
+#define SI473X_AUTOSTORE_RESTORE 4 // Autostore: tuning the frequency used before the scan
+
+#ifndef SI473X_ANTCAP_SPAN_FM
+#define SI473X_ANTCAP_SPAN_FM 32 // Default search span (capacitor units) around the automatic value on FM (see findBestAntennaCapacitor)
+#endif
+#ifndef SI473X_ANTCAP_SPAN_AM
+#define SI473X_ANTCAP_SPAN_AM 512 // Default search span (capacitor units) around the automatic value on LW/MW
+#endif
+
+#define SI473X_BAND_FM 0      // Band plan: FM (10 kHz units)
+#define SI473X_BAND_AM 1      // Band plan: AM - LW, MW and SW (kHz)
+#define SI473X_BAND_LSB 2     // Band plan: SSB lower side band (kHz; needs the SSB patch)
+#define SI473X_BAND_USB 3     // Band plan: SSB upper side band (kHz; needs the SSB patch)
+#define SI473X_BAND_NONE 0xFF // Band plan: no band (see findBand)
+
+// Pluggable I2C transport (see setTransport and setI2CBus). On AVR boards, the library talks to Wire directly by default:
+// no transport pointer and no virtual call. Define SI473X_TRANSPORT to get setTransport and setI2CBus there, or
+// SI473X_WIRE_ONLY to remove them on the other boards. Define it for the library and the sketch.
+#if defined(SI473X_WIRE_ONLY)
+#undef SI473X_TRANSPORT
+#elif !defined(__AVR__) && !defined(SI473X_TRANSPORT)
+#define SI473X_TRANSPORT
+#endif
+
+// I2C tracer (see setTraceBuffer and dumpTrace). Compiled out by default.
+// Enable it for the library and the sketch (example: build_flags = -DSI473X_TRACE or by uncommenting the line below).
+// #define SI473X_TRACE
+
+#ifdef SI473X_TRACE
+#define SI473X_TRACE_HOOK(...) __VA_ARGS__ // Tracer code (see SI473X_TRACE)
+#else
+#define SI473X_TRACE_HOOK(...)
+#endif
+
+#ifndef SI473X_RETRY_BUDGET
+#define SI473X_RETRY_BUDGET 3 // Maximum number of retries when the device answers with ERR (getStatus, getRdsStatus etc)
+#endif
+
+// Result codes (see getLastError)
+#define SI473X_OK 0                // No error
+#define SI473X_ERROR_TIMEOUT 1     // The device did not set the CTS in time (see si47x_command_timing)
+#define SI473X_ERROR_DEVICE 2      // The device answered with the ERR bit set (invalid command, argument or property)
+#define SI473X_ERROR_BUS 3         // The I2C transport failed (NACK, arbitration lost etc)
+#define SI473X_ERROR_QUEUE_FULL 4  // The asynchronous command queue is full
+#define SI473X_ERROR_INVALID_ARG 5 // Invalid argument (example: more than 7 arguments)
+
+
+#ifndef SI473X_ENCODER_IDLE
+#define SI473X_ENCODER_IDLE 250 // Time (ms) without encoder movement that resets the tuning velocity (see encoderTune)
+#endif
+
+#ifndef SI473X_BFO_WINDOW
+#define SI473X_BFO_WINDOW 16000 // Largest BFO offset (Hz) used by setFrequencyHz before the SSB carrier is tuned again (up to 16383)
+#endif
+
+#ifndef SI473X_PRIORITY_PERIOD
+#define SI473X_PRIORITY_PERIOD 3000 // Default time (ms) between two checks of the priority channel (see startPriorityWatch)
+#endif
+#ifndef SI473X_PRIORITY_RSSI
+#define SI473X_PRIORITY_RSSI 25 // In dBuV - Default minimum RSSI of the priority channel (see setPriorityCriteria)
+#endif
+#ifndef SI473X_PRIORITY_SNR
+#define SI473X_PRIORITY_SNR 8 // In dB - Default minimum SNR of the priority channel (see setPriorityCriteria)
+#endif
+
+#define SI473X_PRIORITY_IDLE 0    // Priority watch: waiting for the next check
+#define SI473X_PRIORITY_CHECK 1   // Priority watch: tuning the priority channel (audio muted)
+#define SI473X_PRIORITY_BACK 2    // Priority watch: tuning the frequency the user was listening to
+#define SI473X_PRIORITY_MEASURE 3 // Priority watch: reading the RSQ_STATUS of the priority channel (audio muted)
+
+#ifndef SI473X_SCAN_POLL
+#define SI473X_SCAN_POLL 100 // In ms - Interval between RSQ reads while the memory scan stays on an active channel
+#endif
+#ifndef SI473X_SCAN_RSSI
+#define SI473X_SCAN_RSSI 25 // In dBuV - Default minimum RSSI of an active channel (see setScanCriteria)
+#endif
+#ifndef SI473X_SCAN_SNR
+#define SI473X_SCAN_SNR 8 // In dB - Default minimum SNR of an active channel (see setScanCriteria)
+#endif
+#ifndef SI473X_SCAN_HANG_TIME
+#define SI473X_SCAN_HANG_TIME 2000 // In ms - Default time the memory scan waits after the signal is gone (see setScanTimes)
+#endif
+#ifndef SI473X_SCAN_FM_BAND
+#define SI473X_SCAN_FM_BAND 6400, 10800, 10 // Limits and step set by the memory scan for an FM channel out of the known bands
+#endif
+#ifndef SI473X_SCAN_AM_BAND
+#define SI473X_SCAN_AM_BAND 149, 30000, 1 // Limits and step set by the memory scan for an AM or SSB channel out of the known bands
+#endif
+
+#define SI473X_SCAN_IDLE 0  // No memory scan in progress
+#define SI473X_SCAN_NEXT 1  // Memory scan: selecting the next channel (mode switch if needed; audio muted)
+#define SI473X_SCAN_TUNE 2  // Memory scan: tuning and checking the channel (audio muted)
+#define SI473X_SCAN_DWELL 3 // Memory scan: stopped on an active channel
+#define SI473X_SCAN_HANG 4  // Memory scan: the signal of the channel is gone; waiting for the hang time
+
+#ifndef SI473X_RSQ_WINDOW
+#define SI473X_RSQ_WINDOW 3 // In dB - Default half width of the RSSI and SNR windows of the signal monitor (see startSignalMonitor)
+#endif
+#ifndef SI473X_RSQ_MONITOR_POLL
+#define SI473X_RSQ_MONITOR_POLL 100 // In ms - Interval between GET_INT_STATUS reads of the signal monitor in polling mode
+#endif
+
+// RSQ interrupt sources (see setRsqInterrupts)
+#define SI473X_RSQ_RSSI_LOW 0x01  // RSSI below the low threshold
+#define SI473X_RSQ_RSSI_HIGH 0x02 // RSSI above the high threshold
+#define SI473X_RSQ_SNR_LOW 0x04   // SNR below the low threshold
+#define SI473X_RSQ_SNR_HIGH 0x08  // SNR above the high threshold
+#define SI473X_RSQ_MULT_LOW 0x10  // FM: multipath below the low threshold
+#define SI473X_RSQ_MULT_HIGH 0x20 // FM: multipath above the high threshold
+#define SI473X_RSQ_BLEND 0x80     // FM: stereo blend crossed the blend threshold
+
+#ifndef SI473X_SNAPSHOT_TTL
+#define SI473X_SNAPSHOT_TTL 100 // In ms - Default age of a signal snapshot still served from the cache (see getSignalSnapshot)
+#endif
+
+#ifndef SI473X_METER_PERIOD
+#define SI473X_METER_PERIOD 100 // In ms - Default interval between two samples of the S-meter (see meterTick)
+#endif
+#ifndef SI473X_METER_SMOOTHING
+#define SI473X_METER_SMOOTHING 2 // S-meter smoothing: each sample moves the average by 1/2^N of the difference (0 = none)
+#endif
+#ifndef SI473X_METER_PEAK_HOLD
+#define SI473X_METER_PEAK_HOLD 1000 // In ms - Default time the S-meter peak is held before it decays
+#endif
+#ifndef SI473X_METER_PEAK_DECAY
+#define SI473X_METER_PEAK_DECAY 20 // In dB per second - Default decay of the S-meter peak after the hold time
+#endif
+#ifndef SI473X_METER_WINDOW
+#define SI473X_METER_WINDOW 1000 // In ms - Default length of the min/max/mean windows of the signal statistics
+#endif
+
+#define SI473X_METER_S9_HF -73  // S9 level (dBm) below 30 MHz: AM and SSB
+#define SI473X_METER_S9_VHF -93 // S9 level (dBm) above 30 MHz: FM and NBFM
+#define SI473X_METER_S_UNIT 6   // dB per S-unit
+
+#define SI473X_MODE_STATE_SSB 0x8000 // Mode state: flag of the 0x3xxx properties kept for SSB (apart from the AM ones)
+#define SI473X_MODE_STATE_AGC 0x0FFF // Mode state: low bits of the entry that keeps the AGC override (0x1FFF FM; 0x3FFF AM and SSB)
+
+// Step acceleration table (see si47x_step_acceleration). Default: SI473X_STEP_ACCELERATION in SI4735.cpp (library-wide build flag)
+#define SI473X_STEP_ACCELERATION_SIZE 6 // Number of entries of the step acceleration table
+
+#define SI473X_ASYNC_FREE 0    // Asynchronous command slot is free
+#define SI473X_ASYNC_PENDING 1 // Command is queued and waits for CTS to be sent
+#define SI473X_ASYNC_RUNNING 2 // Command was sent and waits for CTS (completion)
 
 #define DEFAULT_CURRENT_AVC_AM_MAX_GAIN 36
 
@@ -283,13 +494,15 @@ typedef union
     struct
     {
         uint8_t STCIEN : 1; //!< Seek/Tune Complete Interrupt Enable (0 or 1).
-        uint8_t DUMMY1 : 2; //!< Always write 0.
+        uint8_t DUMMY1 : 1; //!< Always write 0.
+        uint8_t RDSIEN : 1; //!< RDS Interrupt Enable (0 or 1). FM only.
         uint8_t RSQIEN : 1; //!< RSQ Interrupt Enable (0 or 1).
         uint8_t DUMMY2 : 2; //!< Always write 0.
         uint8_t ERRIEN : 1; //!< ERR Interrupt Enable (0 or 1).
         uint8_t CTSIEN : 1; //!< CTS Interrupt Enable (0 or 1).
         uint8_t STCREP : 1; //!< STC Interrupt Repeat (0 or 1).
-        uint8_t DUMMY3 : 2; //!< Always write 0.
+        uint8_t DUMMY3 : 1; //!< Always write 0.
+        uint8_t RDSREP : 1; //!< RDS Interrupt Repeat (0 or 1). FM only.
         uint8_t RSQREP : 1; //!< RSQ Interrupt Repeat (0 or 1).
         uint8_t DUMMY4 : 4; //!< Always write 0.
     } arg;
@@ -1047,6 +1260,651 @@ typedef struct
     uint16_t DOSR;                   // Digital Output Sample Rate(32–48 ksps .0 to disable digital audio output).
 } si4735_digital_output_sample_rate; // Maybe not necessary
 
+/**
+ * @ingroup group01
+ *
+ * @brief Callback called by the asynchronous command engine when a command is completed.
+ *
+ * @details The first parameter is the handle returned by sendCommandAsync and the second one is the status byte (RESP0) of the command.
+ *
+ * @see sendCommandAsync, commandTick
+ */
+typedef void (*si47x_command_callback)(uint8_t handle, si47x_status status);
+
+/**
+ * @ingroup group01
+ *
+ * @brief Command timing table entry
+ *
+ * @details Tells the asynchronous command engine when to check the CTS bit the first time after sending a command
+ *          (expected), how often to check it after that (pollInterval, increased by 50% after each check up to 4 times)
+ *          and when to give up (timeout).
+ * @details For tune and seek commands, the values refer to the Seek/Tune Complete (STC) bit (see waitSeekTuneComplete).
+ *
+ * @see setCommandTiming, setCommandTimingAutoTune
+ */
+typedef struct
+{
+    uint8_t cmd;           //!< Command number (0x00 = default for commands not found in the table)
+    uint16_t expected;     //!< Expected completion time in us (first check)
+    uint16_t pollInterval; //!< Interval between checks in us
+    uint16_t timeout;      //!< Maximum time in ms
+    uint16_t measured;     //!< Last completion time measured in us (65535 = 65535us or more)
+} si47x_command_timing;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Bandscope sweep point (see startSweep)
+ */
+typedef struct
+{
+    uint8_t rssi; //!< Received signal strength (dBuV)
+    uint8_t snr;  //!< Signal to noise ratio (dB)
+} si47x_sweep_point;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Callback called by the bandscope sweep after each point.
+ *
+ * @details The parameters are the index of the point in the buffer, its frequency and the point itself.
+ *
+ * @see startSweep, sweepTick
+ */
+typedef void (*si47x_sweep_callback)(uint16_t index, uint16_t frequency, si47x_sweep_point point);
+
+/**
+ * @ingroup group01
+ *
+ * @brief Criteria used by the software seek to accept a channel (see setSoftSeekCriteria)
+ */
+typedef struct
+{
+    uint8_t rssi;        //!< Minimum RSSI (dBuV)
+    uint8_t snr;         //!< Minimum SNR (dB)
+    uint8_t multipath;   //!< Maximum multipath (FM only; 0 = not checked; 1 to 100)
+    uint8_t rdsSync;     //!< 1 = the station has to get the RDS sync (FM only)
+    uint16_t rdsTimeout; //!< Maximum time (ms) to wait for the RDS sync
+} si47x_seek_criteria;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Custom check of a software seek candidate.
+ *
+ * @details Called with the frequency and the RSQ status of a channel that meets the si47x_seek_criteria.
+ *          Returns true to accept the channel.
+ *
+ * @see setSoftSeekFilter
+ */
+typedef bool (*si47x_seek_filter)(uint16_t frequency, si47x_rqs_status *rsq);
+
+/**
+ * @ingroup group01
+ *
+ * @brief Station found by the band scan (see startAutostore)
+ */
+typedef struct
+{
+    uint16_t frequency; //!< Current band units (FM => 10 kHz; AM and SSB => kHz)
+    uint8_t rssi;       //!< Received signal strength (dBuV)
+    uint8_t snr;        //!< Signal to noise ratio (dB)
+    uint8_t multipath;  //!< Multipath (FM only; 0 to 100)
+    uint16_t pi;        //!< RDS Program Identification (FM only; 0 = not received)
+    char ps[9];         //!< RDS Program Service name (FM only; empty = not received)
+} si47x_station;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Segment of the antenna capacitor table (see buildAntennaCapacitorTable)
+ *
+ * @details Between the frequencies of two segments, the capacitor is interpolated (the best capacitor of an LW/MW
+ *          antenna changes with the frequency).
+ */
+typedef struct
+{
+    uint16_t frequency; //!< Frequency where antcap was measured (center of the segment; current band units)
+    uint16_t antcap;    //!< Best tuning capacitor at frequency
+} si47x_antcap_segment;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Band of a band plan (see setBandPlan)
+ *
+ * @details 18 bytes per band. Declare the plan as constexpr and PROGMEM so it can be checked at compile time and stays
+ *          in flash memory (see isValidBandPlan).
+ */
+typedef struct
+{
+    char name[8];              //!< Band name (up to 7 characters)
+    uint8_t mode;              //!< SI473X_BAND_FM, SI473X_BAND_AM, SI473X_BAND_LSB or SI473X_BAND_USB
+    uint8_t bandwidthIdx;      //!< Filter: FM 0-4 (setFmBandwidth); AM 0-6 (setBandwidth); SSB 0-5 (setSSBAudioBandwidth)
+    uint16_t minimumFrequency; //!< Lower limit (FM 10 kHz units; AM and SSB kHz)
+    uint16_t maximumFrequency; //!< Upper limit
+    uint16_t defaultFrequency; //!< Frequency used when the band is selected without a frequency
+    uint16_t step;             //!< Default step (also the seek spacing)
+} si47x_band;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Channel of the memory scan list (see startScan)
+ */
+typedef struct
+{
+    uint16_t frequency; //!< FM 10 kHz units; AM and SSB kHz
+    uint8_t mode;       //!< SI473X_BAND_FM, SI473X_BAND_AM, SI473X_BAND_LSB or SI473X_BAND_USB
+} si47x_memory_channel;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Signal snapshot: RSQ_STATUS and AGC_STATUS of the current channel read at once (see getSignalSnapshot)
+ */
+typedef struct
+{
+    uint32_t timestamp;      //!< Time (ms) of the reading
+    uint16_t frequency;      //!< Frequency (current band units)
+    uint8_t rssi;            //!< Received signal strength (dBuV)
+    uint8_t snr;             //!< Signal to noise ratio (dB)
+    uint8_t multipath;       //!< FM: multipath (0 = none; 100 = full)
+    uint8_t blend;           //!< FM: stereo blend (100 = full stereo; 0 = full mono)
+    int8_t freqOffset;       //!< FM: frequency offset (kHz)
+    uint8_t agcIndex;        //!< AGC gain index (0 = maximum gain)
+    uint8_t valid : 1;       //!< The channel meets the seek/tune criteria
+    uint8_t pilot : 1;       //!< FM: stereo pilot present
+    uint8_t afcRail : 1;     //!< AFC rail
+    uint8_t softMute : 1;    //!< Soft mute engaged
+    uint8_t agcDisabled : 1; //!< AGC override on (see setAutomaticGainControl)
+    uint8_t fm : 1;          //!< Read on FM (multipath, blend, pilot and freqOffset are meaningful)
+    uint8_t dummy : 2;
+} si47x_signal_snapshot;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Signal statistics: minimum, maximum and mean of the S-meter samples of one window (see getSignalStats)
+ */
+typedef struct
+{
+    uint32_t timestamp; //!< Time (ms) the window was closed
+    uint16_t samples;   //!< Number of samples in the window (0 = no window closed yet)
+    uint8_t rssiMin;    //!< Lowest RSSI (dBuV)
+    uint8_t rssiMax;    //!< Highest RSSI (dBuV)
+    uint8_t rssiMean;   //!< Mean RSSI (dBuV)
+    uint8_t snrMin;     //!< Lowest SNR (dB)
+    uint8_t snrMax;     //!< Highest SNR (dB)
+    uint8_t snrMean;    //!< Mean SNR (dB)
+} si47x_signal_stats;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Step acceleration table entry
+ *
+ * @details When the encoder turns at rate detents per second or faster, each detent moves the frequency by
+ *          currentStep * multiplier (see encoderTune). The entries must be sorted by rate.
+ *
+ * @see encoderTune, setEncoderAccelerationLevel
+ */
+typedef struct
+{
+    uint16_t rate;      //!< Minimum encoder rate (detents per second)
+    uint8_t multiplier; //!< Step multiplier (the step is currentStep * multiplier)
+} si47x_step_acceleration;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Error counters and latency measurements (declared by the sketch; see setErrorStats)
+ *
+ * @see getErrorStats, resetErrorStats, getLastError
+ */
+typedef struct
+{
+    uint16_t commands;     //!< Number of commands completed (including the failed ones)
+    uint16_t timeouts;     //!< Number of commands given up because the CTS did not come in time
+    uint16_t deviceErrors; //!< Number of commands answered with the ERR bit set
+    uint16_t busErrors;    //!< Number of I2C transport failures
+    uint16_t retries;      //!< Number of retries after ERR (see setRetryBudget)
+    uint16_t stcTimeouts;  //!< Number of tune/seek waits finished without the STC
+    uint8_t lastError;     //!< Last result code different from SI473X_OK
+    uint8_t lastErrorCmd;  //!< Command that caused the last error
+    uint32_t maxLatency;   //!< Longest command completion time (us) - from the write to the CTS
+    uint32_t maxWait;      //!< Longest time (us) spent by runCommand (queue wait included)
+} si47x_error_stats;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Property shadow cache entry
+ *
+ * @details Stores the last value written to (or read from) a given property.
+ *
+ * @see sendProperty, getProperty, invalidatePropertyCache
+ */
+typedef struct
+{
+    uint16_t property; //!< Property number (example: RX_VOLUME)
+    uint16_t value;    //!< Last known value of the property
+} si47x_property_cache_entry;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Property write queued by beginProperties
+ *
+ * @see beginProperties, commitProperties
+ */
+typedef struct
+{
+    uint16_t property; //!< Property number (example: RX_VOLUME)
+    uint16_t value;    //!< Value to be written
+    uint8_t status;    //!< Status byte returned by the SET_PROPERTY command
+} si47x_property_batch_entry;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Callback called when the GPO2/INT pin reports an interrupt.
+ *
+ * @details The parameter has the STCINT, RDSINT, RSQINT and ERR bits read from the device.
+ * @details It is not called from the ISR. It is called by checkInterrupt (and so by commandTick and the other waiting functions).
+ *
+ * @see setInterruptPin, checkInterrupt
+ */
+typedef void (*si47x_interrupt_callback)(si47x_status flags);
+
+/**
+ * @ingroup group01
+ *
+ * @brief Asynchronous command data type
+ *
+ * @details Represents a command queued by the asynchronous command engine.
+ * @details The command and its arguments are stored in cmd (up to 8 bytes - the command plus 7 arguments).
+ *
+ * @see sendCommandAsync, commandTick
+ * @see Si47XX PROGRAMMING GUIDE; AN332 (REV 1.0); page 207 (8 bytes restriction)
+ */
+typedef struct
+{
+    uint8_t state;                 //!< SI473X_ASYNC_FREE, SI473X_ASYNC_PENDING or SI473X_ASYNC_RUNNING
+    uint8_t handle;                //!< Handle returned to the caller (never 0)
+    uint8_t cmd[8];                //!< Command (cmd[0]) and arguments (cmd[1] to cmd[7])
+    uint8_t cmdSize;               //!< Number of bytes stored in cmd
+    uint8_t responseSize;          //!< Number of response bytes (0 = status only)
+    uint8_t *response;             //!< Where the response will be stored (RESP0 to RESPn). Must be valid until the command is completed.
+    si47x_command_callback onDone; //!< Function called when the command is completed (can be NULL)
+} si47x_async_command;
+
+/**
+ * @ingroup group01
+ *
+ * @brief I2C tracer entry
+ *
+ * @details One entry per command (from the write to the response) or per direct I2C transaction
+ *          (patch upload, getCommandResponse, EEPROM etc). Consecutive status reads outside a command
+ *          (waiting for the CTS or the STC) are counted as polls of the same entry.
+ *
+ * @see getTraceEntry, dumpTrace
+ */
+typedef struct
+{
+    uint32_t start;    //!< Time (us) the command or transaction started
+    uint32_t elapsed;  //!< Time (us) until the response (CTS) or the end of the transaction
+    uint16_t property; //!< Property number for SET_PROPERTY and GET_PROPERTY (otherwise 0)
+    uint8_t cmd;       //!< Command (first byte written). 0 = status reads only
+    uint8_t written;   //!< Number of bytes written
+    uint8_t read;      //!< Number of bytes read
+    uint8_t polls;     //!< Number of CTS (or STC) checks (up to 255)
+    uint8_t result;    //!< Result code (SI473X_OK, SI473X_ERROR_TIMEOUT etc)
+} si47x_trace_entry;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of the tune coalescing (declared by the sketch; see setTuneCoalescing)
+ */
+typedef struct
+{
+    uint16_t target;        //!< Latest frequency waiting to be tuned by tuneTick (0 = none)
+    bool busy;              //!< true from the TUNE_FREQ command queued by tuneTick until its STC
+    uint8_t handle;         //!< Handle of the TUNE_FREQ command in the asynchronous queue
+    unsigned long sentAt;   //!< Time (us) the TUNE_FREQ command was queued
+    unsigned long lastPoll; //!< Last time (us) the STC was checked by tuneTick
+    uint16_t pollInterval;  //!< Current interval (us) between STC checks
+    uint16_t coalesced;     //!< Number of requested frequencies replaced by a newer one before being tuned
+} si47x_tune_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of the encoder step acceleration (declared by the sketch; see setEncoderAcceleration)
+ */
+typedef struct
+{
+    si47x_step_acceleration level[SI473X_STEP_ACCELERATION_SIZE]; //!< Step acceleration table (see setEncoderAccelerationLevel)
+    uint32_t lastTime;                                            //!< Time (ms) of the last encoderTune call
+    int8_t direction;                                             //!< Direction of the last movement (1 = up; -1 = down; 0 = idle)
+    uint16_t rate;                                                //!< Smoothed encoder rate (detents per second)
+    uint16_t step;                                                //!< Step used by the last encoderTune call
+} si47x_encoder_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of a bandscope sweep (declared by the sketch; see startSweep)
+ */
+typedef struct
+{
+    uint8_t state;                 //!< SI473X_SWEEP_IDLE, SI473X_SWEEP_TUNE, SI473X_SWEEP_SETTLE or SI473X_SWEEP_MEASURE
+    si47x_sweep_point *buffer;     //!< Points of the sweep (caller's buffer)
+    uint16_t size;                 //!< Number of points the buffer can hold
+    uint16_t count;                //!< Number of points measured
+    uint16_t frequency;            //!< Frequency of the current point
+    uint16_t to;                   //!< Last frequency of the sweep
+    uint16_t step;                 //!< Step between points
+    uint16_t restore;              //!< Frequency tuned before the sweep
+    uint8_t averaging;             //!< RSQ readings per point
+    uint8_t samples;               //!< RSQ readings done for the current point
+    uint16_t rssiSum;              //!< Sum of the RSSI readings of the current point
+    uint16_t snrSum;               //!< Sum of the SNR readings of the current point
+    uint8_t handle;                //!< Handle of the TUNE_FREQ or RSQ_STATUS command of the current point
+    unsigned long sentAt;          //!< Time (us) the point was tuned (or last sampled)
+    unsigned long lastPoll;        //!< Last time (us) the STC was checked
+    uint16_t pollInterval;         //!< Current interval (us) between STC checks
+    si47x_sweep_callback onPoint;  //!< Function called after each point
+} si47x_sweep_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of a software seek (declared by the sketch; see startSoftSeek)
+ */
+typedef struct
+{
+    si47x_seek_criteria criteria;  //!< Criteria used to accept a channel (see setSoftSeekCriteria; RSSI and SNR 0 = default)
+    si47x_seek_filter filter;      //!< Custom check of the candidates (see setSoftSeekFilter) or NULL
+    uint16_t coarseStep;           //!< Coarse step set by setSoftSeekSteps (0 = default)
+    uint16_t fineStep;             //!< Fine step set by setSoftSeekSteps (0 = current step)
+    uint8_t state;                 //!< SI473X_SOFT_SEEK_IDLE, _TUNE, _SETTLE, _MEASURE or _RDS
+    uint8_t phase;                 //!< SI473X_SOFT_SEEK_COARSE, _REFINE or _VERIFY
+    uint16_t coarse;               //!< Coarse step of the seek
+    uint16_t fine;                 //!< Fine step of the seek
+    bool up;                       //!< Direction of the seek
+    bool wrap;                     //!< Wraps around at the band limit
+    bool wrapped;                  //!< The seek has already wrapped around
+    uint16_t origin;               //!< Frequency tuned when the seek started
+    uint16_t frequency;            //!< Frequency of the current point
+    uint16_t candidate;            //!< Coarse point being refined
+    uint16_t refineTo;             //!< Last point of the refine window
+    uint16_t best;                 //!< Strongest point of the refine window
+    uint8_t bestRssi;              //!< RSSI of the strongest point
+    uint8_t floor;                 //!< Lowest RSSI of the coarse points (noise floor)
+    uint8_t handle;                //!< Handle of the TUNE_FREQ or RSQ_STATUS command of the current point
+    unsigned long sentAt;          //!< Time the point was tuned (us) or the RDS wait started (ms)
+    unsigned long lastPoll;        //!< Last time the STC (us) or the RDS sync (ms) was checked
+    uint16_t pollInterval;         //!< Current interval (us) between STC checks
+    si47x_command_timing *timing;  //!< STC timing of the current point
+    void (*showFunc)(uint16_t f);  //!< Function called with each coarse point
+} si47x_soft_seek_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of a non-blocking hardware seek (declared by the sketch; see startSeek)
+ */
+typedef struct
+{
+    bool active;                  //!< true from startSeek until the end of the seek
+    uint8_t handle;               //!< Handle of the SEEK_START command in the asynchronous queue
+    unsigned long startedAt;      //!< Time (ms) the seek was started
+    unsigned long lastPoll;       //!< Last time (ms) the progress was read
+    void (*showFunc)(uint16_t f); //!< Function called with the frequency being checked
+} si47x_seek_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of a band scan (declared by the sketch; see startAutostore)
+ */
+typedef struct
+{
+    uint8_t state;                  //!< SI473X_AUTOSTORE_IDLE, _TUNE, _SEEK, _RDS or _RESTORE
+    si47x_station *table;           //!< Station list (caller's table)
+    uint8_t size;                   //!< Number of stations the table can hold
+    bool useSoftSeek;               //!< Uses the software seek (SSB and NBFM)
+    uint16_t rdsTime;               //!< Maximum time (ms) to collect the PI and PS of each station
+    uint16_t restore;               //!< Frequency tuned before the scan
+    uint16_t seekBand[3];           //!< Seek bottom, top and spacing before the scan (spacing 0 = unknown)
+    si47x_station station;          //!< Station being collected
+    uint8_t psSegments;             //!< PS segments received (bits 0 to 3)
+    bool rdsMore;                   //!< The RDS FIFO has more groups
+    unsigned long rdsStart;         //!< Time (ms) the RDS collection started
+    unsigned long rdsPoll;          //!< Last time (ms) the RDS FIFO was read
+    si47x_seek_state seek;          //!< Hardware seek of the next station
+    si47x_soft_seek_state softSeek; //!< Software seek of the next station (SSB and NBFM)
+    si47x_tune_state tune;          //!< Non-blocking tunes of the scan when the tune coalescing is off
+} si47x_autostore_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of a priority watch (declared by the sketch; see startPriorityWatch)
+ */
+typedef struct
+{
+    uint8_t rssi;                         //!< Minimum RSSI (dBuV) of the priority channel (see setPriorityCriteria; 0 = default)
+    uint8_t snr;                          //!< Minimum SNR (dB) of the priority channel
+    uint16_t frequency;                   //!< Priority channel
+    uint16_t home;                        //!< Frequency the user was listening to
+    uint16_t period;                      //!< Time (ms) between checks
+    uint8_t state;                        //!< SI473X_PRIORITY_IDLE, _CHECK, _MEASURE or _BACK
+    bool active;                          //!< true while the receiver stays on the priority channel
+    bool muted;                           //!< true if the check muted the audio
+    uint8_t handle;                       //!< Handle of the TUNE_FREQ or RSQ_STATUS command
+    unsigned long lastCheck;              //!< Time (ms) of the last check
+    unsigned long sentAt;                 //!< Time (us) the tune was sent
+    unsigned long lastPoll;               //!< Time (us) of the last STC check
+    uint16_t pollInterval;                //!< Current interval (us) between STC checks
+    unsigned long gapStart;               //!< Time (us) the audio was muted
+    uint32_t gap;                         //!< Audio gap (us) of the last check
+    void (*onSwitch)(uint16_t frequency); //!< Called when the receiver goes to or leaves the priority channel
+} si47x_priority_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of a memory scan and lockout of its list (declared by the sketch; see startScan)
+ */
+typedef struct
+{
+    const si47x_memory_channel *list; //!< Channel list (caller's table)
+    uint8_t size;                     //!< Number of channels of the list
+    uint8_t idx;                      //!< Channel tuned (or being tuned)
+    uint8_t group;                    //!< Mode group being scanned: 0 = FM; 1 = AM; 2 = SSB (LSB and USB)
+    uint8_t state;                    //!< SI473X_SCAN_IDLE, _NEXT, _TUNE, _DWELL or _HANG
+    bool muted;                       //!< true if the scan muted the audio
+    uint8_t homeGroup;                //!< Mode group of the band set when the scan started
+    uint16_t homeBand[3];             //!< Limits and step (minimum, maximum, step) of that band
+    unsigned long stopAt;             //!< Time (ms) the scan stopped on the channel
+    unsigned long lostAt;             //!< Time (ms) the signal was gone
+    unsigned long lastRsq;            //!< Time (ms) of the last RSQ read on the channel
+    unsigned long runStart;           //!< Time (ms) the scan left the last active channel
+    uint32_t time;                    //!< Time (ms) spent tuning and checking channels
+    uint16_t count;                   //!< Channels checked
+    uint8_t switches;                 //!< Mode switches (power ups) done by the scan
+    void (*onStop)(uint8_t idx);      //!< Called when the scan stops on an active channel
+    uint8_t rssi;                     //!< Minimum RSSI (dBuV) of an active channel (see setScanCriteria; 0 = default)
+    uint8_t snr;                      //!< Minimum SNR (dB) of an active channel
+    bool timesSet;                    //!< setScanTimes was called (otherwise no dwell limit and SI473X_SCAN_HANG_TIME)
+    uint16_t dwell;                   //!< Largest time (ms) on an active channel (0 = while active)
+    uint16_t hang;                    //!< Time (ms) the scan waits after the signal is gone
+    si47x_tune_state tune;            //!< Non-blocking tunes of the scan when the tune coalescing is off
+    uint8_t lockout[32];              //!< Channels skipped by the scan (one bit per channel; kept by startScan)
+} si47x_scan_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief Cache of the signal snapshot (declared by the sketch; see setSnapshotCache)
+ */
+typedef struct
+{
+    si47x_signal_snapshot snapshot; //!< Last signal snapshot
+    bool valid;                     //!< false until the first reading (or after invalidateSignalSnapshot)
+    uint8_t mode;                   //!< lastMode when the snapshot was read
+    uint32_t reads;                 //!< Snapshots read from the device
+    uint32_t hits;                  //!< Snapshots served from the cache
+} si47x_snapshot_cache;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of the signal monitor (declared by the sketch; see startSignalMonitor)
+ */
+typedef struct
+{
+    uint8_t rssiWindow;                          //!< Half width (dB) of the RSSI window
+    uint8_t snrWindow;                           //!< Half width (dB) of the SNR window
+    uint8_t rssi;                                //!< RSSI at the center of the window
+    uint8_t snr;                                 //!< SNR at the center of the window
+    uint8_t tune;                                //!< TUNE_FREQ command (mode) the thresholds were programmed for (0 after a power up)
+    bool ienAdded;                               //!< true if the monitor enabled RSQIEN in GPO_IEN
+    unsigned long lastPoll;                      //!< Time (ms) of the last GET_INT_STATUS (polling mode)
+    uint16_t events;                             //!< Signal changes reported since startSignalMonitor
+    void (*onChange)(uint8_t rssi, uint8_t snr); //!< Called with the new RSSI and SNR after each change
+} si47x_signal_monitor_state;
+
+/**
+ * @ingroup group01
+ *
+ * @brief State of the S-meter (declared by the sketch; see startMeter)
+ */
+typedef struct
+{
+    int8_t calibration[4];     //!< Offset (dB) added to the RSSI by mode: FM, AM, SSB and NBFM (see setMeterCalibration)
+    uint8_t shift;             //!< Smoothing of the average: 1/2^shift of each difference (see setMeterSmoothing)
+    uint8_t peakDecay;         //!< Decay (dB/s) of the peak after the hold time (see setMeterPeak)
+    uint16_t peakHold;         //!< Time (ms) the peak is held
+    uint16_t period;           //!< Interval (ms) between two samples taken by meterTick (see setMeterTimes)
+    uint16_t window;           //!< Length (ms) of a statistics window
+    uint8_t mode;              //!< lastMode of the samples (0xFF = no sample yet)
+    uint16_t rssi;             //!< Smoothed RSSI (1/16 dB)
+    uint16_t snr;              //!< Smoothed SNR (1/16 dB)
+    uint8_t peak;              //!< Highest RSSI (dB) since peakAt
+    unsigned long peakAt;      //!< Time (ms) of the peak
+    unsigned long lastSample;  //!< Time (ms) the last sample was due taken by meterTick
+    unsigned long readAt;      //!< Timestamp of the snapshot of the last sample taken by meterTick
+    unsigned long windowStart; //!< Time (ms) the current statistics window was opened
+    uint16_t count;            //!< Samples in the current window
+    uint32_t rssiSum;          //!< Sum of the RSSI samples of the current window
+    uint32_t snrSum;           //!< Sum of the SNR samples of the current window
+    uint8_t rssiMin, rssiMax;  //!< RSSI range of the current window
+    uint8_t snrMin, snrMax;    //!< SNR range of the current window
+    si47x_signal_stats stats;  //!< Last closed window
+} si47x_meter_state;
+
+/**********************************************************************
+ * I2C Transport
+ **********************************************************************/
+
+/**
+ * @ingroup group25 I2C transport
+ *
+ * @brief I2C transport interface used by the SI4735 class
+ *
+ * @details All I2C traffic of the SI4735 class (commands, responses, patches and EEPROM) goes through this interface.
+ * @details Implement it if you want to use a different I2C driver (DMA, queued transfers, a host simulator etc) and
+ *          pass it to SI4735::setTransport. The default one (SI4735WireTransport) uses the Arduino TwoWire class.
+ * @details The write function returns 0 on success (the same codes of TwoWire::endTransmission). The read
+ *          function returns the number of bytes read.
+ * @details The SI4735 class never owns nor deletes the transport. So, the destructor is protected and not virtual: a
+ *          transport cannot be deleted through a SI4735Transport pointer, and no virtual destructor (with its operator
+ *          delete) is linked on small MCUs.
+ */
+class SI4735Transport
+{
+protected:
+    ~SI4735Transport() {}
+
+public:
+    virtual void begin() = 0;
+    virtual void setClock(uint32_t frequency) = 0;
+    virtual uint8_t write(uint8_t address, const uint8_t *data, uint8_t size) = 0;
+    virtual uint8_t read(uint8_t address, uint8_t *data, uint8_t size) = 0;
+
+    /**
+     * @brief Writes and then reads the device.
+     * @details The default implementation is a write followed by a read. Override it if your driver can do it better.
+     */
+    virtual uint8_t writeRead(uint8_t address, const uint8_t *data, uint8_t size, uint8_t *response, uint8_t responseSize)
+    {
+        uint8_t error = write(address, data, size);
+        if (error != 0)
+            return error;
+        return (read(address, response, responseSize) == responseSize) ? 0 : 4; // 4 = other error (see TwoWire::endTransmission)
+    };
+};
+
+/**
+ * @ingroup group25 I2C transport
+ *
+ * @brief Default I2C transport (Arduino TwoWire)
+ *
+ * @details The SI4735 class calls this transport without virtual dispatch when no other transport is set. Without
+ *          SI473X_TRANSPORT (AVR default), the SI4735 class has no transport object and calls the static functions
+ *          below on Wire: the same Wire calls used before the transport existed.
+ */
+class SI4735WireTransport : public SI4735Transport
+{
+public:
+    TwoWire *wire = &Wire; //!< I2C bus used (Wire, Wire1 etc)
+
+    inline void begin() { wire->begin(); };
+    inline void setClock(uint32_t frequency) { wire->setClock(frequency); };
+    inline uint8_t write(uint8_t address, const uint8_t *data, uint8_t size) { return writeBus(wire, address, data, size); };
+    inline uint8_t read(uint8_t address, uint8_t *data, uint8_t size) { return readBus(wire, address, data, size); };
+    inline uint8_t writeRead(uint8_t address, const uint8_t *data, uint8_t size, uint8_t *response, uint8_t responseSize)
+    {
+        return writeReadBus(wire, address, data, size, response, responseSize);
+    };
+
+    static inline uint8_t writeBus(TwoWire *wire, uint8_t address, const uint8_t *data, uint8_t size)
+    {
+        wire->beginTransmission(address);
+        if (size > 0)
+            wire->write(data, size);
+        return wire->endTransmission();
+    };
+
+    static inline uint8_t readBus(TwoWire *wire, uint8_t address, uint8_t *data, uint8_t size)
+    {
+        uint8_t n = wire->requestFrom(address, size);
+        for (uint8_t i = 0; i < size; i++)
+            data[i] = wire->read();
+        return n;
+    };
+
+    /**
+     * @brief Writes and then reads the device with a repeated start (no STOP between the write and the read).
+     */
+    static inline uint8_t writeReadBus(TwoWire *wire, uint8_t address, const uint8_t *data, uint8_t size, uint8_t *response, uint8_t responseSize)
+    {
+        uint8_t error;
+
+        wire->beginTransmission(address);
+        wire->write(data, size);
+        error = wire->endTransmission(false); // Repeated start
+        if (error != 0)
+            return error;
+        return (readBus(wire, address, response, responseSize) == responseSize) ? 0 : 4;
+    };
+};
+
 /**********************************************************************
  * SI4735 Class definition
  **********************************************************************/
@@ -1079,6 +1937,89 @@ protected:
 
     int16_t deviceAddress = SI473X_ADDR_SEN_LOW; //!<  Stores the current I2C bus address.
 
+#ifdef SI473X_TRANSPORT
+    SI4735WireTransport wireTransport;          //!< Default I2C transport (Wire)
+    SI4735Transport *transport = &wireTransport; //!< I2C transport in use (see setTransport)
+#endif
+
+    /**
+     * @ingroup group25 I2C transport
+     * @brief Starts the I2C bus of the current transport.
+     */
+    inline void i2cBegin()
+    {
+#ifdef SI473X_TRANSPORT
+        transport->begin();
+#else
+        Wire.begin();
+#endif
+    };
+
+    /**
+     * @ingroup group25 I2C transport
+     * @brief Writes to a device on the I2C bus through the current transport.
+     * @return 0 on success
+     */
+    inline uint8_t i2cWrite(uint8_t address, const uint8_t *data, uint8_t size)
+    {
+        uint8_t result;
+        SI473X_TRACE_HOOK(uint32_t start = (traceBuffer != NULL) ? micros() : 0;)
+#ifdef SI473X_TRANSPORT
+        if (transport != &wireTransport)
+            result = transport->write(address, data, size);
+        else
+            result = wireTransport.SI4735WireTransport::write(address, data, size);
+#else
+        result = SI4735WireTransport::writeBus(&Wire, address, data, size);
+#endif
+        deviceReady = false; // A command (or patch line) may be running now
+        SI473X_TRACE_HOOK(if (traceBuffer != NULL) traceTransfer(data, size, 0, start, result);)
+        return result;
+    };
+
+    /**
+     * @ingroup group25 I2C transport
+     * @brief Reads from a device on the I2C bus through the current transport.
+     * @return number of bytes read
+     */
+    inline uint8_t i2cRead(uint8_t address, uint8_t *data, uint8_t size)
+    {
+        uint8_t result;
+        SI473X_TRACE_HOOK(uint32_t start = (traceBuffer != NULL) ? micros() : 0;)
+#ifdef SI473X_TRANSPORT
+        if (transport != &wireTransport)
+            result = transport->read(address, data, size);
+        else
+            result = wireTransport.SI4735WireTransport::read(address, data, size);
+#else
+        result = SI4735WireTransport::readBus(&Wire, address, data, size);
+#endif
+        SI473X_TRACE_HOOK(if (traceBuffer != NULL) traceTransfer(NULL, 0, result, start, (result == size) ? 0 : 4);)
+        return result;
+    };
+
+    /**
+     * @ingroup group25 I2C transport
+     * @brief Writes and then reads a device on the I2C bus through the current transport.
+     * @return 0 on success
+     */
+    inline uint8_t i2cWriteRead(uint8_t address, const uint8_t *data, uint8_t size, uint8_t *response, uint8_t responseSize)
+    {
+        uint8_t result;
+        SI473X_TRACE_HOOK(uint32_t start = (traceBuffer != NULL) ? micros() : 0;)
+#ifdef SI473X_TRANSPORT
+        if (transport != &wireTransport)
+            result = transport->writeRead(address, data, size, response, responseSize);
+        else
+            result = wireTransport.SI4735WireTransport::writeRead(address, data, size, response, responseSize);
+#else
+        result = SI4735WireTransport::writeReadBus(&Wire, address, data, size, response, responseSize);
+#endif
+        deviceReady = false;
+        SI473X_TRACE_HOOK(if (traceBuffer != NULL) traceTransfer(data, size, responseSize, start, result);)
+        return result;
+    };
+
     // Delays
     uint16_t maxDelaySetFrequency = MAX_DELAY_AFTER_SET_FREQUENCY; //!< Stores the maximum delay after set frequency command (in ms).
     uint16_t maxDelayAfterPouwerUp = MAX_DELAY_AFTER_POWERUP;      //!< Stores the maximum delay you have to setup after a power up command (in ms).
@@ -1122,9 +2063,51 @@ protected:
     uint8_t currentAudioMode = SI473X_ANALOG_AUDIO; //!< Current audio mode used (ANALOG or DIGITAL or both)
     uint8_t currentSsbStatus;
     int8_t audioMuteMcuPin = -1;
+    bool audioMuted = false;    //!< RX_HARD_MUTE set by setAudioMute (the power up clears it)
+    bool hardwareMuted = false; //!< External mute circuit state set by setHardwareAudioMute
+
+    int8_t interruptPin = -1;                         //!< MCU pin connected to the GPO2/INT pin (-1 = polling mode)
+    uint16_t interruptSources = 0;                    //!< GPO_IEN property value used in interrupt mode
+    uint8_t interruptEdgesSeen = 0;                   //!< Number of INT pulses already processed
+    si47x_status interruptFlags;                      //!< Interrupt bits latched since the last clearInterruptFlags
+    si47x_status interruptStatus;                     //!< Status byte read by the last checkInterrupt
+    bool deviceReady = false;                         //!< true if the last status byte read had the CTS and nothing was written since
+    si47x_interrupt_callback onInterrupt = NULL;      //!< Function called when an interrupt is processed
+    static volatile uint8_t interruptEdges;           //!< Number of INT pulses counted by the ISR (shared: one receiver in interrupt mode)
 
-    void waitInterrupr(void);
     si47x_status getInterruptStatus();
+    si47x_status readStatus();
+    void latchInterrupt(si47x_status status);
+    void prepareSeekTune(uint8_t cmd);
+    bool pollSeekTuneComplete(si47x_command_timing *timing, unsigned long sentAt, unsigned long &lastPoll, uint16_t &pollInterval, bool tuneStatus = true);
+    void acknowledgeSeekTune();
+
+    /**
+     * @ingroup group24 Command timing
+     * @brief Returns true if the command is a tune or seek command (its timing refers to the STC).
+     */
+    inline bool isSeekTuneCommand(uint8_t cmd)
+    {
+        return cmd == FM_TUNE_FREQ || cmd == AM_TUNE_FREQ || cmd == NBFM_TUNE_FREQ || cmd == FM_SEEK_START || cmd == AM_SEEK_START;
+    };
+
+    /**
+     * @ingroup group05 Interrupt
+     * @brief Returns true if the library can wait for the STC interrupt (interrupt mode with STCIEN set).
+     */
+    inline bool useStcInterrupt() { return interruptPin >= 0 && (interruptSources & 0x0001); };
+
+    /**
+     * @ingroup group21 Asynchronous command engine
+     * @brief Returns true if the sketch set a command queue (see setCommandQueue). Otherwise sets SI473X_ERROR_QUEUE_FULL.
+     */
+    inline bool hasCommandQueue()
+    {
+        if (asyncQueueSize != 0)
+            return true;
+        lastError = SI473X_ERROR_QUEUE_FULL;
+        return false;
+    };
 
     // void setGpioCtl(uint8_t GPO1OEN, uint8_t GPO2OEN, uint8_t GPO3OEN);
     // void setGpio(uint8_t GPO1LEVEL, uint8_t GPO2LEVEL, uint8_t GPO3LEVEL);
@@ -1132,7 +2115,198 @@ protected:
 
     void sendProperty(uint16_t propertyNumber, uint16_t param);
 
+    si47x_async_command *asyncQueue = NULL;       //!< Asynchronous command queue (circular buffer; see setCommandQueue)
+    uint8_t asyncQueueSize = 0;                   //!< Number of commands the queue can hold
+    uint8_t asyncHead = 0;                        //!< Position of the oldest command in the queue
+    uint8_t asyncCount = 0;                       //!< Number of commands in the queue
+    uint8_t asyncLastHandle = 0;                  //!< Last handle given to a command
+    unsigned long asyncLastProbe = 0;             //!< Last time (us) the CTS was checked by the engine
+    si47x_status asyncLastStatus;                 //!< Status of the last command completed by the engine
+    unsigned long asyncSentAt = 0;                //!< Time (us) the running command was sent
+    uint16_t asyncPollInterval = 0;               //!< Current interval (us) between CTS checks
+    si47x_command_timing *asyncTiming = NULL;     //!< Timing of the running command
+
+    si47x_command_timing *commandTiming;         //!< Command timing table: library-wide or the caller's (see setCommandTimingTable)
+    bool commandTimingAutoTune = false;          //!< If true, the expected times follow the measured ones
+    si47x_command_timing *seekTuneTiming = NULL; //!< Timing of the last tune or seek command
+
+    si47x_tune_state *tuneState = NULL; //!< Tune coalescing state (caller's) or NULL: frequencyUp and frequencyDown are blocking
+
+    si47x_sweep_state *sweepState = NULL; //!< Sweep in progress or last sweep (caller's state) or NULL
+    si47x_command_timing sweepTiming; //!< STC timing of the FAST tunes
+
+    void finishSweepPoint();
+
+    si47x_soft_seek_state *softSeekState = NULL;              //!< Software seek in progress (caller's state) or NULL
+    bool softSeekFound = false;                                //!< Result of the last software seek
+    uint16_t softSeekTunes = 0;                                //!< Tunes done by the current (or last) seek
+
+    uint8_t sendTuneAsync(uint16_t freq, uint8_t fast);
+    uint8_t sendRsqAsync();
+    void checkSoftSeekPoint(uint8_t rssi);
+    void acceptSoftSeekCandidate(bool accepted);
+    void nextSoftSeekPoint(uint16_t from);
+    void finishSoftSeek(uint16_t freq);
+
+    si47x_autostore_state *autostoreState = NULL; //!< Band scan in progress (caller's state) or NULL
+    uint8_t autostoreCount = 0;                   //!< Number of stations stored by the current (or last) scan
+
+    void collectAutostoreStation();
+    void readAutostoreRds();
+    void addAutostoreStation();
+    void nextAutostoreSeek();
+
+    si47x_antcap_segment *antcapTable = NULL; //!< Antenna capacitor table (caller's table) or NULL
+    uint8_t antcapTableSize = 0;              //!< Number of segments of the table
+    uint8_t antcapTableTune = 0;              //!< TUNE_FREQ command (band) the table was built for
+
+    void setAntennaCapacitorArguments(uint16_t capacitor);
+    uint16_t measureAntennaCapacitor(uint16_t freq, uint16_t capacitor);
+
+    const si47x_band *bandPlan = NULL;        //!< Band plan (flash) or NULL
+    uint8_t bandPlanSize = 0;                 //!< Number of bands of the plan
+    uint8_t currentBandIdx = SI473X_BAND_NONE; //!< Band selected by setBand (SI473X_BAND_NONE after setAM, setFM etc)
+
+    /**
+     * @ingroup group35 Band plan
+     * @brief Search key of a band plan: the AM and SSB bands come first, then the FM bands, by frequency.
+     */
+    static constexpr uint32_t bandKey(uint8_t mode, uint16_t frequency)
+    {
+        return ((uint32_t)(mode == SI473X_BAND_FM) << 16) | frequency;
+    }
+
+    // Index 0 = FM (FM_CURRENT_MODE), 1 = AM (AM_CURRENT_MODE) and 2 = SSB (SSB_CURRENT_MODE)
+    si47x_property_cache_entry *modeState = NULL; //!< Last values of the FM (0x1xxx), AM and SSB (0x3xxx) properties (caller's array) or NULL
+    uint8_t modeStateSize = 0;                    //!< Number of properties the array can hold (all modes)
+    uint8_t modeStateCount = 0;                   //!< Number of properties kept (all modes)
+    bool poweredUp = false;                                           //!< true between radioPowerUp and powerDown (or reset)
+    uint32_t modeSwitchTime = 0;                                      //!< Time (us) spent by the last setFM / setAM
+
+    void saveModeProperty(uint16_t propertyNumber, uint16_t value);
+    void restoreModeState(uint8_t mode);
+
+    /**
+     * @ingroup group36 Mode switch
+     * @brief Mode (FM_CURRENT_MODE, AM_CURRENT_MODE or SSB_CURRENT_MODE) of a property kept in modeState.
+     */
+    static inline uint8_t modeOfState(uint16_t property)
+    {
+        return ((property >> 12) == 0x1) ? FM_CURRENT_MODE : (property & SI473X_MODE_STATE_SSB) ? SSB_CURRENT_MODE : AM_CURRENT_MODE;
+    }
+
+    int16_t bfoOffset = 0;                  //!< SSB: received frequency minus the carrier (Hz); the SSB_BFO property is -bfoOffset
+    uint16_t bfoWindow = SI473X_BFO_WINDOW; //!< Largest |bfoOffset| used by setFrequencyHz
+
+    si47x_priority_state *priorityState = NULL; //!< Priority watch in progress (caller's state) or NULL
+
+    void sendPriorityTune(uint16_t frequency, uint8_t state);
+    void finishPriorityCheck(bool switched);
+
+    si47x_scan_state *scanState = NULL; //!< Memory scan (caller's state) or NULL
+    void (*scanSsbLoader)() = NULL;     //!< Loads the SSB patch (see setScanSsbLoader)
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Mode group of a channel: 0 = FM; 1 = AM; 2 = SSB (LSB and USB share the patched AM power up).
+     */
+    static constexpr uint8_t scanGroupOf(uint8_t mode) { return (mode > SI473X_BAND_LSB) ? SI473X_BAND_LSB : mode; }
+
+    bool nextScanChannel();
+    void switchScanMode(const si47x_memory_channel *channel);
+    void setScanBand(const si47x_memory_channel *channel);
+    void setScanMute(bool value);
+
+    si47x_snapshot_cache *snapshotCache = NULL;     //!< Cache of the signal snapshot (caller's struct) or NULL
+    uint16_t snapshotTtl = SI473X_SNAPSHOT_TTL;     //!< Age (ms) of a snapshot still served from the cache
+
+    bool readSignalSnapshot(si47x_signal_snapshot *snapshot);
+
+    si47x_signal_monitor_state *rsqState = NULL; //!< Signal monitor (caller's state) or NULL
+
+    uint16_t rsqProperty(uint8_t offset);
+    void armSignalMonitor();
+    void centerRsqWindow();
+
+    si47x_meter_state *meterState = NULL;               //!< S-meter (caller's state) or NULL
+
+    uint16_t smoothMeter(uint16_t average, uint8_t sample);
+    void openMeterWindow(unsigned long now);
+
+    si47x_encoder_state *encoderState = NULL; //!< Step acceleration state (caller's) or NULL: encoderTune always uses currentStep
+
+    si47x_seek_state *seekState = NULL; //!< Non-blocking seek in progress (caller's state) or NULL
+
+    uint8_t setSeekArguments(uint8_t SEEKUP, uint8_t WRAP, uint8_t *arg);
+    void finishSeek(uint8_t cancel);
+    void showSeekFrequency();
+
+    void setTuneArguments(uint16_t freq);
+    void startTune();
+
+    /**
+     * @ingroup group28 Tune coalescing
+     * @brief Drops the coalesced tune waiting and finishes the one in progress (its STC is waited for and acknowledged by
+     *        tuneTick). Used by the blocking tune, seek and power down functions, so their commands never overlap it.
+     */
+    inline void cancelTune()
+    {
+        if (tuneState == NULL)
+            return;
+        tuneState->target = 0;
+        while (tuneState->busy)
+            tuneTick();
+    };
+
+    bool combinedWriteRead = true;               //!< If true, fast queries use a repeated start write-then-read transaction
+    uint16_t busTurnaround = 100;                //!< Time (µs) from the end of a write to the status byte of a repeated start read (about 10 bit times)
+
+    uint8_t lastError = SI473X_OK;            //!< Result code of the last command (or wait)
+    uint8_t retryBudget = SI473X_RETRY_BUDGET; //!< Maximum number of retries when the device answers with ERR
+    si47x_error_stats *errorStats = NULL;     //!< Error counters and latency measurements (caller's struct) or NULL
+
+#ifdef SI473X_TRACE
+    si47x_trace_entry *traceBuffer = NULL; //!< Tracer ring buffer (caller's array) or NULL (tracer off)
+    uint8_t traceSize = 0;                 //!< Number of entries of the tracer ring buffer
+    uint8_t traceNext = 0;                 //!< Position of the next entry to be written
+    uint8_t traceCount = 0;                //!< Number of valid entries
+    bool traceOpen = false;                //!< true while the command engine traces a command (in traceBuffer[traceNext])
+
+    void traceBegin(si47x_async_command *c);
+    void traceEnd(uint8_t result);
+    void traceTransfer(const uint8_t *data, uint8_t written, uint8_t read, uint32_t start, uint8_t error);
+    si47x_trace_entry *traceAppend();
+#endif
+
+    void finishCommand(si47x_status status, uint8_t result);
+    bool lendCommandSlot(si47x_async_command *slot);
+    void returnCommandSlot();
+    void setError(uint8_t result, uint8_t cmd);
+    bool retryCommand(uint8_t &retry);
+    si47x_command_timing *findCommandTiming(uint8_t cmd);
+    void updateCommandTiming(si47x_command_timing *timing, uint32_t measured);
+
+    si47x_property_cache_entry *propertyCache = NULL; //!< Shadow of the properties written by the library (caller's array) or NULL
+    uint8_t propertyCacheSize = 0;                    //!< Number of properties the cache can hold (0 = sendProperty and getProperty always use the I2C bus)
+    uint8_t propertyCacheCount = 0;                   //!< Number of valid entries in the property cache
+    uint8_t propertyCacheNext = 0;                    //!< Next entry to be replaced when the cache is full
+    uint32_t propertyCacheHits = 0;                   //!< Number of property accesses answered by the cache
+    uint32_t propertyCacheMisses = 0;                 //!< Number of property accesses that used the I2C bus
+
+    si47x_property_batch_entry *propertyBatch = NULL; //!< Property writes waiting for commitProperties (caller's array) or NULL
+    uint8_t propertyBatchSize = 0;                    //!< Number of distinct properties the batch can hold (0 = no batch)
+    uint8_t propertyBatchCount = 0;                   //!< Number of properties in the batch
+    bool propertyBatchActive = false;                 //!< true between beginProperties and commitProperties
+    uint32_t propertyCommitTime = 0;                                      //!< Time (us) spent by the last commitProperties
+
+    int8_t findCachedProperty(uint16_t propertyNumber);
+    void cacheProperty(uint16_t propertyNumber, uint16_t value);
+    void dropCachedProperty(uint16_t propertyNumber);
+
+    si47x_status runCommand(uint8_t cmd, uint8_t parameter_size, const uint8_t *parameter, uint8_t response_size = 0, uint8_t *response = NULL);
+
     void sendSSBModeProperty();
+    void sendPatchPowerUp(uint8_t PATCH, uint8_t FUNC);
     void disableFmDebug();
     /**
      * @ingroup group16 RDS setup
@@ -1179,18 +2353,187 @@ public:
     SI4735();
     void reset(void);
     void waitToSend(void);
+    bool isClearToSend(void);
+
+    void setInterruptPin(int8_t pin, uint8_t STCIEN = 1, uint8_t RSQIEN = 0, uint8_t RDSIEN = 0, uint8_t CTSIEN = 1);
+    static void interruptHandler(void);
+    bool checkInterrupt(void);
+    void waitInterrupr(void);
+    bool waitSeekTuneComplete(uint16_t timeout = 0);
+
+    /**
+     * @ingroup group05 Interrupt
+     * @brief Returns true if the library is using the GPO2/INT pin (see setInterruptPin).
+     */
+    inline bool isInterruptMode() { return interruptPin >= 0; };
+
+    /**
+     * @ingroup group05 Interrupt
+     * @brief Returns the interrupt bits (STCINT, RDSINT, RSQINT and ERR) latched since the last clearInterruptFlags.
+     * @see checkInterrupt, clearInterruptFlags
+     */
+    inline si47x_status getInterruptFlags() { return interruptFlags; };
+
+    /**
+     * @ingroup group05 Interrupt
+     * @brief Clears the interrupt bits latched by the library. It does not acknowledge the interrupts on the device.
+     */
+    inline void clearInterruptFlags() { interruptFlags.raw = 0; };
+
+    /**
+     * @ingroup group05 Interrupt
+     * @brief Sets a function to be called when an interrupt is processed (see si47x_interrupt_callback).
+     * @param callback function or NULL to disable it.
+     */
+    inline void setInterruptCallback(si47x_interrupt_callback callback) { onInterrupt = callback; };
 
     void setGpioCtl(uint8_t GPO1OEN, uint8_t GPO2OEN, uint8_t GPO3OEN);
     void setGpio(uint8_t GPO1LEVEL, uint8_t GPO2LEVEL, uint8_t GPO3LEVEL);
     void setGpioIen(uint8_t STCIEN, uint8_t RSQIEN, uint8_t ERRIEN, uint8_t CTSIEN, uint8_t STCREP, uint8_t RSQREP);
 
-    void setup(uint8_t resetPin, uint8_t defaultFunction);
-    void setup(uint8_t resetPin, uint8_t ctsIntEnable, uint8_t defaultFunction, uint8_t audioMode = SI473X_ANALOG_AUDIO, uint8_t clockType = XOSCEN_CRYSTAL, uint8_t gpo2Enable = 0);
+    void setup(uint8_t resetPin, uint8_t defaultFunction);
+    void setup(uint8_t resetPin, uint8_t ctsIntEnable, uint8_t defaultFunction, uint8_t audioMode = SI473X_ANALOG_AUDIO, uint8_t clockType = XOSCEN_CRYSTAL, uint8_t gpo2Enable = 0);
+
+    void setRefClock(uint16_t refclk);
+    void setRefClockPrescaler(uint16_t prescale, uint8_t rclk_sel = 0);
+
+    int32_t getProperty(uint16_t propertyValue);
+
+    void invalidatePropertyCache();
+
+    void setCommandTimingTable(si47x_command_timing *table);
+    void setCommandTiming(uint8_t cmd, uint16_t expected, uint16_t pollInterval, uint16_t timeout);
+    si47x_command_timing getCommandTiming(uint8_t cmd);
+
+    /**
+     * @ingroup group24 Command timing
+     * @brief Enables or disables the automatic adjustment of the expected completion times.
+     * @details When enabled, the expected time of each command follows the measured completion times,
+     *          so the first CTS (or STC) check happens close to the real completion time of your device.
+     * @param enabled true or false
+     */
+    inline void setCommandTimingAutoTune(bool enabled) { commandTimingAutoTune = enabled; };
+
+    /**
+     * @ingroup group21 Asynchronous command engine
+     * @brief Enables or disables the combined write-then-read (repeated start) transaction for fast queries.
+     * @details When enabled (default), commands with response whose expected (measured, see setCommandTimingAutoTune)
+     *          completion time fits in the bus turnaround time (the repeated start and the address byte: about 100 µs at 100 kHz)
+     *          are sent and read in a single I2C transaction. Commands that need longer are written first and read after their
+     *          expected time, so the response read does not end up as just a CTS probe.
+     * @details Disable it if your I2C driver does not support repeated start.
+     * @param enabled true or false
+     */
+    inline void setCombinedWriteRead(bool enabled) { combinedWriteRead = enabled; };
+
+    /**
+     * @ingroup group26 Error handling
+     * @brief Returns the result code of the last command or wait (SI473X_OK, SI473X_ERROR_TIMEOUT, SI473X_ERROR_DEVICE etc).
+     */
+    inline uint8_t getLastError() { return lastError; };
+
+    void setErrorStats(si47x_error_stats *stats);
+    si47x_error_stats getErrorStats();
+
+    /**
+     * @ingroup group26 Error handling
+     * @brief Clears the error counters and the latency measurements (see setErrorStats).
+     */
+    inline void resetErrorStats()
+    {
+        if (errorStats != NULL)
+            memset(errorStats, 0, sizeof(si47x_error_stats));
+    };
+
+    /**
+     * @ingroup group26 Error handling
+     * @brief Sets the maximum number of retries when the device answers with ERR (getStatus, getRdsStatus, getFirmware etc).
+     * @param retries number of retries (0 = no retry). Default SI473X_RETRY_BUDGET.
+     */
+    inline void setRetryBudget(uint8_t retries) { retryBudget = retries; };
+
+    void setTraceBuffer(si47x_trace_entry *buffer, uint8_t size);
+#ifdef SI473X_TRACE
+    /**
+     * @ingroup group27 I2C tracer
+     * @brief Returns the number of entries kept by the tracer (0 if the tracer is off).
+     */
+    inline uint8_t getTraceCount() { return traceCount; };
+
+    si47x_trace_entry getTraceEntry(uint8_t index);
+    void clearTrace();
+    void dumpTrace(Print &out);
+#else
+    inline uint8_t getTraceCount() { return 0; };
+#endif
+
+    void beginProperties();
+    uint32_t commitProperties();
+
+    /**
+     * @ingroup group23 Property batch
+     * @brief Returns true if the property writes are being batched (between beginProperties and commitProperties).
+     */
+    inline bool isPropertyBatchActive() { return propertyBatchActive; };
+
+    /**
+     * @ingroup group23 Property batch
+     * @brief Returns the number of properties waiting for commitProperties.
+     */
+    inline uint8_t getPendingProperties() { return propertyBatchCount; };
+
+    /**
+     * @ingroup group23 Property batch
+     * @brief Returns the time (in microseconds) spent by the last commitProperties.
+     */
+    inline uint32_t getPropertyCommitTime() { return propertyCommitTime; };
+
+    /**
+     * @ingroup group23 Property batch
+     * @brief Sets the array that holds the property batch (see Property batch) or disables the batch.
+     * @details Without an array (the default), beginProperties does nothing and every property is sent at once.
+     * @param batch array of entries (it has to be valid while it is in use) or NULL (no batch)
+     * @param size number of distinct properties the batch can hold (20 holds a full mode setup)
+     */
+    inline void setPropertyBatch(si47x_property_batch_entry *batch, uint8_t size)
+    {
+        if (propertyBatchActive)
+            commitProperties();
+        propertyBatch = batch;
+        propertyBatchSize = (batch != NULL) ? size : 0;
+    };
+
+    /**
+     * @ingroup group22 Property cache
+     * @brief Sets the array used as property shadow cache (see Property cache) or disables the cache.
+     * @details Without cache (the default), every sendProperty and getProperty uses the I2C bus. The cache is cleared.
+     * @param cache array of entries (it has to be valid while it is in use) or NULL (no cache)
+     * @param size number of entries of the array (16 holds the properties of a typical receiver)
+     */
+    inline void setPropertyCache(si47x_property_cache_entry *cache, uint8_t size)
+    {
+        propertyCache = cache;
+        propertyCacheSize = (cache != NULL) ? size : 0;
+        invalidatePropertyCache();
+    };
 
-    void setRefClock(uint16_t refclk);
-    void setRefClockPrescaler(uint16_t prescale, uint8_t rclk_sel = 0);
+    /**
+     * @ingroup group22 Property cache
+     * @brief Returns the number of property writes skipped and property reads answered by the cache.
+     */
+    inline uint32_t getPropertyCacheHits() { return propertyCacheHits; };
 
-    int32_t getProperty(uint16_t propertyValue);
+    /**
+     * @ingroup group22 Property cache
+     * @brief Returns the number of property writes and reads that needed the I2C bus.
+     */
+    inline uint32_t getPropertyCacheMisses() { return propertyCacheMisses; };
+
+    /**
+     * @ingroup group22 Property cache
+     * @brief Resets the hit and miss counters of the property cache.
+     */
+    inline void resetPropertyCacheStats() { propertyCacheHits = propertyCacheMisses = 0; };
 
     /**
      * @ingroup group10 Generic set and get property
@@ -1215,6 +2558,35 @@ public:
     void getCommandResponse(int num_of_bytes, uint8_t *response);
     si47x_status getStatusResponse();
 
+    uint8_t sendCommandAsync(uint8_t cmd, uint8_t parameter_size, const uint8_t *parameter, uint8_t response_size = 0, uint8_t *response = NULL, si47x_command_callback onDone = NULL);
+    bool commandTick();
+    bool isCommandDone(uint8_t handle);
+    void waitCommand(uint8_t handle);
+    void flushCommands();
+    void setCommandQueue(si47x_async_command *queue, uint8_t size);
+
+    /**
+     * @ingroup group21 Asynchronous command engine
+     * @brief Returns the number of commands the asynchronous queue can hold (see setCommandQueue).
+     */
+    inline uint8_t getCommandQueueSize() { return asyncQueueSize; };
+
+    /**
+     * @ingroup group21 Asynchronous command engine
+     * @brief Returns the number of commands waiting in the asynchronous queue (including the running one).
+     * @see sendCommandAsync, commandTick
+     * @return uint8_t number of commands
+     */
+    inline uint8_t getPendingCommands() { return asyncCount; };
+
+    /**
+     * @ingroup group21 Asynchronous command engine
+     * @brief Returns the status byte (RESP0) of the last command completed by the asynchronous engine.
+     * @see sendCommandAsync, commandTick
+     * @return si47x_status
+     */
+    inline si47x_status getLastCommandStatus() { return asyncLastStatus; };
+
     void setPowerUp(uint8_t CTSIEN, uint8_t GPO2OEN, uint8_t PATCH, uint8_t XOSCEN, uint8_t FUNC, uint8_t OPMODE);
     void radioPowerUp(void);
     void analogPowerUp(void);
@@ -1222,6 +2594,80 @@ public:
 
     void setFrequency(uint16_t);
 
+    void requestFrequency(uint16_t freq);
+    bool tuneTick();
+    void flushTune();
+
+    void setTuneCoalescing(si47x_tune_state *state);
+
+    /**
+     * @ingroup group28 Tune coalescing
+     * @brief Returns true while a frequency requested by requestFrequency is waiting or being tuned.
+     */
+    inline bool isTuning() { return tuneState != NULL && (tuneState->busy || tuneState->target != 0); };
+
+    /**
+     * @ingroup group28 Tune coalescing
+     * @brief Returns the number of requested frequencies skipped because a newer one arrived before the device was ready.
+     */
+    inline uint16_t getCoalescedTunes() { return (tuneState != NULL) ? tuneState->coalesced : 0; };
+
+    uint16_t encoderTune(int16_t delta, uint32_t timestamp);
+    void setEncoderAccelerationLevel(uint8_t level, uint16_t rate, uint8_t multiplier);
+
+    /**
+     * @ingroup group29 Encoder tuning
+     * @brief Same as encoderTune(delta, millis()).
+     * @param delta detents moved since the last call (positive = up; negative = down)
+     * @return uint16_t the new frequency
+     */
+    inline uint16_t encoderTune(int16_t delta) { return encoderTune(delta, millis()); };
+
+    void setEncoderAcceleration(si47x_encoder_state *state);
+
+    /**
+     * @ingroup group29 Encoder tuning
+     * @brief Returns the smoothed encoder rate (detents per second) measured by encoderTune (0 without acceleration).
+     */
+    inline uint16_t getEncoderRate() { return (encoderState != NULL) ? encoderState->rate : 0; };
+
+    /**
+     * @ingroup group29 Encoder tuning
+     * @brief Returns the step (currentStep * multiplier) used by the last encoderTune call.
+     */
+    inline uint16_t getEncoderStep() { return (encoderState != NULL) ? encoderState->step : currentStep; };
+
+    bool startSweep(si47x_sweep_state *state, uint16_t from, uint16_t to, uint16_t step, si47x_sweep_point *buffer, uint16_t size, uint8_t averaging = 1, si47x_sweep_callback onPoint = NULL);
+    bool sweepTick();
+    void stopSweep();
+    uint16_t sweep(uint16_t from, uint16_t to, uint16_t step, si47x_sweep_point *buffer, uint16_t size, uint8_t averaging = 1, si47x_sweep_callback onPoint = NULL);
+
+    /**
+     * @ingroup group30 Bandscope sweep
+     * @brief Returns true while a sweep is in progress (see startSweep).
+     */
+    inline bool isSweeping() { return sweepState != NULL && sweepState->state != SI473X_SWEEP_IDLE; };
+
+    /**
+     * @ingroup group30 Bandscope sweep
+     * @brief Returns the number of points measured by the current (or last) sweep.
+     */
+    inline uint16_t getSweepCount() { return (sweepState != NULL) ? sweepState->count : 0; };
+
+    /**
+     * @ingroup group30 Bandscope sweep
+     * @brief Sets the STC timing of the FAST tunes used by the sweep (default SI473X_TIMING_SWEEP, see SI4735.cpp).
+     * @param expected expected STC time (us)
+     * @param pollInterval interval between STC checks (us)
+     * @param timeout maximum time (ms) per point
+     */
+    inline void setSweepTiming(uint16_t expected, uint16_t pollInterval, uint16_t timeout)
+    {
+        sweepTiming.expected = expected;
+        sweepTiming.pollInterval = pollInterval;
+        sweepTiming.timeout = timeout;
+    };
+
     void getStatus(uint8_t, uint8_t);
 
     uint16_t getFrequency(void);
@@ -2334,6 +3780,450 @@ public:
     void seekStationProgress(void (*showFunc)(uint16_t f), uint8_t up_down);
     void seekStationProgress(void (*showFunc)(uint16_t f), bool (*stopSeking)(), uint8_t up_down);
 
+    bool startSeek(si47x_seek_state *state, uint8_t up_down, uint8_t wrap = 1, void (*showFunc)(uint16_t f) = NULL);
+    bool seekTick();
+    void cancelSeek();
+
+    /**
+     * @ingroup group31 Non-blocking seek
+     * @brief Returns true while a seek started by startSeek is in progress.
+     */
+    inline bool isSeeking() { return seekState != NULL && seekState->active; };
+
+    bool startSoftSeek(si47x_soft_seek_state *state, uint8_t up_down, uint8_t wrap = 1, void (*showFunc)(uint16_t f) = NULL);
+    bool softSeekTick();
+    void cancelSoftSeek();
+    bool softSeek(uint8_t up_down, uint8_t wrap = 1, void (*showFunc)(uint16_t f) = NULL, const si47x_seek_criteria *criteria = NULL);
+
+    /**
+     * @ingroup group32 Software seek
+     * @brief Sets the criteria used by the software seek to accept a channel.
+     * @details The criteria are kept in the state (startSoftSeek does not clear them). Without this call, the seek
+     *          uses SI473X_SOFT_SEEK_RSSI and SI473X_SOFT_SEEK_SNR.
+     * @param state software seek state declared by the sketch
+     * @param rssi minimum RSSI (dBuV)
+     * @param snr minimum SNR (dB)
+     * @param multipath maximum multipath (FM only; 0 = not checked)
+     * @param rdsSync 1 = the station has to get the RDS sync within rdsTimeout ms (FM only; RDS must be configured, see setRdsConfig)
+     * @param rdsTimeout maximum time (ms) to wait for the RDS sync
+     */
+    inline void setSoftSeekCriteria(si47x_soft_seek_state *state, uint8_t rssi, uint8_t snr, uint8_t multipath = 0, uint8_t rdsSync = 0, uint16_t rdsTimeout = 500)
+    {
+        state->criteria.rssi = rssi;
+        state->criteria.snr = snr;
+        state->criteria.multipath = multipath;
+        state->criteria.rdsSync = rdsSync;
+        state->criteria.rdsTimeout = rdsTimeout;
+    };
+
+    /**
+     * @ingroup group32 Software seek
+     * @brief Sets a function that makes the final decision on each channel that meets the criteria (NULL = none).
+     * @param state software seek state declared by the sketch
+     * @param filter your function or NULL
+     */
+    inline void setSoftSeekFilter(si47x_soft_seek_state *state, si47x_seek_filter filter) { state->filter = filter; };
+
+    /**
+     * @ingroup group32 Software seek
+     * @brief Sets the steps of the software seek (current band units).
+     * @details The coarse step is rounded to a multiple of the fine step.
+     * @param state software seek state declared by the sketch
+     * @param coarse step between the points checked first (0 = two fine steps on FM/NBFM; SI473X_SOFT_SEEK_AM_COARSE on AM/SSB)
+     * @param fine step used around a candidate (0 = the current step, see setFrequencyStep)
+     */
+    inline void setSoftSeekSteps(si47x_soft_seek_state *state, uint16_t coarse, uint16_t fine)
+    {
+        state->coarseStep = coarse;
+        state->fineStep = fine;
+    };
+
+    /**
+     * @ingroup group32 Software seek
+     * @brief Returns true while a software seek is in progress.
+     */
+    inline bool isSoftSeeking() { return softSeekState != NULL && softSeekState->state != SI473X_SOFT_SEEK_IDLE; };
+
+    /**
+     * @ingroup group32 Software seek
+     * @brief Returns true if the last software seek found a channel.
+     */
+    inline bool getSoftSeekFound() { return softSeekFound; };
+
+    /**
+     * @ingroup group32 Software seek
+     * @brief Returns the number of tunes done by the current (or last) software seek.
+     */
+    inline uint16_t getSoftSeekTunes() { return softSeekTunes; };
+
+    bool startAutostore(si47x_autostore_state *state, si47x_station *table, uint8_t size, uint16_t rdsTime = 0);
+    bool autostoreTick(uint16_t slice = SI473X_AUTOSTORE_SLICE);
+    void stopAutostore();
+    uint8_t autostore(si47x_station *table, uint8_t size, uint16_t rdsTime = 0);
+
+    /**
+     * @ingroup group33 Autostore
+     * @brief Returns true while a band scan is in progress (see startAutostore).
+     */
+    inline bool isAutostoring() { return autostoreState != NULL && autostoreState->state != SI473X_AUTOSTORE_IDLE; };
+
+    /**
+     * @ingroup group33 Autostore
+     * @brief Returns the number of stations stored by the current (or last) band scan.
+     */
+    inline uint8_t getAutostoreCount() { return autostoreCount; };
+
+    uint16_t findBestAntennaCapacitor(uint16_t freq, uint16_t span = 0);
+    uint8_t buildAntennaCapacitorTable(si47x_antcap_segment *table, uint8_t size, uint16_t from, uint16_t to, uint16_t span = 0);
+    void setAntennaCapacitorTable(si47x_antcap_segment *table, uint8_t size);
+    uint16_t lookupAntennaCapacitor(uint16_t freq);
+
+    bool setBandPlan(const si47x_band *plan, uint8_t size);
+    void getBand(uint8_t idx, si47x_band *band);
+    uint8_t findBand(uint16_t freq, bool fm = false);
+    bool setBand(uint8_t idx, uint16_t freq = 0);
+    uint8_t tuneBand(uint16_t freq, bool fm = false);
+
+    /**
+     * @ingroup group35 Band plan
+     * @brief Returns the band selected by setBand or tuneBand (SI473X_BAND_NONE if the mode was changed by other functions).
+     */
+    inline uint8_t getCurrentBand() { return currentBandIdx; };
+
+    /**
+     * @ingroup group35 Band plan
+     * @brief Returns the number of bands of the band plan.
+     */
+    inline uint8_t getBandPlanSize() { return bandPlanSize; };
+
+    /**
+     * @ingroup group36 Mode switch
+     * @brief Returns the time (us) spent by the last setFM or setAM call (power cycle and restore included).
+     */
+    inline uint32_t getModeSwitchTime() { return modeSwitchTime; };
+
+    /**
+     * @ingroup group36 Mode switch
+     * @brief Returns the number of properties kept for a mode and restored after its next power up.
+     * @param mode FM_CURRENT_MODE, AM_CURRENT_MODE or SSB_CURRENT_MODE
+     */
+    uint8_t getModeStateCount(uint8_t mode);
+
+    void clearModeState();
+
+    /**
+     * @ingroup group36 Mode switch
+     * @brief Sets the array where the properties of the FM, AM and SSB modes are kept (see Mode switch).
+     * @details Without an array (the default), nothing is restored after a power up. The AGC override of each mode takes
+     *          one entry. The properties kept before are forgotten.
+     * @param entries array of entries (it has to be valid while it is in use) or NULL
+     * @param size number of entries of the array (12 holds the settings of a typical receiver)
+     */
+    inline void setModeState(si47x_property_cache_entry *entries, uint8_t size)
+    {
+        modeState = entries;
+        modeStateSize = (entries != NULL) ? size : 0;
+        modeStateCount = 0;
+    };
+
+    void setFrequencyHz(uint32_t frequency);
+    uint32_t getFrequencyHz();
+
+    /**
+     * @ingroup group37 Hz tuning
+     * @brief Returns the SSB offset (Hz) from the carrier (currentFrequency). The received frequency is carrier x 1000 + offset.
+     */
+    inline int16_t getBfoOffset() { return bfoOffset; };
+
+    /**
+     * @ingroup group37 Hz tuning
+     * @brief Sets the largest BFO offset (Hz) used by setFrequencyHz before tuning the carrier again.
+     * @details Smaller windows keep the carrier closer to the received frequency; larger ones need fewer TUNE_FREQ commands.
+     * @param hz 500 to 16383 (default SI473X_BFO_WINDOW)
+     */
+    inline void setBfoWindow(uint16_t hz) { bfoWindow = (hz < 500) ? 500 : (hz > 16383) ? 16383 : hz; };
+
+    void startPriorityWatch(si47x_priority_state *state, uint16_t frequency, uint16_t period = SI473X_PRIORITY_PERIOD, void (*onSwitch)(uint16_t) = NULL);
+    bool priorityTick();
+    void stopPriorityWatch();
+
+    /**
+     * @ingroup group38 Priority channel
+     * @brief Sets the signal the priority channel needs to take the receiver (default SI473X_PRIORITY_RSSI and SI473X_PRIORITY_SNR).
+     * @details While on the priority channel, the receiver goes back when the signal falls below these values.
+     * @details The criteria are kept in the state (startPriorityWatch does not clear them). They can be changed while watching.
+     * @param state watch state declared by the sketch
+     * @param rssi minimum RSSI (dBuV)
+     * @param snr minimum SNR (dB)
+     */
+    inline void setPriorityCriteria(si47x_priority_state *state, uint8_t rssi, uint8_t snr)
+    {
+        state->rssi = rssi;
+        state->snr = snr;
+    };
+
+    /**
+     * @ingroup group38 Priority channel
+     * @brief Returns true if the priority channel is being watched (see startPriorityWatch).
+     */
+    inline bool isPriorityWatching() { return priorityState != NULL; };
+
+    /**
+     * @ingroup group38 Priority channel
+     * @brief Returns true while the receiver stays on the priority channel (its signal meets the criteria).
+     */
+    inline bool isOnPriority() { return priorityState != NULL && priorityState->active; };
+
+    /**
+     * @ingroup group38 Priority channel
+     * @brief Returns the audio gap (us) of the last check: from the mute to the end of the tune back.
+     */
+    inline uint32_t getPriorityGap() { return (priorityState != NULL) ? priorityState->gap : 0; };
+
+    bool startScan(si47x_scan_state *state, const si47x_memory_channel *channels, uint8_t size, void (*onStop)(uint8_t idx) = NULL);
+    bool scanTick();
+    void resumeScan();
+    void stopScan();
+    void setScanLockout(uint8_t idx, bool locked);
+    bool isScanLocked(uint8_t idx);
+    uint16_t getScanRate();
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Sets how long the scan stays on an active channel (default: while active; SI473X_SCAN_HANG_TIME).
+     * @details The times are kept in the state (startScan does not clear them). They can be changed while scanning.
+     * @param state scan state declared by the sketch
+     * @param dwell largest time (ms) on the channel while its signal holds (0 = until the signal is gone or resumeScan)
+     * @param hang time (ms) the scan waits after the signal is gone (a reply usually comes back within it)
+     */
+    inline void setScanTimes(si47x_scan_state *state, uint16_t dwell, uint16_t hang)
+    {
+        state->dwell = dwell;
+        state->hang = hang;
+        state->timesSet = true;
+    };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Sets the signal (RSQ_STATUS) an active channel needs (default SI473X_SCAN_RSSI and SI473X_SCAN_SNR).
+     * @details The criteria are kept in the state (startScan does not clear them).
+     * @param state scan state declared by the sketch
+     * @param rssi minimum RSSI (dBuV)
+     * @param snr minimum SNR (dB)
+     */
+    inline void setScanCriteria(si47x_scan_state *state, uint8_t rssi, uint8_t snr)
+    {
+        state->rssi = rssi;
+        state->snr = snr;
+    };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Sets the function that loads the SSB patch (loadPatch or loadCompressedPatch) before the LSB/USB channels.
+     * @details Without it, the LSB and USB channels are scanned just while the device keeps the patch (scan started on SSB).
+     */
+    inline void setScanSsbLoader(void (*loader)()) { scanSsbLoader = loader; };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Unlocks all channels (see setScanLockout).
+     */
+    inline void clearScanLockout()
+    {
+        if (scanState != NULL)
+            memset(scanState->lockout, 0, sizeof(scanState->lockout));
+    };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Returns true while the memory scan runs (see startScan).
+     */
+    inline bool isScanning() { return scanState != NULL && scanState->state != SI473X_SCAN_IDLE; };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Returns true while the scan stays on an active channel (dwell or hang).
+     */
+    inline bool isScanStopped() { return scanState != NULL && (scanState->state == SI473X_SCAN_DWELL || scanState->state == SI473X_SCAN_HANG); };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Returns the index of the channel tuned by the scan.
+     */
+    inline uint8_t getScanChannel() { return (scanState != NULL) ? scanState->idx : 0; };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Returns the number of channels checked since startScan.
+     */
+    inline uint16_t getScanCount() { return (scanState != NULL) ? scanState->count : 0; };
+
+    /**
+     * @ingroup group39 Memory scan
+     * @brief Returns the number of mode switches (power ups) done since startScan.
+     */
+    inline uint8_t getScanSwitches() { return (scanState != NULL) ? scanState->switches : 0; };
+
+    si47x_signal_snapshot getSignalSnapshot(bool refresh = false);
+    void setSnapshotCache(si47x_snapshot_cache *cache);
+
+    /**
+     * @ingroup group40 Signal snapshot
+     * @brief Sets how old (ms) a snapshot can be and still be served from the cache (0 = always read the device).
+     */
+    inline void setSnapshotTtl(uint16_t ttl) { snapshotTtl = ttl; };
+
+    /**
+     * @ingroup group40 Signal snapshot
+     * @brief Drops the cached snapshot: the next getSignalSnapshot reads the device.
+     */
+    inline void invalidateSignalSnapshot()
+    {
+        if (snapshotCache != NULL)
+            snapshotCache->valid = false;
+    };
+
+    /**
+     * @ingroup group40 Signal snapshot
+     * @brief Returns the number of snapshots read from the device (see getSnapshotHits).
+     */
+    inline uint32_t getSnapshotReads() { return (snapshotCache != NULL) ? snapshotCache->reads : 0; };
+
+    /**
+     * @ingroup group40 Signal snapshot
+     * @brief Returns the number of snapshots served from the cache (no I2C transaction).
+     */
+    inline uint32_t getSnapshotHits() { return (snapshotCache != NULL) ? snapshotCache->hits : 0; };
+
+    void setRsqInterrupts(uint8_t sources);
+    void setRsqRssiThreshold(uint8_t low, uint8_t high);
+    void setRsqSnrThreshold(uint8_t low, uint8_t high);
+    void startSignalMonitor(si47x_signal_monitor_state *state, uint8_t rssiWindow = SI473X_RSQ_WINDOW, uint8_t snrWindow = SI473X_RSQ_WINDOW, void (*onChange)(uint8_t rssi, uint8_t snr) = NULL);
+    bool signalMonitorTick();
+    void stopSignalMonitor();
+
+    /**
+     * @ingroup group41 Signal monitor
+     * @brief Returns true while the signal monitor runs (see startSignalMonitor).
+     */
+    inline bool isSignalMonitoring() { return rsqState != NULL; };
+
+    /**
+     * @ingroup group41 Signal monitor
+     * @brief Returns the number of signal changes (RSQ interrupts) handled since startSignalMonitor.
+     */
+    inline uint16_t getSignalMonitorEvents() { return (rsqState != NULL) ? rsqState->events : 0; };
+
+    void startMeter(si47x_meter_state *state);
+    void meterSample(uint8_t rssi, uint8_t snr);
+    bool meterTick();
+    void resetMeter();
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Stops the S-meter: the state declared by the sketch is no longer used (see startMeter).
+     */
+    inline void stopMeter() { meterState = NULL; };
+    void setMeterCalibration(uint8_t mode, int8_t offset);
+    uint8_t getMeterPeak();
+    int16_t rssiToDbm(uint8_t rssi);
+    uint8_t dbmToSUnit(int16_t dbm, uint8_t *over = NULL);
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Sets the smoothing of the S-meter: each sample moves the average by 1/2^shift of the difference (0 to 6; 0 = no smoothing).
+     * @details Call it after startMeter (the setting is kept in the meter state).
+     */
+    inline void setMeterSmoothing(uint8_t shift)
+    {
+        if (meterState != NULL)
+            meterState->shift = (shift > 6) ? 6 : shift;
+    };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Sets the peak hold time (ms) and the decay after it (dB per second; 0 = the peak is held until a higher one).
+     * @details Call it after startMeter (the setting is kept in the meter state).
+     */
+    inline void setMeterPeak(uint16_t hold, uint8_t decay)
+    {
+        if (meterState == NULL)
+            return;
+        meterState->peakHold = hold;
+        meterState->peakDecay = decay;
+    };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Sets the interval (ms) between two samples taken by meterTick and the length (ms) of the statistics windows.
+     * @details Call it after startMeter (the setting is kept in the meter state).
+     */
+    inline void setMeterTimes(uint16_t period, uint16_t window)
+    {
+        if (meterState == NULL)
+            return;
+        meterState->period = period;
+        meterState->window = (window == 0) ? 1 : window;
+    };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Returns the smoothed RSSI (dBuV).
+     */
+    inline uint8_t getMeterRssi() { return (meterState != NULL) ? (uint8_t)((meterState->rssi + 8) >> 4) : 0; };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Returns the smoothed SNR (dB).
+     */
+    inline uint8_t getMeterSnr() { return (meterState != NULL) ? (uint8_t)((meterState->snr + 8) >> 4) : 0; };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Returns the smoothed signal level (dBm) with the calibration of the current mode.
+     */
+    inline int16_t getMeterDbm() { return rssiToDbm(getMeterRssi()); };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Returns the smoothed signal in S-units (0 to 9) and, in over, the dB above S9.
+     */
+    inline uint8_t getSMeter(uint8_t *over = NULL) { return dbmToSUnit(getMeterDbm(), over); };
+
+    /**
+     * @ingroup group42 S-meter
+     * @brief Returns the minimum, maximum and mean of the last closed window (samples = 0 before the first one).
+     */
+    inline si47x_signal_stats getSignalStats() { return (meterState != NULL) ? meterState->stats : si47x_signal_stats(); };
+
+    /**
+     * @ingroup group35 Band plan
+     * @brief Checks one band: mode, limits, default frequency, step and bandwidth index (see isValidBandPlan).
+     */
+    static constexpr bool isValidBand(const si47x_band &band)
+    {
+        return band.mode <= SI473X_BAND_USB && band.minimumFrequency < band.maximumFrequency &&
+               band.defaultFrequency >= band.minimumFrequency && band.defaultFrequency <= band.maximumFrequency &&
+               band.step > 0 && band.bandwidthIdx <= ((band.mode == SI473X_BAND_FM) ? 4 : (band.mode == SI473X_BAND_AM) ? 6 : 5);
+    }
+
+    /**
+     * @ingroup group35 Band plan
+     * @brief Checks a band plan: valid bands, the AM/SSB bands before the FM bands, sorted by frequency and not overlapping.
+     * @details constexpr: use it with static_assert to check the plan at compile time.
+     * @code
+     * constexpr si47x_band plan[] PROGMEM = { ... };
+     * static_assert(SI4735::isValidBandPlan(plan, sizeof(plan) / sizeof(si47x_band)), "invalid band plan");
+     * @endcode
+     */
+    static constexpr bool isValidBandPlan(const si47x_band *plan, uint8_t size)
+    {
+        return size == 0 ||
+               (isValidBand(plan[0]) &&
+                (size == 1 || bandKey(plan[0].mode, plan[0].maximumFrequency) <= bandKey(plan[1].mode, plan[1].minimumFrequency)) &&
+                isValidBandPlan(plan + 1, size - 1));
+    }
+
     // AM Seek property configurations
     void setSeekAmLimits(uint16_t bottom, uint16_t top);
     void setSeekAmSpacing(uint16_t spacing);
@@ -2704,10 +4594,11 @@ public:
      * @brief Set the Max Delay after Set Frequency
      *
      * @details After the set frequency command, the system need a time to get ready to the next set frequency (default value 30ms).
-     * @details Why the waitToSend() does not work in this case? No idea for while!
+     * @details Why the waitToSend() does not work in this case? The CTS bit is set before the tune is complete.
+     * @details Now the library waits for the Seek/Tune Complete (STC) bit. This delay is used only if the STC does not come in time.
      * @details A low value makes the getFrequency command inaccurate.
      *
-     * @see  MAX_DELAY_AFTER_POWERUP
+     * @see  MAX_DELAY_AFTER_POWERUP, setCommandTiming
      * @param ms
      */
     inline void setMaxDelaySetFrequency(uint16_t ms)
@@ -2788,7 +4679,7 @@ public:
      */
     inline void setI2CLowSpeedMode(void)
     {
-        Wire.setClock(10000);
+        setBusClock(10000);
     };
 
     /**
@@ -2796,7 +4687,7 @@ public:
      *
      * @brief Sets I2C bus to 100kHz
      */
-    inline void setI2CStandardMode(void) { Wire.setClock(100000); };
+    inline void setI2CStandardMode(void) { setBusClock(100000); };
 
     /**
      * @ingroup group18 MCU I2C Speed
@@ -2805,7 +4696,7 @@ public:
      */
     inline void setI2CFastMode(void)
     {
-        Wire.setClock(400000);
+        setBusClock(400000);
     };
 
     /**
@@ -2816,7 +4707,55 @@ public:
      *
      * @param value in Hz. For example: The values 500000 sets the bus to 500kHz.
      */
-    inline void setI2CFastModeCustom(long value = 500000) { Wire.setClock(value); };
+    inline void setI2CFastModeCustom(long value = 500000) { setBusClock(value); };
+
+    /**
+     * @ingroup group18 MCU I2C Speed
+     *
+     * @brief Sets the I2C clock and the bus turnaround time used by the combined write-then-read (see setCombinedWriteRead).
+     *
+     * @param frequency in Hz
+     */
+    inline void setBusClock(uint32_t frequency)
+    {
+#ifdef SI473X_TRANSPORT
+        transport->setClock(frequency);
+#else
+        Wire.setClock(frequency);
+#endif
+        busTurnaround = 10000000UL / frequency; // 10 bit times (repeated start and address byte)
+    };
+
+#ifdef SI473X_TRANSPORT
+    /**
+     * @ingroup group25 I2C transport
+     *
+     * @brief Sets the I2C transport used to talk to the SI47XX device.
+     * @details Call it before setup. Use NULL to go back to the default transport (Wire).
+     * @details Not available without SI473X_TRANSPORT (AVR default; see SI4735.h).
+     *
+     * @see SI4735Transport, setI2CBus
+     * @param transport your transport implementation
+     */
+    inline void setTransport(SI4735Transport *transport) { this->transport = (transport != NULL) ? transport : &wireTransport; };
+
+    /**
+     * @ingroup group25 I2C transport
+     *
+     * @brief Sets the I2C bus used by the default transport.
+     * @details Use it on boards with more than one I2C bus. Call it before setup.
+     * @code
+     *   rx.setI2CBus(&Wire1);
+     *   rx.setup(RESET_PIN, FM_FUNCTION);
+     * @endcode
+     * @param wire I2C bus (Wire, Wire1 etc)
+     */
+    inline void setI2CBus(TwoWire *wire)
+    {
+        wireTransport.wire = wire;
+        transport = &wireTransport;
+    };
+#endif
 
     /**
      * @ingroup group18 MCU External Audio Mute
@@ -2850,6 +4789,7 @@ public:
     inline void setHardwareAudioMute(bool on)
     {
         digitalWrite(audioMuteMcuPin, on);
+        hardwareMuted = on;
         delayMicroseconds(300);
     }
 